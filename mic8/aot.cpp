@@ -0,0 +1,32 @@
+#include "aot.hpp"
+#include "movie.hpp"
+
+#include <dlfcn.h>
+
+#include <filesystem>
+#include <format>
+#include <stdexcept>
+
+aot_module::aot_module(const std::string &path) {
+    handle = dlopen(path.c_str(), RTLD_NOW | RTLD_LOCAL);
+    if (handle == nullptr) { throw std::invalid_argument(std::format("Failed to load {}: {}", path, dlerror())); }
+    info = static_cast<const aot_info *>(dlsym(handle, "mic8_aot_info"));
+    if (info == nullptr || info->abi != aot_info::ABI) {
+        dlclose(handle);
+        throw std::invalid_argument(std::format("{} was not compiled for this build, regenerate it!", path));
+    }
+}
+
+aot_module::~aot_module() { dlclose(handle); }
+
+auto aot_module::find(const std::string &dir, const std::string_view rom, const chip8::alt_t &alt_ops)
+    -> std::shared_ptr<const aot_module> {
+    const auto rom_hash = movie::hash_rom(rom);
+    const auto path = std::filesystem::path(dir) / file_name(rom_hash, alt_ops);
+    if (!std::filesystem::exists(path)) { return nullptr; }
+    auto module = std::make_shared<const aot_module>(path.string());
+    if (module->get_info().rom_hash != rom_hash || module->get_info().alt_ops != pack_alt_ops(alt_ops)) {
+        throw std::invalid_argument(std::format("{} was compiled from another ROM or quirk set!", path.string()));
+    }
+    return module;
+}
@@ -0,0 +1,130 @@
+#pragma once
+
+#include "chip8.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <format>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+
+// Compiled ROMs are shared objects generated by mic8_aot.elf and built against this header. They reach the
+// interpreter state through aot_access only, so they need no symbols from the host.
+struct aot_access {
+    static auto reg(chip8 &c) -> std::array<std::uint8_t, chip8::REG_COUNT> & { return c.reg; }
+    static auto stack(chip8 &c) -> std::array<std::uint16_t, chip8::STACK_SIZE> & { return c.stack; }
+    static auto pc(chip8 &c) -> std::uint16_t & { return c.pc; }
+    static auto ir(chip8 &c) -> std::uint16_t & { return c.ir; }
+    static auto sp(chip8 &c) -> std::uint8_t & { return c.sp; }
+    static auto dt(chip8 &c) -> std::uint8_t & { return c.dt; }
+    static auto st(chip8 &c) -> std::uint8_t & { return c.st; }
+};
+
+// the variant and quirks in one byte: vip_alu, chip48_jmp, chip48_shf, then 2 bits of ls_mode and 2 of variant.
+// The low 5 bits are the harness' quirk combo.
+constexpr auto pack_alt_ops(const chip8::alt_t &alt_ops) -> std::uint8_t {
+    return static_cast<std::uint8_t>(alt_ops.vip_alu | alt_ops.chip48_jmp << 1u | alt_ops.chip48_shf << 2u |
+                                     static_cast<unsigned>(alt_ops.ls_mode) << 3u |
+                                     static_cast<unsigned>(alt_ops.variant) << 5u);
+}
+
+// exported by every compiled ROM as mic8_aot_info
+struct aot_info {
+    // bumped whenever the generated code or this layout changes, a module built for another ABI is refused
+    static constexpr std::uint32_t ABI{2u << 16u | sizeof(chip8)};
+
+    std::uint32_t abi;
+    std::uint64_t rom_hash;
+    std::uint8_t alt_ops;
+    // one byte per address of memory, set where the compiled code depends on its contents
+    const std::uint8_t *code;
+    std::size_t code_size;
+    // runs from the current pc until budget cycles are spent or pc reaches an instruction left to the interpreter,
+    // returns the cycles executed
+    std::uint64_t (*run)(chip8 &c, std::uint64_t budget);
+};
+
+class aot_module {
+public:
+    // throws if the file is not a module for this build
+    explicit aot_module(const std::string &path);
+
+    ~aot_module();
+
+    aot_module(const aot_module &) = delete;
+
+    auto operator=(const aot_module &) -> aot_module & = delete;
+
+    // <ROM hash>-<packed alt_ops>.so, shared with mic8_aot.elf
+    static auto file_name(const std::uint64_t rom_hash, const chip8::alt_t &alt_ops) -> std::string {
+        return std::format("{:016x}-{:02x}.so", rom_hash, pack_alt_ops(alt_ops));
+    }
+
+    // the module compiled for the ROM and quirks in dir, or nullptr if there is none
+    static auto find(const std::string &dir, std::string_view rom, const chip8::alt_t &alt_ops)
+        -> std::shared_ptr<const aot_module>;
+
+    [[nodiscard]] auto get_info() const -> const aot_info & { return *info; }
+
+private:
+    void *handle{};
+    const aot_info *info{};
+};
+
+// chip8::run_cycles through a compiled module, minus breakpoints. Everything the module does not compile runs on the
+// interpreter one instruction at a time, and once an instruction writes into compiled code the instance stays on
+// the interpreter for good.
+class aot_runner {
+public:
+    explicit aot_runner(std::shared_ptr<const aot_module> module) : module(std::move(module)) {}
+
+    auto run_cycles(chip8 &interpreter, const std::uint64_t budget, const bool stop_on_draw = false)
+        -> chip8::run_result {
+        const auto &info = module->get_info();
+        std::uint64_t done = 0;
+        while (done < budget) {
+            if (!invalidated) {
+                done += info.run(interpreter, budget - done);
+                if (done == budget) { break; }
+                invalidated = writes_code(interpreter);
+            }
+            const auto [reason, cycles] = interpreter.run_cycles(invalidated ? budget - done : 1, stop_on_draw);
+            done += cycles;
+            if (reason != chip8::stop_reason::budget) { return {reason, done}; }
+        }
+        return {chip8::stop_reason::budget, done};
+    }
+
+    [[nodiscard]] constexpr auto get_invalidated() const -> bool { return invalidated; }
+
+private:
+    std::shared_ptr<const aot_module> module;
+    bool invalidated{};
+
+    // whether the instruction at pc stores into memory the compiled code was built from
+    [[nodiscard]] auto writes_code(const chip8 &interpreter) const -> bool {
+        const auto &info = module->get_info();
+        const auto mem = interpreter.get_mem();
+        const auto mask = mem.size() - 1;
+        const auto pc = interpreter.get_pc();
+        const unsigned op = mem[pc & mask] << 8u | mem[(pc + 1u) & mask];
+        const unsigned x = op >> 8u & 0xFu;
+        const unsigned y = op >> 4u & 0xFu;
+        std::size_t count = 0;
+        if ((op & 0xF0FFu) == 0xF033u) {
+            count = 3;
+        } else if ((op & 0xF0FFu) == 0xF055u) {
+            count = x + 1;
+        } else if ((op & 0xF00Fu) == 0x5002u && info.alt_ops >> 5u == static_cast<unsigned>(chip8::variant::xochip)) {
+            count = (x > y ? x - y : y - x) + 1;
+        }
+        for (std::size_t i = 0; i < count; ++i) {
+            const auto addr = (interpreter.get_ir() + i) & mask;
+            if (addr < info.code_size && info.code[addr] != 0) { return true; }
+        }
+        return false;
+    }
+};
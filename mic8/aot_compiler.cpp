@@ -0,0 +1,326 @@
+#include "aot.hpp"
+#include "chip8.hpp"
+#include "headless.hpp"
+#include "movie.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+    struct options {
+        std::string out{"aot"};
+        std::optional<chip8::variant> variant;
+        std::optional<std::size_t> combo;
+        bool all{};
+        std::vector<std::string> paths;
+    };
+
+    auto parse_options(const std::span<char *> args) -> options {
+        options opts;
+        for (std::size_t i = 1; i < args.size(); ++i) {
+            const std::string_view arg = args[i];
+            const auto value = [&] {
+                if (i + 1 >= args.size()) { throw std::invalid_argument(std::format("Missing value for {}", arg)); }
+                return std::string_view(args[++i]);
+            };
+            if (arg == "--out") {
+                opts.out = value();
+            } else if (arg == "--variant") {
+                opts.variant = headless::parse_variant(value());
+            } else if (arg == "--combo") {
+                opts.combo = headless::parse_number(value());
+                if (*opts.combo >= headless::QUIRK_COMBOS) { throw std::invalid_argument("Unknown quirk combo!"); }
+            } else if (arg == "--all") {
+                opts.all = true;
+            } else if (arg.starts_with("--")) {
+                throw std::invalid_argument(std::format("Unknown option: {}", arg));
+            } else {
+                opts.paths.emplace_back(arg);
+            }
+        }
+        return opts;
+    }
+
+    // Translates the code reachable from ROM_ADDR into one function. Each instruction becomes a labelled block that
+    // checks the budget, does the work on local copies of V and I, and jumps straight to its successor; returns
+    // dispatch on pc through a switch. Whatever needs the rest of the interpreter (drawing, randomness, key waits,
+    // memory stores, computed jumps, halting) is left to it: its block writes pc back and leaves.
+    class compiler {
+    public:
+        compiler(std::span<const std::uint8_t> mem, const chip8::alt_t &alt_ops) :
+            mem(mem), alt_ops(alt_ops), xochip(alt_ops.variant == chip8::variant::xochip),
+            reached(mem.size()), code(mem.size()) {}
+
+        auto compile(const std::string_view rom, const std::uint64_t rom_hash) -> std::string {
+            std::vector<std::size_t> work{chip8::ROM_ADDR};
+            while (!work.empty()) {
+                const auto addr = work.back();
+                work.pop_back();
+                if (addr >= mem.size() || reached[addr]) { continue; }
+                reached[addr] = true;
+                for (const auto next: successors(addr)) { work.push_back(next); }
+            }
+
+            std::string body;
+            std::string cases;
+            for (std::size_t addr = 0; addr < mem.size(); ++addr) {
+                if (!reached[addr]) { continue; }
+                cases += std::format("            case 0x{:X}: goto a{:X};\n", addr, addr);
+                body += std::format("    a{:X}: // {:04X}\n{}", addr, op_at(addr), translate(addr));
+            }
+
+            std::size_t code_size = 0;
+            std::string code_bytes;
+            for (std::size_t addr = 0; addr < mem.size(); ++addr) {
+                if (code[addr]) { code_size = addr + 1; }
+            }
+            for (std::size_t addr = 0; addr < code_size; ++addr) {
+                code_bytes += code[addr] ? "1," : "0,";
+                if (addr % 64 == 63) { code_bytes += '\n'; }
+            }
+
+            return std::format(R"(// generated by mic8_aot.elf from {}, do not edit
+#include "aot.hpp"
+
+#include <array>
+#include <cstdint>
+
+namespace {{
+    constexpr std::uint8_t code[]{{
+{}0}};
+
+    auto run(chip8 &c, const std::uint64_t budget) -> std::uint64_t {{
+        auto &reg = aot_access::reg(c);
+        auto &stack = aot_access::stack(c);
+        auto &pc = aot_access::pc(c);
+        auto &sp = aot_access::sp(c);
+        auto &dt = aot_access::dt(c);
+        auto &st = aot_access::st(c);
+        std::array<std::uint8_t, chip8::REG_COUNT> v = reg;
+        std::uint16_t i = aot_access::ir(c);
+        std::uint64_t n = 0;
+    dispatch:
+        switch (pc) {{
+{}            default: goto exit;
+        }}
+{}    exit:
+        reg = v;
+        aot_access::ir(c) = i;
+        return n;
+    }}
+}}
+
+extern "C" const aot_info mic8_aot_info{{aot_info::ABI, 0x{:016X}, 0x{:02X}, code, {}, run}};
+)", rom, code_bytes, cases, body, rom_hash, pack_alt_ops(alt_ops), code_size);
+        }
+
+    private:
+        std::span<const std::uint8_t> mem;
+        chip8::alt_t alt_ops;
+        bool xochip;
+        std::vector<bool> reached;
+        std::vector<bool> code;
+
+        [[nodiscard]] auto byte_at(const std::size_t addr) const -> unsigned { return mem[addr & (mem.size() - 1)]; }
+
+        [[nodiscard]] auto op_at(const std::size_t addr) const -> unsigned {
+            return byte_at(addr) << 8u | byte_at(addr + 1);
+        }
+
+        // where a taken skip lands, seen from the instruction at addr
+        [[nodiscard]] auto skip_target(const std::size_t addr) const -> std::size_t {
+            return addr + (xochip && op_at(addr + 2) == 0xF000u ? 6 : 4);
+        }
+
+        [[nodiscard]] auto is_skip(const unsigned op) const -> bool {
+            switch (op >> 12u) {
+                case 0x3: case 0x4: case 0x9: return true;
+                case 0x5: return !xochip || (op & 0xFu) == 0;
+                // the interpreter picks Ex9E and ExA1 by the low nibble alone
+                case 0xE: return (op & 0xFu) == 0xE || (op & 0xFu) == 0x1;
+                default: return false;
+            }
+        }
+
+        [[nodiscard]] auto successors(const std::size_t addr) const -> std::vector<std::size_t> {
+            const auto op = op_at(addr);
+            const auto nnn = op & 0x0FFFu;
+            if (op >> 12u == 0x0 && ((op & 0xFFu) == 0x00 || (op & 0xFFu) == 0xEE || (op & 0xFFu) == 0xFD)) {
+                return {};
+            }
+            if (op >> 12u == 0x1) { return {nnn}; }
+            if (op >> 12u == 0x2) { return {nnn, addr + 2}; }
+            if (op >> 12u == 0xB) { return {}; }
+            if (is_skip(op)) { return {addr + 2, skip_target(addr)}; }
+            if (xochip && op == 0xF000u) { return {addr + 4}; }
+            return {addr + 2};
+        }
+
+        [[nodiscard]] auto jump(const std::size_t target) const -> std::string {
+            if (target < mem.size() && reached[target]) { return std::format("goto a{:X};", target); }
+            return std::format("pc = 0x{:X}; goto exit;", target);
+        }
+
+        // the statement an instruction compiles to, or nothing if it is left to the interpreter
+        [[nodiscard]] auto statement(const std::size_t addr) const -> std::optional<std::string> {
+            const auto op = op_at(addr);
+            const auto x = op >> 8u & 0xFu;
+            const auto y = op >> 4u & 0xFu;
+            const auto nn = op & 0xFFu;
+            const auto nnn = op & 0xFFFu;
+            const auto next = jump(addr + 2);
+            const auto skip = [&](const std::string &condition) {
+                return std::format("if ({}) {{ {} }} {}", condition, jump(skip_target(addr)), next);
+            };
+            const auto vip = alt_ops.vip_alu ? " v[0xF] = 0;" : "";
+
+            switch (op >> 12u) {
+                case 0x0:
+                    if (nn != 0xEE) { return std::nullopt; }
+                    return "sp = (sp - 1u) & (chip8::STACK_SIZE - 1); pc = stack[sp]; goto dispatch;";
+                case 0x1:
+                    // the interpreter halts on a jump to the instruction after the jump
+                    if (nnn == addr + 2) { return std::nullopt; }
+                    return jump(nnn);
+                case 0x2:
+                    return std::format("stack[sp] = 0x{:X}; sp = (sp + 1u) & (chip8::STACK_SIZE - 1); {}", addr + 2,
+                                       jump(nnn));
+                case 0x3: return skip(std::format("v[0x{:X}] == 0x{:X}", x, nn));
+                case 0x4: return skip(std::format("v[0x{:X}] != 0x{:X}", x, nn));
+                case 0x5:
+                    if (xochip && (op & 0xFu) != 0) { return std::nullopt; }
+                    return skip(std::format("v[0x{:X}] == v[0x{:X}]", x, y));
+                case 0x6: return std::format("v[0x{:X}] = 0x{:X}; {}", x, nn, next);
+                case 0x7: return std::format("v[0x{:X}] += 0x{:X}; {}", x, nn, next);
+                case 0x8: return alu(op & 0xFu, x, y, vip).transform([&](const std::string &s) { return s + next; });
+                case 0x9: return skip(std::format("v[0x{:X}] != v[0x{:X}]", x, y));
+                case 0xA: return std::format("i = 0x{:X}; {}", nnn, next);
+                case 0xE: {
+                    const auto key = std::format("c.keys[v[0x{:X}] & (chip8::KEY_COUNT - 1)]", x);
+                    if ((op & 0xFu) == 0xE) { return skip(key); }
+                    if ((op & 0xFu) == 0x1) { return skip("!" + key); }
+                    return std::nullopt;
+                }
+                case 0xF:
+                    switch (nn) {
+                        case 0x00:
+                            if (!xochip || op != 0xF000u) { return std::nullopt; }
+                            return std::format("i = 0x{:X}; {}", op_at(addr + 2), jump(addr + 4));
+                        case 0x07: return std::format("v[0x{:X}] = dt; {}", x, next);
+                        case 0x15: return std::format("dt = v[0x{:X}]; {}", x, next);
+                        case 0x18: return std::format("st = v[0x{:X}]; {}", x, next);
+                        case 0x1E:
+                            return std::format("i += v[0x{:X}]; v[0xF] = i + v[0x{:X}] > 0xFF; {}", x, x, next);
+                        case 0x29: return std::format("i = chip8::FONTSET_ADDR + v[0x{:X}] * 5; {}", x, next);
+                        case 0x30:
+                            if (alt_ops.variant == chip8::variant::chip8) { return std::nullopt; }
+                            return std::format("i = chip8::BIG_FONTSET_ADDR + (v[0x{:X}] & 0xFu) * 10; {}", x, next);
+                        default: return std::nullopt;
+                    }
+                default: return std::nullopt;
+            }
+        }
+
+        // the same arithmetic as the interpreter's 8xyn ops, flag last
+        [[nodiscard]] auto alu(const unsigned n, const unsigned x, const unsigned y, const char *vip) const
+            -> std::optional<std::string> {
+            switch (n) {
+                case 0x0: return std::format("v[0x{:X}] = v[0x{:X}]; ", x, y);
+                case 0x1: return std::format("v[0x{:X}] |= v[0x{:X}];{} ", x, y, vip);
+                case 0x2: return std::format("v[0x{:X}] &= v[0x{:X}];{} ", x, y, vip);
+                case 0x3: return std::format("v[0x{:X}] ^= v[0x{:X}];{} ", x, y, vip);
+                case 0x4:
+                    return std::format("{{ const std::uint16_t res = v[0x{:X}] + v[0x{:X}]; v[0x{:X}] = res; "
+                                       "v[0xF] = res >> 8u; }} ", x, y, x);
+                case 0x5:
+                    return std::format("{{ const std::uint16_t res = v[0x{:X}] - v[0x{:X}]; v[0x{:X}] = res; "
+                                       "v[0xF] = res <= 0xFF; }} ", x, y, x);
+                case 0x6: {
+                    const auto src = alt_ops.chip48_shf ? x : y;
+                    return std::format("{{ const std::uint8_t car = v[0x{:X}] & 1u; v[0x{:X}] = v[0x{:X}] >> 1u; "
+                                       "v[0xF] = car; }} ", src, x, src);
+                }
+                case 0x7:
+                    return std::format("{{ const std::uint16_t res = v[0x{:X}] - v[0x{:X}]; v[0x{:X}] = res; "
+                                       "v[0xF] = res <= 0xFF; }} ", y, x, x);
+                case 0xE: {
+                    const auto src = alt_ops.chip48_shf ? x : y;
+                    return std::format("{{ const std::uint8_t car = v[0x{:X}] >> 7u; v[0x{:X}] = v[0x{:X}] << 1u; "
+                                       "v[0xF] = car; }} ", src, x, src);
+                }
+                default: return std::nullopt;
+            }
+        }
+
+        // compiled instructions count themselves against the budget and mark the bytes they were built from
+        auto translate(const std::size_t addr) -> std::string {
+            const auto compiled = statement(addr);
+            if (!compiled) { return std::format("        pc = 0x{:X}; goto exit;\n", addr); }
+            const auto op = op_at(addr);
+            auto last = addr + 1;
+            if (xochip && op == 0xF000u) { last = addr + 3; }
+            if (xochip && is_skip(op)) { last = addr + 3; }
+            for (auto byte = addr; byte <= last; ++byte) { code[byte & (mem.size() - 1)] = true; }
+            return std::format("        if (n == budget) {{ pc = 0x{:X}; goto exit; }}\n        ++n;\n        {}\n",
+                               addr, *compiled);
+        }
+    };
+
+    void compile_rom(const options &opts, const std::filesystem::path &rom, const chip8::alt_t &alt_ops) {
+        chip8 interpreter(alt_ops);
+        interpreter.load_rom(rom.string());
+        const auto rom_hash = movie::hash_rom(rom.string());
+        compiler c(interpreter.get_mem(), alt_ops);
+        const auto source = c.compile(rom.generic_string(), rom_hash);
+        auto path = std::filesystem::path(opts.out) / aot_module::file_name(rom_hash, alt_ops);
+        path.replace_extension(".cpp");
+        std::ofstream file(path);
+        if (!file || !(file << source)) { throw std::runtime_error(std::format("Failed to write {}!", path.string())); }
+        std::printf("%s -> %s\n", rom.generic_string().c_str(), path.generic_string().c_str());
+    }
+}
+
+// writes C++ for each ROM and quirk set, which make aot-modules builds into modules the harness and bench load
+auto main(int argc, char *argv[]) -> int {
+    try {
+        const auto opts = parse_options(std::span(argv, static_cast<std::size_t>(argc)));
+        if (opts.paths.empty()) {
+            std::fputs("usage: mic8_aot.elf [--out dir] [--variant chip8|schip|xochip] [--combo n | --all] "
+                       "rom|dir...\n", stderr);
+            return 2;
+        }
+        std::filesystem::create_directories(opts.out);
+        for (const auto &rom: headless::collect_roms(opts.paths)) {
+            const auto variant = opts.variant.value_or(headless::guess_variant(rom));
+            try {
+                if (opts.all) {
+                    for (std::size_t combo = 0; combo < headless::QUIRK_COMBOS; ++combo) {
+                        compile_rom(opts, rom, headless::make_alt_ops(combo, variant));
+                    }
+                } else if (opts.combo) {
+                    compile_rom(opts, rom, headless::make_alt_ops(*opts.combo, variant));
+                } else {
+                    chip8::alt_t alt_ops;
+                    alt_ops.variant = variant;
+                    compile_rom(opts, rom, alt_ops);
+                }
+            } catch (const std::invalid_argument &e) {
+                std::fprintf(stderr, "%s: %s\n", rom.generic_string().c_str(), e.what());
+            }
+        }
+        return 0;
+    } catch (const std::exception &e) {
+        std::fprintf(stderr, "%s\n", e.what());
+        return 2;
+    }
+}
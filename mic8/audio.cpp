@@ -0,0 +1,187 @@
+#include "audio.hpp"
+#include "chip8.hpp"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <ios>
+#include <stdexcept>
+#include <string_view>
+#include <thread>
+
+#ifdef MIC8_ALSA
+#include <alsa/asoundlib.h>
+#endif
+
+namespace {
+    // 8 bits on, 8 bits off: a 500 Hz square wave at the default pitch
+    constexpr std::array<std::uint8_t, chip8::PATTERN_SIZE> buzzer_pattern{
+            //@formatter:off
+        0xFF, 0x00, 0xFF, 0x00, 0xFF, 0x00, 0xFF, 0x00,
+        0xFF, 0x00, 0xFF, 0x00, 0xFF, 0x00, 0xFF, 0x00
+            //@formatter:on
+    };
+
+    constexpr std::size_t pattern_bits = chip8::PATTERN_SIZE * 8;
+
+    template<typename T>
+    void write_le(std::ofstream &file, const T value) {
+        for (std::size_t i = 0; i < sizeof(T); ++i) {
+            file.put(static_cast<char>(value >> i * 8 & 0xFF));
+        }
+    }
+
+    auto make_default_sink() -> std::unique_ptr<audio_sink> {
+        if (const char *path = std::getenv("MIC8_AUDIO_WAV"); path != nullptr) {
+            return std::make_unique<wav_sink>(path);
+        }
+#ifdef MIC8_ALSA
+        try {
+            return std::make_unique<alsa_sink>();
+        } catch (const std::runtime_error &) {}
+#endif
+        return std::make_unique<null_sink>();
+    }
+}
+
+void audio_voice::generate(const chip8 &interpreter, std::size_t count) {
+    // a tick's samples wait behind what is still queued from earlier ticks and then the device's buffer. A tick that
+    // would wait behind more than a mixer period is dropped, so the two together stay below a frame.
+    constexpr std::size_t max_ahead = audio_mixer::PERIOD;
+    static_assert(max_ahead + SAMPLE_RATE * audio_mixer::DEVICE_LATENCY.count() / 1'000'000 < FRAME_SAMPLES);
+    const auto queued = ring.size();
+    count = queued > max_ahead ? 0 : std::min(count, max_ahead + FRAME_SAMPLES - queued);
+
+    const auto pattern = std::ranges::all_of(interpreter.get_pattern(), [](const auto byte) { return byte == 0; })
+                             ? std::span<const std::uint8_t>(buzzer_pattern)
+                             : interpreter.get_pattern();
+    const double rate = 4000.0 * std::exp2((interpreter.get_pitch() - 64) / 48.0) / SAMPLE_RATE;
+    const bool audible = interpreter.get_st() > 0;
+
+    std::array<std::int16_t, audio_mixer::PERIOD> chunk{};
+    while (count > 0) {
+        const auto n = std::min(count, chunk.size());
+        for (std::size_t i = 0; i < n; ++i) {
+            if (!audible) {
+                chunk[i] = 0;
+                continue;
+            }
+            const auto bit = static_cast<std::size_t>(phase) % pattern_bits;
+            chunk[i] = (pattern[bit / 8] >> (7 - bit % 8) & 1u) != 0 ? AMPLITUDE : -AMPLITUDE;
+            phase = std::fmod(phase + rate, pattern_bits);
+        }
+        ring.push(std::span(chunk).first(n));
+        count -= n;
+    }
+}
+
+auto audio_voice::read(const std::span<std::int16_t> samples) -> std::size_t { return ring.pop(samples); }
+
+void null_sink::write(const std::span<const std::int16_t> samples) {
+    const auto now = std::chrono::steady_clock::now();
+    if (deadline < now) { deadline = now; }
+    deadline += std::chrono::nanoseconds(samples.size() * 1'000'000'000 / audio_voice::SAMPLE_RATE);
+    std::this_thread::sleep_until(deadline);
+}
+
+wav_sink::wav_sink(const std::string_view path) : file(path.data(), std::ios::binary) {
+    if (!file) {
+        throw std::invalid_argument("Failed to open the WAV file!");
+    }
+    file.write("RIFF", 4);
+    write_le<std::uint32_t>(file, 36);
+    file.write("WAVEfmt ", 8);
+    write_le<std::uint32_t>(file, 16);
+    write_le<std::uint16_t>(file, 1);
+    write_le<std::uint16_t>(file, 1);
+    write_le<std::uint32_t>(file, audio_voice::SAMPLE_RATE);
+    write_le<std::uint32_t>(file, audio_voice::SAMPLE_RATE * sizeof(std::int16_t));
+    write_le<std::uint16_t>(file, sizeof(std::int16_t));
+    write_le<std::uint16_t>(file, 16);
+    file.write("data", 4);
+    write_le<std::uint32_t>(file, 0);
+}
+
+wav_sink::~wav_sink() {
+    file.seekp(4);
+    write_le<std::uint32_t>(file, 36 + data_size);
+    file.seekp(40);
+    write_le<std::uint32_t>(file, data_size);
+}
+
+void wav_sink::write(const std::span<const std::int16_t> samples) {
+    for (const auto sample: samples) {
+        write_le(file, sample);
+    }
+    data_size += static_cast<std::uint32_t>(samples.size_bytes());
+    null_sink::write(samples);
+}
+
+#ifdef MIC8_ALSA
+alsa_sink::alsa_sink() {
+    if (snd_pcm_open(&pcm, "default", SND_PCM_STREAM_PLAYBACK, 0) < 0) {
+        throw std::runtime_error("Failed to open the audio device!");
+    }
+    // 1 channel, resampling allowed
+    if (snd_pcm_set_params(pcm, SND_PCM_FORMAT_S16_LE, SND_PCM_ACCESS_RW_INTERLEAVED, 1, audio_voice::SAMPLE_RATE, 1,
+                           static_cast<unsigned>(audio_mixer::DEVICE_LATENCY.count())) < 0) {
+        snd_pcm_close(pcm);
+        throw std::runtime_error("Failed to configure the audio device!");
+    }
+}
+
+alsa_sink::~alsa_sink() {
+    snd_pcm_drain(pcm);
+    snd_pcm_close(pcm);
+}
+
+void alsa_sink::write(const std::span<const std::int16_t> samples) {
+    auto remaining = samples;
+    while (!remaining.empty()) {
+        const auto written = snd_pcm_writei(pcm, remaining.data(), remaining.size());
+        if (written < 0) {
+            if (snd_pcm_recover(pcm, static_cast<int>(written), 1) < 0) { return; }
+            continue;
+        }
+        remaining = remaining.subspan(static_cast<std::size_t>(written));
+    }
+}
+#endif
+
+audio_mixer::audio_mixer(std::unique_ptr<audio_sink> sink) : sink(std::move(sink)),
+    worker([this](const std::stop_token &stop) { mix(stop); }) {}
+
+auto audio_mixer::global() -> audio_mixer & {
+    static audio_mixer mixer(make_default_sink());
+    return mixer;
+}
+
+void audio_mixer::add(const std::shared_ptr<audio_voice> &voice) {
+    const std::scoped_lock lock(voices_mutex);
+    voices.emplace_back(voice);
+}
+
+void audio_mixer::mix(const std::stop_token &stop) {
+    std::array<std::int16_t, PERIOD> voice_samples{};
+    std::array<std::int32_t, PERIOD> mixed{};
+    std::array<std::int16_t, PERIOD> output{};
+    while (!stop.stop_requested()) {
+        mixed.fill(0);
+        {
+            const std::scoped_lock lock(voices_mutex);
+            std::erase_if(voices, [](const auto &voice) { return voice.expired(); });
+            for (const auto &weak: voices) {
+                if (const auto voice = weak.lock()) {
+                    const auto n = voice->read(voice_samples);
+                    for (std::size_t i = 0; i < n; ++i) { mixed[i] += voice_samples[i]; }
+                }
+            }
+        }
+        std::ranges::transform(mixed, output.begin(), [](const auto sample) {
+            return static_cast<std::int16_t>(std::clamp<std::int32_t>(sample, INT16_MIN, INT16_MAX));
+        });
+        sink->write(output);
+    }
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#include "chip8.hpp"
+#include "spsc_ring.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+class audio_voice {
+public:
+    static constexpr std::size_t SAMPLE_RATE{44100};
+    static constexpr std::size_t FRAME_SAMPLES{SAMPLE_RATE / 60};
+    static constexpr std::int16_t AMPLITUDE{0x1000};
+
+    // called by the emulation side once per timer tick, never blocks
+    void generate(const chip8 &interpreter, std::size_t count);
+
+    // called by the mixer thread
+    auto read(std::span<std::int16_t> samples) -> std::size_t;
+
+private:
+    spsc_ring<std::int16_t, 0x800> ring;
+    double phase{};
+};
+
+class audio_sink {
+public:
+    virtual ~audio_sink() = default;
+
+    // blocks until the device (or its stand-in clock) has accepted the samples
+    virtual void write(std::span<const std::int16_t> samples) = 0;
+};
+
+class null_sink : public audio_sink {
+public:
+    void write(std::span<const std::int16_t> samples) override;
+
+private:
+    std::chrono::time_point<std::chrono::steady_clock> deadline{std::chrono::steady_clock::now()};
+};
+
+class wav_sink : public null_sink {
+public:
+    explicit wav_sink(std::string_view path);
+
+    ~wav_sink() override;
+
+    void write(std::span<const std::int16_t> samples) override;
+
+private:
+    std::ofstream file;
+    std::uint32_t data_size{};
+};
+
+#ifdef MIC8_ALSA
+class alsa_sink : public audio_sink {
+public:
+    alsa_sink();
+
+    ~alsa_sink() override;
+
+    void write(std::span<const std::int16_t> samples) override;
+
+private:
+    struct _snd_pcm *pcm{};
+};
+#endif
+
+class audio_mixer {
+public:
+    static constexpr std::size_t PERIOD{256};
+    // asked of the device, what it buffers on top of the voices' queues
+    static constexpr std::chrono::microseconds DEVICE_LATENCY{8'000};
+
+    explicit audio_mixer(std::unique_ptr<audio_sink> sink);
+
+    static auto global() -> audio_mixer &;
+
+    void add(const std::shared_ptr<audio_voice> &voice);
+
+private:
+    std::unique_ptr<audio_sink> sink;
+    std::mutex voices_mutex;
+    std::vector<std::weak_ptr<audio_voice>> voices;
+    std::jthread worker;
+
+    void mix(const std::stop_token &stop);
+};
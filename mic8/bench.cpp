@@ -0,0 +1,267 @@
+#include "aot.hpp"
+#include "chip8.hpp"
+#include "hash.hpp"
+#include "headless.hpp"
+#include "movie.hpp"
+#include "vector_env.hpp"
+#include "video.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <format>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <random>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace {
+    struct options {
+        std::uint64_t cycles{10'000'000};
+        std::uint64_t cycles_per_frame{1000};
+        std::uint32_t seed{1};
+        std::optional<chip8::variant> variant;
+        bool json{};
+        std::size_t env{};
+        std::size_t threads{std::thread::hardware_concurrency()};
+        std::string video;
+        std::string aot;
+        std::vector<std::string> paths;
+        std::vector<std::string> movies;
+    };
+
+    struct sample {
+        std::string rom;
+        std::uint64_t cycles{};
+        std::uint64_t frames{};
+        double seconds{};
+        std::uint64_t fb_hash{};
+        std::uint64_t state_hash{};
+        std::string error;
+        bool compiled{};
+    };
+
+    auto parse_options(const std::span<char *> args) -> options {
+        options opts;
+        for (std::size_t i = 1; i < args.size(); ++i) {
+            const std::string_view arg = args[i];
+            const auto value = [&] {
+                if (i + 1 >= args.size()) { throw std::invalid_argument(std::format("Missing value for {}", arg)); }
+                return std::string_view(args[++i]);
+            };
+            if (arg == "--cycles") {
+                opts.cycles = headless::parse_number(value());
+            } else if (arg == "--cpf") {
+                opts.cycles_per_frame = std::max<std::uint64_t>(1, headless::parse_number(value()));
+            } else if (arg == "--seed") {
+                opts.seed = static_cast<std::uint32_t>(headless::parse_number(value()));
+            } else if (arg == "--variant") {
+                opts.variant = headless::parse_variant(value());
+            } else if (arg == "--movie") {
+                opts.movies.emplace_back(value());
+            } else if (arg == "--video") {
+                opts.video = value();
+            } else if (arg == "--env") {
+                opts.env = headless::parse_number(value());
+            } else if (arg == "--threads") {
+                opts.threads = headless::parse_number(value());
+            } else if (arg == "--aot") {
+                opts.aot = value();
+            } else if (arg == "--json") {
+                opts.json = true;
+            } else if (arg.starts_with("--")) {
+                throw std::invalid_argument(std::format("Unknown option: {}", arg));
+            } else {
+                opts.paths.emplace_back(arg);
+            }
+        }
+        return opts;
+    }
+
+    // records to <source name>.<ext> in the working directory, losslessly so every frame of the run is kept
+    auto open_video(const options &opts, const std::filesystem::path &source) -> std::shared_ptr<video_recorder> {
+        if (opts.video.empty()) { return nullptr; }
+        auto path = source.filename();
+        path.replace_extension(opts.video);
+        auto recorder = std::make_shared<video_recorder>(make_video_sink(path.string()), true);
+        video_encoder::global().add(recorder);
+        return recorder;
+    }
+
+    void run_rom(const options &opts, const std::vector<headless::input_event> &events,
+                 const std::filesystem::path &rom, sample &s) {
+        chip8::alt_t alt_ops;
+        alt_ops.variant = opts.variant.value_or(headless::guess_variant(rom));
+        chip8 interpreter(alt_ops);
+        interpreter.seed(opts.seed);
+        interpreter.load_rom(s.rom);
+        std::optional<aot_runner> aot;
+        if (!opts.aot.empty()) {
+            if (auto module = aot_module::find(opts.aot, s.rom, alt_ops)) { aot.emplace(std::move(module)); }
+        }
+        const auto video = open_video(opts, rom);
+        std::function<void(const chip8 &)> on_tick;
+        if (video) { on_tick = [&video](const chip8 &c) { video->capture(c); }; }
+        const auto start = std::chrono::steady_clock::now();
+        s.cycles = headless::run(interpreter, events, opts.cycles, opts.cycles_per_frame, on_tick,
+                                 aot ? &*aot : nullptr);
+        s.compiled = aot.has_value();
+        s.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (video) { video->close(); }
+        s.fb_hash = hash::fb_hash(interpreter);
+        s.state_hash = hash::state_hash(interpreter);
+    }
+
+    // steps opts.env instances of the ROM together one frame at a time with random key masks, counting the frames
+    // of instances that had not halted yet
+    void run_env(const options &opts, const std::filesystem::path &rom, sample &s) {
+        chip8::alt_t alt_ops;
+        alt_ops.variant = opts.variant.value_or(headless::guess_variant(rom));
+        vector_env env(rom.string(), alt_ops, opts.env, opts.cycles_per_frame, opts.threads);
+        std::vector<std::uint32_t> seeds(env.size());
+        for (std::size_t i = 0; i < seeds.size(); ++i) { seeds[i] = opts.seed + static_cast<std::uint32_t>(i); }
+        std::minstd_rand rng(opts.seed);
+        std::vector<std::uint16_t> actions(env.size());
+        const auto frames = opts.cycles / env.get_cycles_per_frame();
+
+        const auto start = std::chrono::steady_clock::now();
+        auto observation = env.reset(seeds);
+        for (std::uint64_t frame = 0; frame < frames; ++frame) {
+            for (auto &action: actions) { action = static_cast<std::uint16_t>(1u << rng() % chip8::KEY_COUNT); }
+            s.frames += static_cast<std::uint64_t>(std::ranges::count(observation.done, 0));
+            observation = env.step(actions, 1);
+        }
+        s.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        s.cycles = s.frames * env.get_cycles_per_frame();
+        s.fb_hash = hash::fnv1a(std::as_bytes(observation.fb));
+    }
+
+    auto mips(const std::uint64_t cycles, const double seconds) -> double {
+        return seconds > 0 ? static_cast<double>(cycles) / seconds / 1e6 : 0;
+    }
+
+    auto fps(const std::uint64_t frames, const double seconds) -> double {
+        return seconds > 0 ? static_cast<double>(frames) / seconds : 0;
+    }
+
+    auto json_escape(const std::string_view text) -> std::string {
+        std::string escaped;
+        for (const auto c: text) {
+            if (c == '"' || c == '\\') { escaped += '\\'; }
+            escaped += c;
+        }
+        return escaped;
+    }
+}
+
+// runs each ROM once on a single thread so the numbers compare across native and Wasm builds
+auto main(int argc, char *argv[]) -> int {
+    try {
+        const auto opts = parse_options(std::span(argv, static_cast<std::size_t>(argc)));
+        if (opts.paths.empty() && opts.movies.empty()) {
+            std::fputs("usage: mic8_bench.elf [--cycles n] [--cpf n] [--seed n] [--variant chip8|schip|xochip] "
+                       "[--movie file]... [--video y4m|gif|png] [--env instances] [--threads n] [--aot dir] [--json] "
+                       "rom|dir...\n",
+                       stderr);
+            return 2;
+        }
+        const auto events = headless::load_input({}, opts.cycles);
+
+        std::vector<sample> samples;
+        for (const auto &rom: headless::collect_roms(opts.paths)) {
+            sample s{rom.generic_string()};
+            try {
+                if (opts.env != 0) {
+                    run_env(opts, rom, s);
+                } else {
+                    run_rom(opts, events, rom, s);
+                }
+            } catch (const std::invalid_argument &e) {
+                s.error = e.what();
+            }
+            samples.push_back(std::move(s));
+        }
+        // a movie replays its recorded session to the end, the hashes must match across builds
+        for (const auto &path: opts.movies) {
+            sample s{path};
+            try {
+                const auto recording = movie::load(path);
+                const auto interpreter = recording.make_interpreter();
+                const auto video = open_video(opts, path);
+                std::function<void(const chip8 &)> on_tick;
+                if (video) { on_tick = [&video](const chip8 &c) { video->capture(c); }; }
+                movie_player player(recording, on_tick);
+                const auto start = std::chrono::steady_clock::now();
+                while (!player.done()) { s.cycles += player.play(*interpreter, UINT64_MAX).cycles; }
+                s.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+                if (video) { video->close(); }
+                s.fb_hash = hash::fb_hash(*interpreter);
+                s.state_hash = hash::state_hash(*interpreter);
+            } catch (const std::invalid_argument &e) {
+                s.error = e.what();
+            }
+            samples.push_back(std::move(s));
+        }
+        if (!opts.video.empty()) { video_encoder::global().flush(); }
+
+        std::uint64_t total_cycles = 0;
+        std::uint64_t total_frames = 0;
+        double total_seconds = 0;
+        for (const auto &s: samples) {
+            total_cycles += s.cycles;
+            total_frames += s.frames;
+            total_seconds += s.seconds;
+        }
+
+        if (opts.json) {
+            std::string out = "{\"roms\":[";
+            for (std::size_t i = 0; i < samples.size(); ++i) {
+                const auto &s = samples[i];
+                out += std::format("{}{{\"rom\":\"{}\",\"cycles\":{},\"seconds\":{:.6f},\"mips\":{:.3f},"
+                                   "\"fb_hash\":\"{:016x}\",\"state_hash\":\"{:016x}\"{}{}{}}}",
+                                   i == 0 ? "" : ",", json_escape(s.rom), s.cycles, s.seconds,
+                                   mips(s.cycles, s.seconds), s.fb_hash, s.state_hash,
+                                   opts.env == 0 ? "" : std::format(",\"frames\":{}", s.frames),
+                                   s.compiled ? ",\"aot\":true" : "",
+                                   s.error.empty() ? "" : std::format(",\"error\":\"{}\"", json_escape(s.error)));
+            }
+            out += std::format("],\"cycles\":{},\"seconds\":{:.6f},\"mips\":{:.3f}{}}}\n", total_cycles, total_seconds,
+                               mips(total_cycles, total_seconds),
+                               opts.env == 0 ? "" : std::format(",\"frames\":{},\"fps\":{:.0f}", total_frames,
+                                                                fps(total_frames, total_seconds)));
+            std::fputs(out.c_str(), stdout);
+            return 0;
+        }
+
+        for (const auto &s: samples) {
+            if (!s.error.empty()) {
+                std::printf("%-48s error: %s\n", s.rom.c_str(), s.error.c_str());
+                continue;
+            }
+            std::printf("%-48s %12llu cycles %8.3f s %9.2f MIPS %016llx %016llx%s\n", s.rom.c_str(),
+                        static_cast<unsigned long long>(s.cycles), s.seconds, mips(s.cycles, s.seconds),
+                        static_cast<unsigned long long>(s.fb_hash), static_cast<unsigned long long>(s.state_hash),
+                        s.compiled ? " aot" : "");
+        }
+        std::printf("%zu runs, %llu cycles in %.3f s: %.2f MIPS\n", samples.size(),
+                    static_cast<unsigned long long>(total_cycles), total_seconds, mips(total_cycles, total_seconds));
+        if (opts.env != 0) {
+            std::printf("%llu frames across %zu instances per ROM: %.0f frames/s\n",
+                        static_cast<unsigned long long>(total_frames), opts.env, fps(total_frames, total_seconds));
+        }
+        return 0;
+    } catch (const std::invalid_argument &e) {
+        std::fprintf(stderr, "%s\n", e.what());
+        return 2;
+    }
+}
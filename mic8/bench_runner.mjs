@@ -0,0 +1,63 @@
+// Runs the headless benchmark under Node and, given --native, the native build on the same ROMs, then prints
+// Wasm vs native throughput per ROM.
+//
+//   node mic8/bench_runner.mjs web/mic8_bench.js [--native ./mic8_bench.elf] [--out results.json] [bench args...]
+import {execFileSync} from 'node:child_process';
+import {writeFileSync} from 'node:fs';
+import process from 'node:process';
+
+function usage() {
+    console.error('usage: node bench_runner.mjs <mic8_bench.js> [--native <mic8_bench.elf>] [--out <file>] ' +
+        '[--cycles n] [--cpf n] rom|dir...');
+    process.exit(2);
+}
+
+const args = process.argv.slice(2);
+if (args.length === 0) { usage(); }
+const wasm = args.shift();
+let native = null;
+let out = null;
+const benchArgs = [];
+while (args.length > 0) {
+    const arg = args.shift();
+    if (arg === '--native') {
+        native = args.shift() ?? usage();
+    } else if (arg === '--out') {
+        out = args.shift() ?? usage();
+    } else {
+        benchArgs.push(arg);
+    }
+}
+
+function run(command, commandArgs) {
+    const output = execFileSync(command, [...commandArgs, ...benchArgs, '--json'], {
+        encoding: 'utf8',
+        stdio: ['ignore', 'pipe', 'inherit'],
+        maxBuffer: 64 * 1024 * 1024
+    });
+    return JSON.parse(output);
+}
+
+const results = {wasm: run(process.execPath, [wasm])};
+if (native !== null) { results.native = run(native, []); }
+
+const nativeByRom = new Map((results.native?.roms ?? []).map((r) => [r.rom, r]));
+const rows = results.wasm.roms.map((r) => {
+    const n = nativeByRom.get(r.rom);
+    return {
+        rom: r.rom,
+        cycles: r.cycles,
+        'wasm MIPS': r.error ?? r.mips,
+        'native MIPS': n === undefined ? '' : n.error ?? n.mips,
+        ratio: n === undefined || !(n.mips > 0) ? '' : (r.mips / n.mips).toFixed(2)
+    };
+});
+console.table(rows);
+console.log(`wasm: ${results.wasm.mips.toFixed(2)} MIPS over ${results.wasm.cycles} cycles`);
+if (results.native !== undefined) {
+    console.log(`native: ${results.native.mips.toFixed(2)} MIPS over ${results.native.cycles} cycles, ` +
+        `wasm/native ${(results.wasm.mips / results.native.mips).toFixed(2)}`);
+}
+if (out !== null) {
+    writeFileSync(out, JSON.stringify({date: new Date().toISOString(), args: benchArgs, ...results}, null, 2));
+}
@@ -0,0 +1,107 @@
+#include "chip8.hpp"
+#include "headless.hpp"
+#include "quirk_bisect.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <format>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+namespace {
+    struct options {
+        quirk_bisect::options bisect;
+        std::string input;
+        std::optional<chip8::variant> variant;
+        std::size_t reference{quirk_bisect::combo_of({})};
+        std::string rom;
+    };
+
+    auto parse_options(const std::span<char *> args) -> options {
+        options opts;
+        for (std::size_t i = 1; i < args.size(); ++i) {
+            const std::string_view arg = args[i];
+            const auto value = [&] {
+                if (i + 1 >= args.size()) { throw std::invalid_argument(std::format("Missing value for {}", arg)); }
+                return std::string_view(args[++i]);
+            };
+            if (arg == "--cycles") {
+                opts.bisect.cycles = headless::parse_number(value());
+            } else if (arg == "--cpf") {
+                opts.bisect.cycles_per_frame = std::max<std::uint64_t>(1, headless::parse_number(value()));
+            } else if (arg == "--seed") {
+                opts.bisect.seed = static_cast<std::uint32_t>(headless::parse_number(value()));
+            } else if (arg == "--threads") {
+                opts.bisect.threads = std::max(1u, static_cast<unsigned>(headless::parse_number(value())));
+            } else if (arg == "--input") {
+                opts.input = value();
+            } else if (arg == "--variant") {
+                opts.variant = headless::parse_variant(value());
+            } else if (arg == "--reference") {
+                opts.reference = headless::parse_number(value());
+                if (opts.reference >= headless::QUIRK_COMBOS) {
+                    throw std::invalid_argument(std::format("Combos run from 0 to {}", headless::QUIRK_COMBOS - 1));
+                }
+            } else if (arg.starts_with("--") || !opts.rom.empty()) {
+                throw std::invalid_argument(std::format("Unknown option: {}", arg));
+            } else {
+                opts.rom = arg;
+            }
+        }
+        return opts;
+    }
+
+    auto culprit_name(const quirk_bisect::outcome &out) -> const char * {
+        return out.culprit ? quirk_bisect::quirk_strings[static_cast<std::size_t>(*out.culprit)] : "combination";
+    }
+}
+
+// runs one ROM under every quirk combo against a reference combo and reports where each one parts from it
+auto main(int argc, char *argv[]) -> int {
+    try {
+        const auto opts = parse_options(std::span(argv, static_cast<std::size_t>(argc)));
+        if (opts.rom.empty()) {
+            std::fputs("usage: mic8_bisect.elf [--reference combo] [--cycles n] [--cpf n] [--seed n] [--input file] "
+                       "[--threads n] [--variant chip8|schip|xochip] rom\n", stderr);
+            return 2;
+        }
+        const auto variant = opts.variant.value_or(headless::guess_variant(opts.rom));
+        const auto events = headless::load_input(opts.input, opts.bisect.cycles);
+        const auto rep = quirk_bisect::run(opts.rom, headless::make_alt_ops(opts.reference, variant), opts.bisect,
+                                           events);
+
+        std::printf("reference combo %zu: %s\n", rep.reference, quirk_bisect::describe(rep.reference).c_str());
+        const quirk_bisect::outcome *first = nullptr;
+        std::size_t diverged = 0;
+        for (const auto &out: rep.outcomes) {
+            if (out.combo == rep.reference) { continue; }
+            if (!out.diverged) {
+                std::printf("combo %2zu  same                 %s\n", out.combo,
+                            quirk_bisect::describe(out.combo).c_str());
+                continue;
+            }
+            ++diverged;
+            if (first == nullptr || out.cycle < first->cycle) { first = &out; }
+            std::printf("combo %2zu  cycle %-10llu %-12s %s at 0x%03X %04X: %s\n", out.combo,
+                        static_cast<unsigned long long>(out.cycle), culprit_name(out),
+                        quirk_bisect::describe(out.combo).c_str(), out.pc, out.opcode, out.instruction.c_str());
+        }
+        std::printf("%zu of %zu combos diverge in %llu cycles, %.2f s", diverged, rep.outcomes.size() - 1,
+                    static_cast<unsigned long long>(opts.bisect.cycles), rep.seconds);
+        if (first != nullptr) {
+            std::printf(", first at cycle %llu (frame %llu), pc 0x%03X %04X, blamed on %s",
+                        static_cast<unsigned long long>(first->cycle), static_cast<unsigned long long>(first->frame),
+                        first->pc, first->opcode, culprit_name(*first));
+        }
+        std::printf("\n");
+        return 0;
+    } catch (const std::invalid_argument &e) {
+        std::fprintf(stderr, "%s\n", e.what());
+        return 2;
+    }
+}
@@ -1,64 +1,349 @@
 #include "chip8.hpp"
+#include "probes.hpp"
 
 #include <algorithm>
 #include <array>
+#include <cstring>
 #include <format>
 #include <fstream>
 #include <ios>
 #include <limits>
+#include <memory>
+#include <mutex>
 #include <stdexcept>
 #include <string_view>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
-chip8::chip8(const alt_t alt_ops) {
+namespace {
+    constexpr std::array<std::uint8_t, chip8::FONTSET_SIZE> fontset{
+            //@formatter:off
+        0xF0, 0x90, 0x90, 0x90, 0xF0,
+        0x20, 0x60, 0x20, 0x20, 0x70,
+        0xF0, 0x10, 0xF0, 0x80, 0xF0,
+        0xF0, 0x10, 0xF0, 0x10, 0xF0,
+        0x90, 0x90, 0xF0, 0x10, 0x10,
+        0xF0, 0x80, 0xF0, 0x10, 0xF0,
+        0xF0, 0x80, 0xF0, 0x90, 0xF0,
+        0xF0, 0x10, 0x20, 0x40, 0x40,
+        0xF0, 0x90, 0xF0, 0x90, 0xF0,
+        0xF0, 0x90, 0xF0, 0x10, 0xF0,
+        0xF0, 0x90, 0xF0, 0x90, 0x90,
+        0xE0, 0x90, 0xE0, 0x90, 0xE0,
+        0xF0, 0x80, 0x80, 0x80, 0xF0,
+        0xE0, 0x90, 0x90, 0x90, 0xE0,
+        0xF0, 0x80, 0xF0, 0x80, 0xF0,
+        0xF0, 0x80, 0xF0, 0x80, 0x80
+            //@formatter:on
+    };
+
+    constexpr std::array<std::uint8_t, chip8::BIG_FONTSET_SIZE> big_fontset{
+            //@formatter:off
+        0xFF, 0xFF, 0xC3, 0xC3, 0xC3, 0xC3, 0xC3, 0xC3, 0xFF, 0xFF,
+        0x18, 0x78, 0x78, 0x18, 0x18, 0x18, 0x18, 0x18, 0xFF, 0xFF,
+        0xFF, 0xFF, 0x03, 0x03, 0xFF, 0xFF, 0xC0, 0xC0, 0xFF, 0xFF,
+        0xFF, 0xFF, 0x03, 0x03, 0xFF, 0xFF, 0x03, 0x03, 0xFF, 0xFF,
+        0xC3, 0xC3, 0xC3, 0xC3, 0xFF, 0xFF, 0x03, 0x03, 0x03, 0x03,
+        0xFF, 0xFF, 0xC0, 0xC0, 0xFF, 0xFF, 0x03, 0x03, 0xFF, 0xFF,
+        0xFF, 0xFF, 0xC0, 0xC0, 0xFF, 0xFF, 0xC3, 0xC3, 0xFF, 0xFF,
+        0xFF, 0xFF, 0x03, 0x03, 0x06, 0x0C, 0x18, 0x18, 0x18, 0x18,
+        0xFF, 0xFF, 0xC3, 0xC3, 0xFF, 0xFF, 0xC3, 0xC3, 0xFF, 0xFF,
+        0xFF, 0xFF, 0xC3, 0xC3, 0xFF, 0xFF, 0x03, 0x03, 0xFF, 0xFF,
+        0x7E, 0xFF, 0xC3, 0xC3, 0xC3, 0xFF, 0xFF, 0xC3, 0xC3, 0xC3,
+        0xFC, 0xFC, 0xC3, 0xC3, 0xFC, 0xFC, 0xC3, 0xC3, 0xFC, 0xFC,
+        0x3C, 0xFF, 0xC3, 0xC0, 0xC0, 0xC0, 0xC0, 0xC3, 0xFF, 0x3C,
+        0xFC, 0xFE, 0xC3, 0xC3, 0xC3, 0xC3, 0xC3, 0xC3, 0xFE, 0xFC,
+        0xFF, 0xFF, 0xC0, 0xC0, 0xFF, 0xFF, 0xC0, 0xC0, 0xFF, 0xFF,
+        0xFF, 0xFF, 0xC0, 0xC0, 0xFF, 0xFF, 0xC0, 0xC0, 0xC0, 0xC0
+            //@formatter:on
+    };
+
+    using row_bits = unsigned __int128;
+
+    static_assert(chip8::ROW_WORDS == 2);
+
+    constexpr auto row_mask(const std::size_t width) -> row_bits {
+        return width == chip8::HIRES_WIDTH ? ~row_bits{} : ~row_bits{} << 64u;
+    }
+
+    constexpr auto load_row(const chip8::plane_t &plane, const std::size_t row) -> row_bits {
+        return row_bits{plane[row * chip8::ROW_WORDS]} << 64u | plane[row * chip8::ROW_WORDS + 1];
+    }
+
+    constexpr auto store_row(chip8::plane_t &plane, const std::size_t row, const row_bits bits) -> void {
+        plane[row * chip8::ROW_WORDS] = static_cast<std::uint64_t>(bits >> 64u);
+        plane[row * chip8::ROW_WORDS + 1] = static_cast<std::uint64_t>(bits);
+    }
+
+    constexpr auto place_sprite(const std::uint16_t bits, const unsigned sprite_width, const std::size_t x_pos,
+                                const std::size_t width, const bool wrap) -> row_bits {
+        const row_bits top = row_bits{bits} << (chip8::HIRES_WIDTH - sprite_width);
+        row_bits sprite = top >> x_pos;
+        if (wrap && x_pos + sprite_width > width) {
+            sprite |= width == chip8::HIRES_WIDTH
+                          ? top << (chip8::HIRES_WIDTH - x_pos)
+                          : (sprite & ~row_mask(width)) << 64u;
+        }
+        return sprite & row_mask(width);
+    }
+
+    constexpr std::uint8_t STATE_VERSION{2};
+
+    template<typename T>
+    void put(std::vector<std::uint8_t> &state, const T &value) {
+        static_assert(std::is_trivially_copyable_v<T>);
+        const auto *bytes = reinterpret_cast<const std::uint8_t *>(&value); // NOLINT(*-pro-type-reinterpret-cast)
+        state.insert(state.end(), bytes, bytes + sizeof(T));
+    }
+
+    class state_reader {
+    public:
+        explicit state_reader(const std::span<const std::uint8_t> state) : state(state) {}
+
+        template<typename T>
+        void get(T &value) {
+            static_assert(std::is_trivially_copyable_v<T>);
+            std::memcpy(&value, take(sizeof(T)).data(), sizeof(T));
+        }
+
+        auto take(const std::size_t size) -> std::span<const std::uint8_t> {
+            if (size > state.size() - pos) { throw std::invalid_argument("Truncated save state!"); }
+            pos += size;
+            return state.subspan(pos - size, size);
+        }
+
+        [[nodiscard]] auto done() const -> bool { return pos == state.size(); }
+
+    private:
+        std::span<const std::uint8_t> state;
+        std::size_t pos{};
+    };
+}
+
+// the dispatch tables are shared, what is left is the machine state itself; keeps 100,000 instances cheap
+static_assert(sizeof(chip8) <= 2560);
+
+chip8::chip8(const alt_t alt_ops) : var(alt_ops.variant), ops(&dispatch_for(alt_ops)),
+                                    mem(alt_ops.variant == variant::xochip ? XO_MEM_SIZE : MEM_SIZE) {
+    std::ranges::copy(fontset, mem.begin() + FONTSET_ADDR);
+    std::ranges::copy(big_fontset, mem.begin() + BIG_FONTSET_ADDR);
+}
+
+auto chip8::dispatch_for(const alt_t &alt_ops) -> const dispatch_table & {
+    static constexpr std::size_t LS_MODES{3};
+    static constexpr std::size_t VARIANTS{3};
+    static std::array<std::unique_ptr<const dispatch_table>, 8 * LS_MODES * VARIANTS> tables;
+    static std::mutex tables_mutex;
+
+    auto index = static_cast<std::size_t>(alt_ops.variant) * LS_MODES + static_cast<std::size_t>(alt_ops.ls_mode);
+    index = index * 8 + (alt_ops.vip_alu ? 4u : 0u) + (alt_ops.chip48_jmp ? 2u : 0u) + (alt_ops.chip48_shf ? 1u : 0u);
+    const std::scoped_lock lock(tables_mutex);
+    auto &table = tables.at(index);
+    if (!table) { table = std::make_unique<const dispatch_table>(make_dispatch(alt_ops)); }
+    return *table;
+}
+
+auto chip8::make_dispatch(const alt_t &alt_ops) -> dispatch_table {
+    dispatch_table table;
     if (alt_ops.vip_alu) {
-        OP_ARR_8[0x1] = &chip8::op_8xy1_VIP;
-        OP_ARR_8[0x2] = &chip8::op_8xy2_VIP;
-        OP_ARR_8[0x3] = &chip8::op_8xy3_VIP;
+        table.OP_ARR_8[0x1] = &chip8::op_8xy1_VIP;
+        table.OP_ARR_8[0x2] = &chip8::op_8xy2_VIP;
+        table.OP_ARR_8[0x3] = &chip8::op_8xy3_VIP;
     }
     if (alt_ops.chip48_jmp) {
-        OP_ARR_MAIN[0xB] = &chip8::op_Bxnn_CHIP48;
+        table.OP_ARR_MAIN[0xB] = &chip8::op_Bxnn_CHIP48;
     }
     if (alt_ops.chip48_shf) {
-        OP_ARR_8[0x6] = &chip8::op_8xy6_CHIP48;
-        OP_ARR_8[0xE] = &chip8::op_8xyE_CHIP48;
+        table.OP_ARR_8[0x6] = &chip8::op_8xy6_CHIP48;
+        table.OP_ARR_8[0xE] = &chip8::op_8xyE_CHIP48;
     }
     switch (alt_ops.ls_mode) {
         case ls_mode::chip8_ls:
             break;
         case ls_mode::chip48_ls:
-            OP_ARR_F[0x55] = &chip8::op_Fx55_CHIP48;
-            OP_ARR_F[0x65] = &chip8::op_Fx65_CHIP48;
+            table.OP_ARR_F[0x55] = &chip8::op_Fx55_CHIP48;
+            table.OP_ARR_F[0x65] = &chip8::op_Fx65_CHIP48;
             break;
         case ls_mode::schip11_ls:
-            OP_ARR_F[0x55] = &chip8::op_Fx55_SCHIP11;
-            OP_ARR_F[0x65] = &chip8::op_Fx65_SCHIP11;
+            table.OP_ARR_F[0x55] = &chip8::op_Fx55_SCHIP11;
+            table.OP_ARR_F[0x65] = &chip8::op_Fx65_SCHIP11;
+    }
+    if (alt_ops.variant != variant::chip8) {
+        for (std::size_t n = 0; n <= 0xF; ++n) {
+            table.OP_ARR_0[0xC0 + n] = &chip8::op_00Cn;
+        }
+        table.OP_ARR_0[0xFB] = &chip8::op_00FB;
+        table.OP_ARR_0[0xFC] = &chip8::op_00FC;
+        table.OP_ARR_0[0xFD] = &chip8::op_00FD;
+        table.OP_ARR_0[0xFE] = &chip8::op_00FE;
+        table.OP_ARR_0[0xFF] = &chip8::op_00FF;
+        table.OP_ARR_F[0x30] = &chip8::op_Fx30;
+        table.OP_ARR_F[0x75] = &chip8::op_Fx75;
+        table.OP_ARR_F[0x85] = &chip8::op_Fx85;
+    }
+    if (alt_ops.variant == variant::xochip) {
+        for (std::size_t n = 0; n <= 0xF; ++n) {
+            table.OP_ARR_0[0xD0 + n] = &chip8::op_00Dn;
+        }
+        table.OP_ARR_MAIN[0x5] = &chip8::op_arr_5;
+        table.OP_ARR_F[0x00] = &chip8::op_F000;
+        table.OP_ARR_F[0x01] = &chip8::op_Fn01;
+        table.OP_ARR_F[0x02] = &chip8::op_F002;
+        table.OP_ARR_F[0x3A] = &chip8::op_Fx3A;
     }
+    return table;
 }
 
+void chip8::seed(const std::minstd_rand::result_type value) { rng.seed(value); }
+
 void chip8::run_cycle() {
-    instruction = mem[pc] << 8u | mem[pc + 1];
+    instruction = mem_at(pc) << 8u | mem_at(pc + 1u);
     pc += INSTRUCTION_SIZE;
-    (this->*OP_ARR_MAIN[(instruction & 0xF000u) >> 12u])();
+    executed_pc = pc;
+    (this->*ops->OP_ARR_MAIN[(instruction & 0xF000u) >> 12u])();
+}
+
+// the probes report the pc execution continues from
+auto chip8::run_cycles(const std::uint64_t budget, const bool stop_on_draw) -> run_result {
+    MIC8_PROBE3(batch_start, trace_id, pc, budget);
+    const auto finish = [this](const stop_reason reason, const std::uint64_t cycles) -> run_result {
+        MIC8_PROBE4(batch_end, trace_id, pc, cycles, reason);
+        return {reason, cycles};
+    };
+    const std::uint8_t stop_mask = EVENT_KEY_WAIT | (stop_on_draw ? EVENT_DRAW : 0u);
+    events = 0;
+    for (std::uint64_t cycles = 1; cycles <= budget; ++cycles) {
+        run_cycle();
+        if (hlt_flag) {
+            MIC8_PROBE2(halt, trace_id, pc);
+            return finish(stop_reason::halted, cycles);
+        }
+        if ((events & stop_mask) != 0) {
+            return finish((events & EVENT_KEY_WAIT) != 0 ? stop_reason::key_wait : stop_reason::draw, cycles);
+        }
+        if (pc < breakpoints.size() && breakpoints[pc]) { return finish(stop_reason::breakpoint, cycles); }
+    }
+    return finish(stop_reason::budget, budget);
+}
+
+void chip8::set_breakpoint(const std::uint16_t addr, const bool enabled) {
+    if (breakpoints.empty()) { breakpoints.resize(mem.size()); }
+    if (addr < breakpoints.size()) { breakpoints[addr] = enabled; }
+}
+
+void chip8::clear_breakpoints() { breakpoints.clear(); }
+
+void chip8::mark_drawn() {
+    drw_flag = true;
+    events |= EVENT_DRAW;
+    MIC8_PROBE2(draw, trace_id, pc);
 }
 
 void chip8::decrement_timers() {
     if (dt > 0) { --dt; }
     if (st > 0) { --st; }
+    MIC8_PROBE3(timer_tick, trace_id, dt, st);
 }
 
 void chip8::reset() {
-    fb.fill(0);
+    for (auto &plane: fb) { plane.fill(0); }
+    pattern.fill(0);
     stack.fill(0);
     reg.fill(0);
     keys.fill(false);
     drw_flag = true;
     hlt_flag = false;
+    wait_flag = false;
     pc = ROM_ADDR;
+    executed_pc = 0;
+    instruction = 0;
     ir = 0;
     sp = 0;
     dt = 0;
     st = 0;
+    wait_key = 0;
+    pitch = 64;
+    planes = 1;
+    hires = false;
+}
+
+auto chip8::save_state() const -> std::vector<std::uint8_t> {
+    std::vector<std::uint8_t> state;
+    state.reserve(mem.size() + sizeof(fb) + 256);
+    put(state, STATE_VERSION);
+    put(state, var);
+    put(state, rng);
+    state.insert(state.end(), mem.begin(), mem.end());
+    put(state, fb);
+    put(state, stack);
+    put(state, reg);
+    put(state, pattern);
+    put(state, flags);
+    put(state, keys);
+    put(state, instruction);
+    put(state, pc);
+    put(state, ir);
+    put(state, sp);
+    put(state, dt);
+    put(state, st);
+    put(state, wait_key);
+    put(state, pitch);
+    put(state, planes);
+    put(state, events);
+    put(state, drw_flag);
+    put(state, hlt_flag);
+    put(state, wait_flag);
+    put(state, hires);
+    put(state, static_cast<std::uint32_t>(std::ranges::count(breakpoints, true)));
+    for (std::size_t addr = 0; addr < breakpoints.size(); ++addr) {
+        if (breakpoints[addr]) { put(state, static_cast<std::uint16_t>(addr)); }
+    }
+    put(state, executed_pc);
+    return state;
+}
+
+void chip8::load_state(const std::span<const std::uint8_t> state) {
+    state_reader reader(state);
+    std::uint8_t version{};
+    variant saved_var{};
+    reader.get(version);
+    reader.get(saved_var);
+    if (version != STATE_VERSION || saved_var != var) {
+        throw std::invalid_argument("The save state is for another build or variant!");
+    }
+    reader.get(rng);
+    std::memcpy(mem.data(), reader.take(mem.size()).data(), mem.size());
+    reader.get(fb);
+    reader.get(stack);
+    reader.get(reg);
+    reader.get(pattern);
+    reader.get(flags);
+    reader.get(keys);
+    reader.get(instruction);
+    reader.get(pc);
+    reader.get(ir);
+    reader.get(sp);
+    reader.get(dt);
+    reader.get(st);
+    reader.get(wait_key);
+    reader.get(pitch);
+    reader.get(planes);
+    reader.get(events);
+    reader.get(drw_flag);
+    reader.get(hlt_flag);
+    reader.get(wait_flag);
+    reader.get(hires);
+    std::uint32_t count{};
+    reader.get(count);
+    clear_breakpoints();
+    for (std::uint32_t i = 0; i < count; ++i) {
+        std::uint16_t addr{};
+        reader.get(addr);
+        set_breakpoint(addr, true);
+    }
+    reader.get(executed_pc);
+    if (!reader.done()) { throw std::invalid_argument("The save state is for another build or variant!"); }
 }
 
 void chip8::load_rom(const std::string_view path) {
@@ -74,15 +359,15 @@ void chip8::load_rom(const std::string_view path) {
     if (!file) {
         throw std::invalid_argument("Seek failed!");
     }
-    if (static_cast<unsigned>(file_size) > mem.size() - ROM_ADDR) {
+    if (static_cast<std::size_t>(file_size) > mem.size() - ROM_ADDR) {
         throw std::invalid_argument("File will not fit in memory!");
     }
-    std::vector<std::uint8_t> buffer(file_size);
-    file.read(reinterpret_cast<char *>(buffer.data()), file_size); // NOLINT(*-pro-type-reinterpret-cast)
+    // straight into memory, so a failed read may leave part of the ROM there
+    file.read(reinterpret_cast<char *>(mem.data() + ROM_ADDR), file_size); // NOLINT(*-pro-type-reinterpret-cast)
     if (!file) {
         throw std::invalid_argument("Read Failed!");
     }
-    std::ranges::copy(buffer, mem.begin() + ROM_ADDR);
+    MIC8_PROBE3(rom_load, trace_id, path.data(), static_cast<std::size_t>(file_size));
 }
 
 void chip8::unload_rom() {
@@ -90,111 +375,247 @@ void chip8::unload_rom() {
     std::fill(mem.begin() + ROM_ADDR, mem.end(), 0);
 }
 
-void chip8::op_arr_0() { (this->*OP_ARR_0[instruction & 0x00FFu])(); }
+void chip8::skip() {
+    if (var == variant::xochip && mem_at(pc) == 0xF0 && mem_at(pc + 1u) == 0x00) {
+        pc += INSTRUCTION_SIZE;
+    }
+    pc += INSTRUCTION_SIZE;
+}
+
+void chip8::scroll_vertical(const int rows) {
+    const auto height = static_cast<std::ptrdiff_t>(get_height() * ROW_WORDS);
+    const auto shift = std::min<std::ptrdiff_t>(std::abs(rows) * static_cast<std::ptrdiff_t>(ROW_WORDS), height);
+    for (std::size_t p = 0; p < PLANE_COUNT; ++p) {
+        if ((planes & 1u << p) == 0) { continue; }
+        const auto first = fb[p].begin();
+        const auto last = first + height;
+        if (rows > 0) {
+            std::shift_right(first, last, shift);
+            std::fill(first, first + shift, 0);
+        } else {
+            std::shift_left(first, last, shift);
+            std::fill(last - shift, last, 0);
+        }
+    }
+    mark_drawn();
+}
+
+void chip8::scroll_horizontal(const int cols) {
+    const auto mask = row_mask(get_width());
+    for (std::size_t p = 0; p < PLANE_COUNT; ++p) {
+        if ((planes & 1u << p) == 0) { continue; }
+        for (std::size_t row = 0; row < get_height(); ++row) {
+            const auto bits = load_row(fb[p], row);
+            store_row(fb[p], row, (cols > 0 ? bits >> cols : bits << -cols) & mask);
+        }
+    }
+    mark_drawn();
+}
+
+auto chip8::handler_for(const std::uint16_t instruction) const -> op_type {
+    const auto handler = ops->OP_ARR_MAIN[(instruction & 0xF000u) >> 12u];
+    if (handler == &chip8::op_arr_0) { return ops->OP_ARR_0[instruction & 0x00FFu]; }
+    if (handler == &chip8::op_arr_5) { return ops->OP_ARR_5[instruction & 0x000Fu]; }
+    if (handler == &chip8::op_arr_8) { return ops->OP_ARR_8[instruction & 0x000Fu]; }
+    if (handler == &chip8::op_arr_E) { return ops->OP_ARR_E[instruction & 0x000Fu]; }
+    if (handler == &chip8::op_arr_F) { return ops->OP_ARR_F[instruction & 0x00FFu]; }
+    return handler;
+}
+
+auto chip8::get_executed() const -> executed {
+    const auto &memory = mem;
+    const auto at = [&memory](const std::size_t addr) { return memory[addr & (memory.size() - 1)]; };
+    return {executed_pc, instruction, static_cast<std::uint16_t>(at(executed_pc) << 8u | at(executed_pc + 1u))};
+}
+
+// formats into out rather than a string, so the instruction log can describe the rows on screen without allocating
+auto chip8::describe(const executed &op, const std::span<char> out) const -> std::size_t {
+    const auto pc = op.pc;
+    const auto instruction = op.instruction;
+    const unsigned x = (instruction & 0x0F00u) >> 8u;
+    const unsigned y = (instruction & 0x00F0u) >> 4u;
+    const unsigned n = instruction & 0x000Fu;
+    const unsigned nn = instruction & 0x00FFu;
+    const unsigned nnn = instruction & 0x0FFFu;
+    const auto write = [out]<typename... Args>(const std::format_string<Args...> fmt, Args &&... args) {
+        const auto size = static_cast<std::ptrdiff_t>(out.size());
+        return static_cast<std::size_t>(std::format_to_n(out.data(), size, fmt, std::forward<Args>(args)...).out -
+                                        out.data());
+    };
+    const auto handler = handler_for(instruction);
+    if (handler == &chip8::op_00E0) { return write("0x{:X} - {:04X} -> clear", pc, instruction); }
+    if (handler == &chip8::op_00EE) { return write("0x{:X} - {:04X} -> return", pc, instruction); }
+    if (handler == &chip8::op_1nnn) { return write("0x{:X} - {:X} -> jump 0x{:03X}", pc, instruction, nnn); }
+    if (handler == &chip8::op_2nnn) { return write("0x{:X} - {:X} -> :call 0x{:03X}", pc, instruction, nnn); }
+    if (handler == &chip8::op_3xnn) { return write("0x{:X} - {:X} -> if v{:X} != {} then", pc, instruction, x, nn); }
+    if (handler == &chip8::op_4xnn) { return write("0x{:X} - {:X} -> if v{:X} == {} then", pc, instruction, x, nn); }
+    if (handler == &chip8::op_5xy0) { return write("0x{:X} - {:X} -> if v{:X} != v{:X} then", pc, instruction, x, y); }
+    if (handler == &chip8::op_6xnn) { return write("0x{:X} - {:X} -> v{:X} := {}", pc, instruction, x, nn); }
+    if (handler == &chip8::op_7xnn) { return write("0x{:X} - {:X} -> v{:X} += {}", pc, instruction, x, nn); }
+    if (handler == &chip8::op_8xy0) { return write("0x{:X} - {:X} -> v{:X} := v{:X}", pc, instruction, x, y); }
+    if (handler == &chip8::op_8xy1 || handler == &chip8::op_8xy1_VIP) {
+        return write("0x{:X} - {:X} -> v{:X} |= v{:X}", pc, instruction, x, y);
+    }
+    if (handler == &chip8::op_8xy2 || handler == &chip8::op_8xy2_VIP) {
+        return write("0x{:X} - {:X} -> v{:X} &= v{:X}", pc, instruction, x, y);
+    }
+    if (handler == &chip8::op_8xy3 || handler == &chip8::op_8xy3_VIP) {
+        return write("0x{:X} - {:X} -> v{:X} ^= v{:X}", pc, instruction, x, y);
+    }
+    if (handler == &chip8::op_8xy4) { return write("0x{:X} - {:X} -> v{:X} += v{:X}", pc, instruction, x, y); }
+    if (handler == &chip8::op_8xy5) { return write("0x{:X} - {:X} -> v{:X} -= v{:X}", pc, instruction, x, y); }
+    if (handler == &chip8::op_8xy6) { return write("0x{:X} - {:X} -> v{:X} >>= v{:X}", pc, instruction, x, y); }
+    if (handler == &chip8::op_8xy7) { return write("0x{:X} - {:X} -> v{:X} =- v{:X}", pc, instruction, x, y); }
+    if (handler == &chip8::op_8xyE) { return write("0x{:X} - {:X} -> v{:X} <<= v{:X}", pc, instruction, x, y); }
+    if (handler == &chip8::op_9xy0) { return write("0x{:X} - {:X} -> if v{:X} == v{:X} then", pc, instruction, x, y); }
+    if (handler == &chip8::op_Annn) { return write("0x{:X} - {:X} -> i := 0x{:3X}", pc, instruction, nnn); }
+    if (handler == &chip8::op_Bnnn) { return write("0x{:X} - {:X} -> jump0 0x{:3X}", pc, instruction, nnn); }
+    if (handler == &chip8::op_Cxnn) { return write("0x{:X} - {:X} -> v{:X} := random {}", pc, instruction, x, nn); }
+    if (handler == &chip8::op_Dxyn) { return write("0x{:X} - {:X} -> sprite v{:X} v{:X} {}", pc, instruction, x, y, n); }
+    if (handler == &chip8::op_Ex9E) { return write("0x{:X} - {:X} -> if v{:X} -key then", pc, instruction, x); }
+    if (handler == &chip8::op_ExA1) { return write("0x{:X} - {:X} -> if v{:X} key then", pc, instruction, x); }
+    if (handler == &chip8::op_Fx07) { return write("0x{:X} - {:X} -> v{:X} := delay", pc, instruction, x); }
+    if (handler == &chip8::op_Fx0A) { return write("0x{:X} - {:X} -> v{:X} := key", pc, instruction, x); }
+    if (handler == &chip8::op_Fx15) { return write("0x{:X} - {:X} -> delay := v{:X}", pc, instruction, x); }
+    if (handler == &chip8::op_Fx18) { return write("0x{:X} - {:X} -> buzzer := v{:X}", pc, instruction, x); }
+    if (handler == &chip8::op_Fx1E) { return write("0x{:X} - {:X} -> i += v{:X}", pc, instruction, x); }
+    if (handler == &chip8::op_Fx29) { return write("0x{:X} - {:X} -> i := hex v{:X}", pc, instruction, x); }
+    if (handler == &chip8::op_Fx33) { return write("0x{:X} - {:X} -> bcd v{:X}", pc, instruction, x); }
+    if (handler == &chip8::op_Fx55) { return write("0x{:X} - {:X} -> save v{:X}", pc, instruction, x); }
+    if (handler == &chip8::op_Fx65) { return write("0x{:X} - {:X} -> load v{:X}", pc, instruction, x); }
+    if (handler == &chip8::op_8xy6_CHIP48) { return write("0x{:X} - {:X} -> v{:X} >>= 1", pc, instruction, x); }
+    if (handler == &chip8::op_8xyE_CHIP48) { return write("0x{:X} - {:X} -> v{:X} <<= 1", pc, instruction, x); }
+    if (handler == &chip8::op_Bxnn_CHIP48) {
+        return write("0x{:X} - {:X} -> jump0 0x{:2X} + v{:X}", pc, instruction, nn, x);
+    }
+    if (handler == &chip8::op_Fx55_CHIP48) { return write("0x{:X} - {:X} -> save v{:X}", pc, instruction, x); }
+    if (handler == &chip8::op_Fx65_CHIP48) { return write("0x{:X} - {:X} -> load v{:X}", pc, instruction, x); }
+    if (handler == &chip8::op_Fx55_SCHIP11) { return write("0x{:X} - {:X} -> save v{:X}", pc, instruction, x); }
+    if (handler == &chip8::op_Fx65_SCHIP11) { return write("0x{:X} - {:X} -> load v{:X}", pc, instruction, x); }
+    if (handler == &chip8::op_00Cn) { return write("0x{:X} - {:04X} -> scroll-down {}", pc, instruction, n); }
+    if (handler == &chip8::op_00FB) { return write("0x{:X} - {:04X} -> scroll-right", pc, instruction); }
+    if (handler == &chip8::op_00FC) { return write("0x{:X} - {:04X} -> scroll-left", pc, instruction); }
+    if (handler == &chip8::op_00FD) { return write("0x{:X} - {:04X} -> exit", pc, instruction); }
+    if (handler == &chip8::op_00FE) { return write("0x{:X} - {:04X} -> lores", pc, instruction); }
+    if (handler == &chip8::op_00FF) { return write("0x{:X} - {:04X} -> hires", pc, instruction); }
+    if (handler == &chip8::op_Fx30) { return write("0x{:X} - {:X} -> i := bighex v{:X}", pc, instruction, x); }
+    if (handler == &chip8::op_Fx75) { return write("0x{:X} - {:X} -> saveflags v{:X}", pc, instruction, x); }
+    if (handler == &chip8::op_Fx85) { return write("0x{:X} - {:X} -> loadflags v{:X}", pc, instruction, x); }
+    if (handler == &chip8::op_00Dn) { return write("0x{:X} - {:04X} -> scroll-up {}", pc, instruction, n); }
+    if (handler == &chip8::op_5xy2) { return write("0x{:X} - {:X} -> save v{:X} - v{:X}", pc, instruction, x, y); }
+    if (handler == &chip8::op_5xy3) { return write("0x{:X} - {:X} -> load v{:X} - v{:X}", pc, instruction, x, y); }
+    if (handler == &chip8::op_F000 && instruction == 0xF000u) {
+        return write("0x{:X} - {:X} {:04X} -> i := long 0x{:04X}", pc, instruction, op.operand, op.operand);
+    }
+    if (handler == &chip8::op_Fn01) { return write("0x{:X} - {:X} -> plane {}", pc, instruction, x); }
+    if (handler == &chip8::op_F002 && instruction == 0xF002u) { return write("0x{:X} - {:X} -> audio", pc, instruction); }
+    if (handler == &chip8::op_Fx3A) { return write("0x{:X} - {:X} -> pitch := v{:X}", pc, instruction, x); }
+    return write("0x{:X} - {:X} -> null", pc, instruction);
+}
+
+auto chip8::get_instruction() const -> std::string {
+    if (executed_pc == 0) { return {}; }
+    std::array<char, 64> text{};
+    return {text.data(), describe(get_executed(), text)};
+}
+
+void chip8::op_arr_0() { (this->*ops->OP_ARR_0[instruction & 0x00FFu])(); }
 
-void chip8::op_arr_8() { (this->*OP_ARR_8[instruction & 0x000Fu])(); }
+void chip8::op_arr_5() { (this->*ops->OP_ARR_5[instruction & 0x000Fu])(); }
 
-void chip8::op_arr_E() { (this->*OP_ARR_E[instruction & 0x000Fu])(); }
+void chip8::op_arr_8() { (this->*ops->OP_ARR_8[instruction & 0x000Fu])(); }
 
-void chip8::op_arr_F() { (this->*OP_ARR_F[instruction & 0x00FFu])(); }
+void chip8::op_arr_E() { (this->*ops->OP_ARR_E[instruction & 0x000Fu])(); }
+
+void chip8::op_arr_F() { (this->*ops->OP_ARR_F[instruction & 0x00FFu])(); }
 
 void chip8::op_null() {
-    instruction_string = std::format("0x{:X} - {:X} -> null", pc, instruction);
     hlt_flag = true;
 }
 
 void chip8::op_00E0() {
-    instruction_string = std::format("0x{:X} - {:04X} -> clear", pc, instruction);
-    fb.fill(0u);
-    drw_flag = true;
+    for (std::size_t p = 0; p < PLANE_COUNT; ++p) {
+        if ((planes & 1u << p) != 0) { fb[p].fill(0u); }
+    }
+    mark_drawn();
 }
 
 void chip8::op_00EE() {
-    instruction_string = std::format("0x{:X} - {:04X} -> return", pc, instruction);
-    pc = stack[--sp];
+    // the stack is circular, so runaway code can't index past it
+    sp = (sp - 1u) & (STACK_SIZE - 1);
+    pc = stack[sp];
 }
 
 void chip8::op_1nnn() {
     const std::uint16_t nnn = instruction & 0x0FFFu;
-    instruction_string = std::format("0x{:X} - {:X} -> jump 0x{:03X}", pc, instruction, nnn);
     if (pc == nnn) { hlt_flag = true; }
     pc = nnn;
 }
 
 void chip8::op_2nnn() {
     const std::uint16_t nnn = instruction & 0x0FFFu;
-    instruction_string = std::format("0x{:X} - {:X} -> :call 0x{:03X}", pc, instruction, nnn);
-    stack[sp++] = pc;
+    stack[sp] = pc;
+    sp = (sp + 1u) & (STACK_SIZE - 1);
     pc = nnn;
 }
 
 void chip8::op_3xnn() {
     const std::uint8_t x = (instruction & 0x0F00u) >> 8u;
     const std::uint8_t nn = instruction & 0x0FFFu;
-    instruction_string = std::format("0x{:X} - {:X} -> if v{:X} != {} then", pc, instruction, x, nn);
-    if (reg[x] == nn) { pc += INSTRUCTION_SIZE; }
+    if (reg[x] == nn) { skip(); }
 }
 
 void chip8::op_4xnn() {
     const std::uint8_t x = (instruction & 0x0F00u) >> 8u;
     const std::uint8_t nn = instruction & 0x0FFFu;
-    instruction_string = std::format("0x{:X} - {:X} -> if v{:X} == {} then", pc, instruction, x, nn);
-    if (reg[x] != nn) { pc += INSTRUCTION_SIZE; }
+    if (reg[x] != nn) { skip(); }
 }
 
 void chip8::op_5xy0() {
     const std::uint8_t x = (instruction & 0x0F00u) >> 8u;
     const std::uint8_t y = (instruction & 0x00F0u) >> 4u;
-    instruction_string = std::format("0x{:X} - {:X} -> if v{:X} != v{:X} then", pc, instruction, x, y);
-    if (reg[x] == reg[y]) { pc += INSTRUCTION_SIZE; }
+    if (reg[x] == reg[y]) { skip(); }
 }
 
 void chip8::op_6xnn() {
     const std::uint8_t x = (instruction & 0x0F00u) >> 8u;
     const std::uint8_t nn = instruction & 0x00FFu;
-    instruction_string = std::format("0x{:X} - {:X} -> v{:X} := {}", pc, instruction, x, nn);
     reg[x] = nn;
 }
 
 void chip8::op_7xnn() {
     const std::uint8_t x = (instruction & 0x0F00u) >> 8u;
     const std::uint8_t nn = instruction & 0x00FFu;
-    instruction_string = std::format("0x{:X} - {:X} -> v{:X} += {}", pc, instruction, x, nn);
     reg[x] += nn;
 }
 
 void chip8::op_8xy0() {
     const std::uint8_t x = (instruction & 0x0F00u) >> 8u;
     const std::uint8_t y = (instruction & 0x00F0u) >> 4u;
-    instruction_string = std::format("0x{:X} - {:X} -> v{:X} := v{:X}", pc, instruction, x, y);
     reg[x] = reg[y];
 }
 
 void chip8::op_8xy1() {
     const std::uint8_t x = (instruction & 0x0F00u) >> 8u;
     const std::uint8_t y = (instruction & 0x00F0u) >> 4u;
-    instruction_string = std::format("0x{:X} - {:X} -> v{:X} |= v{:X}", pc, instruction, x, y);
     reg[x] |= reg[y];
 }
 
 void chip8::op_8xy2() {
     const std::uint8_t x = (instruction & 0x0F00u) >> 8u;
     const std::uint8_t y = (instruction & 0x00F0u) >> 4u;
-    instruction_string = std::format("0x{:X} - {:X} -> v{:X} &= v{:X}", pc, instruction, x, y);
     reg[x] &= reg[y];
 }
 
 void chip8::op_8xy3() {
     const std::uint8_t x = (instruction & 0x0F00u) >> 8u;
     const std::uint8_t y = (instruction & 0x00F0u) >> 4u;
-    instruction_string = std::format("0x{:X} - {:X} -> v{:X} ^= v{:X}", pc, instruction, x, y);
     reg[x] ^= reg[y];
 }
 
 void chip8::op_8xy4() {
     const std::uint8_t x = (instruction & 0x0F00u) >> 8u;
     const std::uint8_t y = (instruction & 0x00F0u) >> 4u;
-    instruction_string = std::format("0x{:X} - {:X} -> v{:X} += v{:X}", pc, instruction, x, y);
     const std::uint16_t res = reg[x] + reg[y];
     reg[x] = res;
     reg[0xF] = res >> 8u;
@@ -203,7 +624,6 @@ void chip8::op_8xy4() {
 void chip8::op_8xy5() {
     const std::uint8_t x = (instruction & 0x0F00u) >> 8u;
     const std::uint8_t y = (instruction & 0x00F0u) >> 4u;
-    instruction_string = std::format("0x{:X} - {:X} -> v{:X} -= v{:X}", pc, instruction, x, y);
     const std::uint16_t res = reg[x] - reg[y];
     reg[x] = res;
     reg[0xF] = static_cast<std::uint8_t>(res <= std::numeric_limits<std::uint8_t>::max());
@@ -212,7 +632,6 @@ void chip8::op_8xy5() {
 void chip8::op_8xy6() {
     const std::uint8_t x = (instruction & 0x0F00u) >> 8u;
     const std::uint8_t y = (instruction & 0x00F0u) >> 4u;
-    instruction_string = std::format("0x{:X} - {:X} -> v{:X} >>= v{:X}", pc, instruction, x, y);
     const std::uint8_t car = reg[y] & 1u;
     reg[x] = reg[y] >> 1u;
     reg[0xF] = car;
@@ -221,7 +640,6 @@ void chip8::op_8xy6() {
 void chip8::op_8xy7() {
     const std::uint8_t x = (instruction & 0x0F00u) >> 8u;
     const std::uint8_t y = (instruction & 0x00F0u) >> 4u;
-    instruction_string = std::format("0x{:X} - {:X} -> v{:X} =- v{:X}", pc, instruction, x, y);
     const std::uint16_t res = reg[y] - reg[x];
     reg[x] = res;
     reg[0xF] = static_cast<std::uint8_t>(res <= std::numeric_limits<std::uint8_t>::max());
@@ -230,7 +648,6 @@ void chip8::op_8xy7() {
 void chip8::op_8xyE() {
     const std::uint8_t x = (instruction & 0x0F00u) >> 8u;
     const std::uint8_t y = (instruction & 0x00F0u) >> 4u;
-    instruction_string = std::format("0x{:X} - {:X} -> v{:X} <<= v{:X}", pc, instruction, x, y);
     const uint8_t car = reg[y] >> 7u;
     reg[x] = reg[y] << 1u;
     reg[0xF] = car;
@@ -239,19 +656,16 @@ void chip8::op_8xyE() {
 void chip8::op_9xy0() {
     const std::uint8_t x = (instruction & 0x0F00u) >> 8u;
     const std::uint8_t y = (instruction & 0x00F0u) >> 4u;
-    instruction_string = std::format("0x{:X} - {:X} -> if v{:X} == v{:X} then", pc, instruction, x, y);
-    if (reg[x] != reg[y]) { pc += INSTRUCTION_SIZE; }
+    if (reg[x] != reg[y]) { skip(); }
 }
 
 void chip8::op_Annn() {
     const std::uint16_t nnn = instruction & 0x0FFFu;
-    instruction_string = std::format("0x{:X} - {:X} -> i := 0x{:3X}", pc, instruction, nnn);
     ir = nnn;
 }
 
 void chip8::op_Bnnn() {
     const std::uint16_t nnn = instruction & 0x0FFFu;
-    instruction_string = std::format("0x{:X} - {:X} -> jump0 0x{:3X}", pc, instruction, nnn);
     if (pc == reg[0x0] + nnn) { hlt_flag = true; }
     pc = reg[0x0] + nnn;
 }
@@ -259,110 +673,124 @@ void chip8::op_Bnnn() {
 void chip8::op_Cxnn() {
     const std::uint8_t x = (instruction & 0x0F00u) >> 8u;
     const std::uint8_t nn = instruction & 0x00FFu;
-    instruction_string = std::format("0x{:X} - {:X} -> v{:X} := random {}", pc, instruction, x, nn);
-    reg[x] = std::uniform_int_distribution<>(0, std::numeric_limits<std::uint8_t>::max())(rng) & nn;
+    reg[x] = static_cast<std::uint8_t>(rng() >> 8u) & nn;
 }
 
 void chip8::op_Dxyn() {
     const std::uint8_t x = (instruction & 0x0F00u) >> 8u;
     const std::uint8_t y = (instruction & 0x00F0u) >> 4u;
     const std::uint8_t n = instruction & 0x000Fu;
-    instruction_string = std::format("0x{:X} - {:X} -> sprite v{:X} v{:X} {}", pc, instruction, x, y, n);
-    const std::uint8_t x_pos = reg[x] & VIDEO_WIDTH - 1;
-    const std::uint8_t y_pos = reg[y] & VIDEO_HEIGHT - 1;
-    for (unsigned char row = 0; row < n; ++row) {
-        if (row + y_pos >= VIDEO_HEIGHT) { break; }
-        const std::uint8_t pixels = mem[ir + row];
-        for (unsigned char col = 0; col < 8; ++col) {
-            if (col + x_pos >= VIDEO_WIDTH) { break; }
-            if ((pixels & 0b1000'0000 >> col) == 0) { continue; }
-            const std::uint16_t px_pox = x_pos + col + (y_pos + row) * VIDEO_WIDTH;
-            reg[0xF] = static_cast<std::uint8_t>(fb[px_pox] == 0xFFFF'FFFF);
-            fb[px_pox] ^= 0xFFFF'FFFF;
+    const std::size_t width = get_width();
+    const std::size_t height = get_height();
+    const std::size_t x_pos = reg[x] & (width - 1);
+    const std::size_t y_pos = reg[y] & (height - 1);
+    const bool big = n == 0 && var != variant::chip8;
+    const bool wrap = var == variant::xochip;
+    const unsigned sprite_width = big ? 16 : 8;
+    const std::size_t rows = big ? 16 : n;
+    const std::size_t row_bytes = big ? 2 : 1;
+    std::size_t addr = ir;
+    unsigned hits = 0;
+    for (std::size_t p = 0; p < PLANE_COUNT; ++p) {
+        if ((planes & 1u << p) == 0) { continue; }
+        for (std::size_t row = 0; row < rows; ++row, addr += row_bytes) {
+            std::size_t y_row = y_pos + row;
+            if (y_row >= height) {
+                if (!wrap) {
+                    hits += static_cast<unsigned>(hires);
+                    continue;
+                }
+                y_row -= height;
+            }
+            const std::uint16_t pixels = big
+                                             ? mem_at(addr) << 8u | mem_at(addr + 1)
+                                             : mem_at(addr);
+            const auto sprite = place_sprite(pixels, sprite_width, x_pos, width, wrap);
+            const auto current = load_row(fb[p], y_row);
+            hits += static_cast<unsigned>((current & sprite) != 0);
+            store_row(fb[p], y_row, current ^ sprite);
         }
     }
-    drw_flag = true;
+    reg[0xF] = var == variant::schip && hires ? hits : static_cast<std::uint8_t>(hits != 0);
+    mark_drawn();
 }
 
 void chip8::op_Ex9E() {
     const std::uint8_t x = (instruction & 0x0F00u) >> 8u;
-    instruction_string = std::format("0x{:X} - {:X} -> if v{:X} -key then", pc, instruction, x);
-    if (keys[reg[x]]) { pc += INSTRUCTION_SIZE; }
+    if (keys[reg[x] & (KEY_COUNT - 1)]) { skip(); }
 }
 
 void chip8::op_ExA1() {
     const std::uint8_t x = (instruction & 0x0F00u) >> 8u;
-    instruction_string = std::format("0x{:X} - {:X} -> if v{:X} key then", pc, instruction, x);
-    if (!keys[reg[x]]) { pc += INSTRUCTION_SIZE; }
+    if (!keys[reg[x] & (KEY_COUNT - 1)]) { skip(); }
 }
 
 void chip8::op_Fx07() {
     const std::uint8_t x = (instruction & 0x0F00u) >> 8u;
-    instruction_string = std::format("0x{:X} - {:X} -> v{:X} := delay", pc, instruction, x);
     reg[x] = dt;
 }
 
 void chip8::op_Fx0A() {
     const std::uint8_t x = (instruction & 0x0F00u) >> 8u;
-    instruction_string = std::format("0x{:X} - {:X} -> v{:X} := key", pc, instruction, x);
-    static bool set = false;
-    static unsigned char i;
-    for (i = 0; !set && i < KEY_COUNT; ++i) {
-        set = keys[i];
+    if (!wait_flag) {
+        for (unsigned char i = 0; i < KEY_COUNT; ++i) {
+            if (keys[i]) {
+                wait_key = i;
+                wait_flag = true;
+                break;
+            }
+        }
     }
-    if (keys[i] || !set) { pc -= INSTRUCTION_SIZE; } else {
-        reg[x] = i;
-        set = false;
+    if (!wait_flag || keys[wait_key]) {
+        pc -= INSTRUCTION_SIZE;
+        events |= EVENT_KEY_WAIT;
+        MIC8_PROBE2(key_wait, trace_id, pc);
+    } else {
+        reg[x] = wait_key;
+        wait_flag = false;
     }
 }
 
 void chip8::op_Fx15() {
     const std::uint8_t x = (instruction & 0x0F00u) >> 8u;
-    instruction_string = std::format("0x{:X} - {:X} -> delay := v{:X}", pc, instruction, x);
     dt = reg[x];
 }
 
 void chip8::op_Fx18() {
     const std::uint8_t x = (instruction & 0x0F00u) >> 8u;
-    instruction_string = std::format("0x{:X} - {:X} -> buzzer := v{:X}", pc, instruction, x);
     st = reg[x];
 }
 
 void chip8::op_Fx1E() {
     const std::uint8_t x = (instruction & 0x0F00u) >> 8u;
-    instruction_string = std::format("0x{:X} - {:X} -> i += v{:X}", pc, instruction, x);
     ir += reg[x];
     reg[0xF] = static_cast<std::uint8_t>(ir + reg[x] > std::numeric_limits<std::uint8_t>::max());
 }
 
 void chip8::op_Fx29() {
     const std::uint8_t x = (instruction & 0x0F00u) >> 8u;
-    instruction_string = std::format("0x{:X} - {:X} -> i := hex v{:X}", pc, instruction, x);
     ir = FONTSET_ADDR + static_cast<std::size_t>(reg[x] * 5);
 }
 
 void chip8::op_Fx33() {
     const std::uint8_t x = (instruction & 0x0F00u) >> 8u;
-    instruction_string = std::format("0x{:X} - {:X} -> bcd v{:X}", pc, instruction, x);
-    mem[ir] = reg[x] / 100;
-    mem[ir + 1] = reg[x] / 10 % 10;
-    mem[ir + 2] = reg[x] % 10;
+    mem_at(ir) = reg[x] / 100;
+    mem_at(ir + 1) = reg[x] / 10 % 10;
+    mem_at(ir + 2) = reg[x] % 10;
 }
 
 void chip8::op_Fx55() {
     const std::uint8_t x = (instruction & 0x0F00u) >> 8u;
-    instruction_string = std::format("0x{:X} - {:X} -> save v{:X}", pc, instruction, x);
     for (unsigned char i = 0; i <= x; ++i) {
-        mem[ir + i] = reg[i];
+        mem_at(ir + i) = reg[i];
     }
     ir += x + 1;
 }
 
 void chip8::op_Fx65() {
     const std::uint8_t x = (instruction & 0x0F00u) >> 8u;
-    instruction_string = std::format("0x{:X} - {:X} -> load v{:X}", pc, instruction, x);
     for (unsigned char i = 0; i <= x; ++i) {
-        reg[i] = mem[ir + i];
+        reg[i] = mem_at(ir + i);
     }
     ir += x + 1;
 }
@@ -384,7 +812,6 @@ void chip8::op_8xy3_VIP() {
 
 void chip8::op_8xy6_CHIP48() {
     const std::uint8_t x = (instruction & 0x0F00u) >> 8u;
-    instruction_string = std::format("0x{:X} - {:X} -> v{:X} >>= 1", pc, instruction, x);
     const uint8_t car = reg[x] & 1u;
     reg[x] >>= 1u;
     reg[0xF] = car;
@@ -392,7 +819,6 @@ void chip8::op_8xy6_CHIP48() {
 
 void chip8::op_8xyE_CHIP48() {
     const std::uint8_t x = (instruction & 0x0F00u) >> 8u;
-    instruction_string = std::format("0x{:X} - {:X} -> v{:X} <<= 1", pc, instruction, x);
     const std::uint8_t car = reg[x] >> 7u;
     reg[x] <<= 1u;
     reg[0xF] = car;
@@ -401,40 +827,138 @@ void chip8::op_8xyE_CHIP48() {
 void chip8::op_Bxnn_CHIP48() {
     const std::uint8_t x = (instruction & 0x0F00u) >> 8u;
     const std::uint8_t nn = instruction & 0x00FFu;
-    instruction_string = std::format("0x{:X} - {:X} -> jump0 0x{:2X} + v{:X}", pc, instruction, nn, x);
     pc = reg[x] + (x << 8u | nn);
 }
 
 void chip8::op_Fx55_CHIP48() {
     const std::uint8_t x = (instruction & 0x0F00u) >> 8u;
-    instruction_string = std::format("0x{:X} - {:X} -> save v{:X}", pc, instruction, x);
     for (unsigned char i = 0; i <= x; ++i) {
-        mem[ir + i] = reg[i];
+        mem_at(ir + i) = reg[i];
     }
     ir += x;
 }
 
 void chip8::op_Fx65_CHIP48() {
     const std::uint8_t x = (instruction & 0x0F00u) >> 8u;
-    instruction_string = std::format("0x{:X} - {:X} -> load v{:X}", pc, instruction, x);
     for (unsigned char i = 0; i <= x; ++i) {
-        reg[i] = mem[ir + i];
+        reg[i] = mem_at(ir + i);
     }
     ir += x;
 }
 
 void chip8::op_Fx55_SCHIP11() {
     const std::uint8_t x = (instruction & 0x0F00u) >> 8u;
-    instruction_string = std::format("0x{:X} - {:X} -> save v{:X}", pc, instruction, x);
     for (unsigned char i = 0; i <= x; ++i) {
-        mem[ir + i] = reg[i];
+        mem_at(ir + i) = reg[i];
     }
 }
 
 void chip8::op_Fx65_SCHIP11() {
     const std::uint8_t x = (instruction & 0x0F00u) >> 8u;
-    instruction_string = std::format("0x{:X} - {:X} -> load v{:X}", pc, instruction, x);
     for (unsigned char i = 0; i <= x; ++i) {
-        reg[i] = mem[ir + i];
+        reg[i] = mem_at(ir + i);
+    }
+}
+
+void chip8::op_00Cn() {
+    const std::uint8_t n = instruction & 0x000Fu;
+    scroll_vertical(n);
+}
+
+void chip8::op_00FB() {
+    scroll_horizontal(4);
+}
+
+void chip8::op_00FC() {
+    scroll_horizontal(-4);
+}
+
+void chip8::op_00FD() {
+    hlt_flag = true;
+}
+
+void chip8::op_00FE() {
+    for (auto &plane: fb) { plane.fill(0u); }
+    hires = false;
+    mark_drawn();
+}
+
+void chip8::op_00FF() {
+    for (auto &plane: fb) { plane.fill(0u); }
+    hires = true;
+    mark_drawn();
+}
+
+void chip8::op_Fx30() {
+    const std::uint8_t x = (instruction & 0x0F00u) >> 8u;
+    ir = BIG_FONTSET_ADDR + static_cast<std::size_t>((reg[x] & 0xFu) * 10);
+}
+
+void chip8::op_Fx75() {
+    const std::uint8_t x = (instruction & 0x0F00u) >> 8u;
+    for (unsigned char i = 0; i <= x; ++i) {
+        flags[i] = reg[i];
+    }
+}
+
+void chip8::op_Fx85() {
+    const std::uint8_t x = (instruction & 0x0F00u) >> 8u;
+    for (unsigned char i = 0; i <= x; ++i) {
+        reg[i] = flags[i];
+    }
+}
+
+void chip8::op_00Dn() {
+    const std::uint8_t n = instruction & 0x000Fu;
+    scroll_vertical(-n);
+}
+
+void chip8::op_5xy2() {
+    const std::uint8_t x = (instruction & 0x0F00u) >> 8u;
+    const std::uint8_t y = (instruction & 0x00F0u) >> 4u;
+    const int step = x <= y ? 1 : -1;
+    for (int i = x, offset = 0; ; i += step, ++offset) {
+        mem_at(ir + offset) = reg[i];
+        if (i == y) { break; }
+    }
+}
+
+void chip8::op_5xy3() {
+    const std::uint8_t x = (instruction & 0x0F00u) >> 8u;
+    const std::uint8_t y = (instruction & 0x00F0u) >> 4u;
+    const int step = x <= y ? 1 : -1;
+    for (int i = x, offset = 0; ; i += step, ++offset) {
+        reg[i] = mem_at(ir + offset);
+        if (i == y) { break; }
+    }
+}
+
+void chip8::op_F000() {
+    if (instruction != 0xF000u) {
+        op_null();
+        return;
     }
+    const std::uint16_t nnnn = mem_at(pc) << 8u | mem_at(pc + 1u);
+    ir = nnnn;
+    pc += INSTRUCTION_SIZE;
+}
+
+void chip8::op_Fn01() {
+    const std::uint8_t n = (instruction & 0x0F00u) >> 8u;
+    planes = n & 0x3u;
+}
+
+void chip8::op_F002() {
+    if (instruction != 0xF002u) {
+        op_null();
+        return;
+    }
+    for (std::size_t i = 0; i < PATTERN_SIZE; ++i) {
+        pattern[i] = mem_at(ir + i);
+    }
+}
+
+void chip8::op_Fx3A() {
+    const std::uint8_t x = (instruction & 0x0F00u) >> 8u;
+    pitch = reg[x];
 }
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <algorithm>
 #include <array>
 #include <chrono>
 #include <cstddef>
@@ -8,19 +9,29 @@
 #include <span>
 #include <string>
 #include <string_view>
+#include <vector>
 
-class chip8 {
+class alignas(64) chip8 {
 public:
     static constexpr std::size_t MEM_SIZE{0x1000};
+    static constexpr std::size_t XO_MEM_SIZE{0x10000};
     static constexpr std::size_t ROM_ADDR{0x200};
     static constexpr std::size_t FONTSET_SIZE{0x50};
     static constexpr std::size_t FONTSET_ADDR{0x50};
+    static constexpr std::size_t BIG_FONTSET_SIZE{0xA0};
+    static constexpr std::size_t BIG_FONTSET_ADDR{0xA0};
     static constexpr std::size_t REG_COUNT{0x10};
+    static constexpr std::size_t FLAG_COUNT{0x10};
     static constexpr std::size_t STACK_SIZE{0x10};
     static constexpr std::size_t INSTRUCTION_SIZE{2};
     static constexpr std::size_t KEY_COUNT{0x10};
     static constexpr std::size_t VIDEO_WIDTH{64};
     static constexpr std::size_t VIDEO_HEIGHT{32};
+    static constexpr std::size_t HIRES_WIDTH{128};
+    static constexpr std::size_t HIRES_HEIGHT{64};
+    static constexpr std::size_t ROW_WORDS{HIRES_WIDTH / 64};
+    static constexpr std::size_t PLANE_COUNT{2};
+    static constexpr std::size_t PATTERN_SIZE{0x10};
 
     enum class ls_mode : unsigned char {
         chip8_ls,
@@ -28,11 +39,43 @@ public:
         schip11_ls
     };
 
+    enum class variant : unsigned char {
+        chip8,
+        schip,
+        xochip
+    };
+
     using alt_t = struct {
         bool vip_alu{};
         bool chip48_jmp{};
         bool chip48_shf{true};
         ls_mode ls_mode{ls_mode::chip48_ls};
+        variant variant{variant::chip8};
+    };
+
+    enum class stop_reason : unsigned char {
+        budget,
+        halted,
+        key_wait,
+        breakpoint,
+        draw
+    };
+
+    struct run_result {
+        stop_reason reason;
+        std::uint64_t cycles;
+    };
+
+    // each row is ROW_WORDS words, most significant bit of the first word is the leftmost pixel
+    using plane_t = std::array<std::uint64_t, ROW_WORDS * HIRES_HEIGHT>;
+
+    // an instruction that ran, kept as is and described only when shown, so running one allocates nothing
+    struct executed {
+        // where execution went on from unless it jumped, the address descriptions show
+        std::uint16_t pc;
+        std::uint16_t instruction;
+        // the word after it, the address xochip's F000 loads
+        std::uint16_t operand;
     };
 
     std::array<bool, KEY_COUNT> keys{};
@@ -40,19 +83,47 @@ public:
 
     explicit chip8(alt_t alt_ops);
 
-    [[nodiscard]] constexpr auto get_instruction() const -> std::string { return instruction_string; }
+    // the last instruction run by the interpreter, pc is 0 if there was none
+    [[nodiscard]] auto get_executed() const -> executed;
+
+    // writes as much of the description of op as fits into out, as run under this interpreter's quirks, and
+    // returns the length written
+    auto describe(const executed &op, std::span<char> out) const -> std::size_t;
+
+    // the description of the last instruction, empty if there was none
+    [[nodiscard]] auto get_instruction() const -> std::string;
+
     [[nodiscard]] constexpr auto get_mem() const -> std::span<const std::uint8_t> { return mem; }
-    [[nodiscard]] constexpr auto get_fb() const -> std::span<const std::uint32_t> { return fb; }
+    [[nodiscard]] constexpr auto get_fb() const -> std::span<const plane_t> { return fb; }
     [[nodiscard]] constexpr auto get_stack() const -> std::span<const std::uint16_t> { return stack; }
     [[nodiscard]] constexpr auto get_reg() const -> std::span<const std::uint8_t> { return reg; }
+    [[nodiscard]] constexpr auto get_pattern() const -> std::span<const std::uint8_t> { return pattern; }
     [[nodiscard]] constexpr auto get_pc() const -> std::uint16_t { return pc; }
     [[nodiscard]] constexpr auto get_ir() const -> std::uint16_t { return ir; }
     [[nodiscard]] constexpr auto get_sp() const -> std::uint8_t { return sp; }
     [[nodiscard]] constexpr auto get_dt() const -> std::uint8_t { return dt; }
     [[nodiscard]] constexpr auto get_st() const -> std::uint8_t { return st; }
+    [[nodiscard]] constexpr auto get_pitch() const -> std::uint8_t { return pitch; }
+    [[nodiscard]] constexpr auto get_planes() const -> std::uint8_t { return planes; }
+    [[nodiscard]] constexpr auto get_hires() const -> bool { return hires; }
+    [[nodiscard]] constexpr auto get_width() const -> std::size_t { return hires ? HIRES_WIDTH : VIDEO_WIDTH; }
+    [[nodiscard]] constexpr auto get_height() const -> std::size_t { return hires ? HIRES_HEIGHT : VIDEO_HEIGHT; }
     [[nodiscard]] constexpr auto get_halt_flag() const -> bool { return hlt_flag; }
 
-    auto run_cycle() -> void;
+    // the id the USDT probes in probes.hpp report for this interpreter, up to the frontend; not part of the state
+    [[nodiscard]] constexpr auto get_trace_id() const -> std::uint32_t { return trace_id; }
+
+    void set_trace_id(const std::uint32_t id) { trace_id = id; }
+
+    auto seed(std::minstd_rand::result_type value) -> void;
+
+    // runs until the budget is spent, the interpreter halts or waits for a key, the next instruction is a
+    // breakpoint, or (when asked) a draw happens; the stopping cycle itself has already executed
+    auto run_cycles(std::uint64_t budget, bool stop_on_draw = false) -> run_result;
+
+    auto set_breakpoint(std::uint16_t addr, bool enabled) -> void;
+
+    auto clear_breakpoints() -> void;
 
     auto decrement_timers() -> void;
 
@@ -62,49 +133,76 @@ public:
 
     auto unload_rom() -> void;
 
+    // everything needed to resume exactly, breakpoints included, in native byte order for this process only
+    [[nodiscard]] auto save_state() const -> std::vector<std::uint8_t>;
+
+    // throws unless state came from save_state on an interpreter of the same variant
+    auto load_state(std::span<const std::uint8_t> state) -> void;
+
 private:
+    // compiled ROMs read and write the registers directly
+    friend struct aot_access;
+
     using op_type = void (chip8::*)();
 
-    std::default_random_engine rng{std::random_device{}()};
-    std::string instruction_string;
-    std::uint16_t instruction{};
+    enum : std::uint8_t {
+        EVENT_DRAW = 1u << 0u,
+        EVENT_KEY_WAIT = 1u << 1u
+    };
 
-    std::array<std::uint8_t, MEM_SIZE> mem = [] consteval {
-        auto mem_ = decltype(mem){};
-        std::array<std::uint8_t, FONTSET_SIZE> fontset{
-                //@formatter:off
-            0xF0, 0x90, 0x90, 0x90, 0xF0,
-            0x20, 0x60, 0x20, 0x20, 0x70,
-            0xF0, 0x10, 0xF0, 0x80, 0xF0,
-            0xF0, 0x10, 0xF0, 0x10, 0xF0,
-            0x90, 0x90, 0xF0, 0x10, 0x10,
-            0xF0, 0x80, 0xF0, 0x10, 0xF0,
-            0xF0, 0x80, 0xF0, 0x90, 0xF0,
-            0xF0, 0x10, 0x20, 0x40, 0x40,
-            0xF0, 0x90, 0xF0, 0x90, 0xF0,
-            0xF0, 0x90, 0xF0, 0x10, 0xF0,
-            0xF0, 0x90, 0xF0, 0x90, 0x90,
-            0xE0, 0x90, 0xE0, 0x90, 0xE0,
-            0xF0, 0x80, 0x80, 0x80, 0xF0,
-            0xE0, 0x90, 0x90, 0x90, 0xE0,
-            0xF0, 0x80, 0xF0, 0x80, 0xF0,
-            0xF0, 0x80, 0xF0, 0x80, 0x80
-            //@formatter:on
-        };
-        std::ranges::copy(fontset, mem_.begin() + FONTSET_ADDR);
-        return mem_;
-    }();
-
-    std::array<std::uint32_t, VIDEO_WIDTH * VIDEO_HEIGHT> fb{};
-    std::array<std::uint16_t, STACK_SIZE> stack{};
+    struct dispatch_table;
+
+    // Ordered by how often a cycle touches them. After the public keys and drw_flag, the first cache line holds the
+    // registers, flags and dispatch table, and the second the memory and breakpoint vectors, so an instance that
+    // has been evicted costs two line fills to resume. Everything after is only read by some instructions.
     std::array<std::uint8_t, REG_COUNT> reg{};
     std::uint16_t pc{ROM_ADDR};
     std::uint16_t ir{};
+    std::uint16_t instruction{};
     std::uint8_t sp{};
     std::uint8_t dt{};
     std::uint8_t st{};
-
+    std::uint8_t wait_key{};
+    std::uint8_t events{};
     bool hlt_flag{false};
+    bool wait_flag{false};
+    bool hires{false};
+    variant var;
+    std::uint8_t pitch{64};
+    std::uint8_t planes{1};
+    // pc after the last fetch, in what was padding before ops
+    std::uint16_t executed_pc{};
+    const dispatch_table *ops;
+
+    std::vector<std::uint8_t> mem;
+    std::vector<bool> breakpoints;
+
+    std::array<std::uint16_t, STACK_SIZE> stack{};
+    std::array<std::uint8_t, PATTERN_SIZE> pattern{};
+    std::array<std::uint8_t, FLAG_COUNT> flags{};
+    std::minstd_rand rng{std::random_device{}()};
+    std::array<plane_t, PLANE_COUNT> fb{};
+    // in the tail padding, so adding it moved nothing compiled ROMs address
+    std::uint32_t trace_id{};
+
+    void run_cycle();
+
+    // the handler instruction dispatches to, through the sub-tables
+    [[nodiscard]] auto handler_for(std::uint16_t instruction) const -> op_type;
+
+    // sets the draw flags and fires the draw probe
+    void mark_drawn();
+
+    // addresses wrap at the end of memory, whose size is a power of two
+    [[nodiscard]] auto mem_at(const std::size_t addr) -> std::uint8_t & { return mem[addr & (mem.size() - 1)]; }
+
+    void skip();
+
+    void scroll_vertical(int rows);
+
+    void scroll_horizontal(int cols);
+
+    void op_arr_5();
 
     void op_arr_0();
 
@@ -204,71 +302,120 @@ private:
 
     void op_Fx65_SCHIP11();
 
-    std::array<op_type, 0xF + 1> OP_ARR_MAIN = [] consteval {
-        auto OP_ARR_MAIN_ = decltype(OP_ARR_MAIN){};
-        OP_ARR_MAIN_.fill(&chip8::op_null);
-        OP_ARR_MAIN_[0x0] = &chip8::op_arr_0;
-        OP_ARR_MAIN_[0x1] = &chip8::op_1nnn;
-        OP_ARR_MAIN_[0x2] = &chip8::op_2nnn;
-        OP_ARR_MAIN_[0x3] = &chip8::op_3xnn;
-        OP_ARR_MAIN_[0x4] = &chip8::op_4xnn;
-        OP_ARR_MAIN_[0x5] = &chip8::op_5xy0;
-        OP_ARR_MAIN_[0x6] = &chip8::op_6xnn;
-        OP_ARR_MAIN_[0x7] = &chip8::op_7xnn;
-        OP_ARR_MAIN_[0x8] = &chip8::op_arr_8;
-        OP_ARR_MAIN_[0x9] = &chip8::op_9xy0;
-        OP_ARR_MAIN_[0xA] = &chip8::op_Annn;
-        OP_ARR_MAIN_[0xB] = &chip8::op_Bnnn;
-        OP_ARR_MAIN_[0xC] = &chip8::op_Cxnn;
-        OP_ARR_MAIN_[0xD] = &chip8::op_Dxyn;
-        OP_ARR_MAIN_[0xE] = &chip8::op_arr_E;
-        OP_ARR_MAIN_[0xF] = &chip8::op_arr_F;
-        return OP_ARR_MAIN_;
-    }();
-
-    std::array<op_type, 0xEE + 1> OP_ARR_0 = [] consteval {
-        auto OP_ARR_0_ = decltype(OP_ARR_0){};
-        OP_ARR_0_.fill(&chip8::op_null);
-        OP_ARR_0_[0xE0] = &chip8::op_00E0;
-        OP_ARR_0_[0xEE] = &chip8::op_00EE;
-        return OP_ARR_0_;
-    }();
-
-    std::array<op_type, 0xE + 1> OP_ARR_8 = [] consteval {
-        auto OP_ARR_8_ = decltype(OP_ARR_8){};
-        OP_ARR_8_.fill(&chip8::op_null);
-        OP_ARR_8_[0x0] = &chip8::op_8xy0;
-        OP_ARR_8_[0x1] = &chip8::op_8xy1;
-        OP_ARR_8_[0x2] = &chip8::op_8xy2;
-        OP_ARR_8_[0x3] = &chip8::op_8xy3;
-        OP_ARR_8_[0x4] = &chip8::op_8xy4;
-        OP_ARR_8_[0x5] = &chip8::op_8xy5;
-        OP_ARR_8_[0x6] = &chip8::op_8xy6;
-        OP_ARR_8_[0x7] = &chip8::op_8xy7;
-        OP_ARR_8_[0xE] = &chip8::op_8xyE;
-        return OP_ARR_8_;
-    }();
-
-    std::array<op_type, 0xE + 1> OP_ARR_E = [] consteval {
-        auto OP_ARR_E_ = decltype(OP_ARR_E){};
-        OP_ARR_E_.fill(&chip8::op_null);
-        OP_ARR_E_[0x1] = &chip8::op_ExA1;
-        OP_ARR_E_[0xE] = &chip8::op_Ex9E;
-        return OP_ARR_E_;
-    }();
-
-    std::array<op_type, 0x65 + 1> OP_ARR_F = [] consteval {
-        auto OP_ARR_F_ = decltype(OP_ARR_F){};
-        OP_ARR_F_.fill(&chip8::op_null);
-        OP_ARR_F_[0x07] = &chip8::op_Fx07;
-        OP_ARR_F_[0x0A] = &chip8::op_Fx0A;
-        OP_ARR_F_[0x15] = &chip8::op_Fx15;
-        OP_ARR_F_[0x18] = &chip8::op_Fx18;
-        OP_ARR_F_[0x1E] = &chip8::op_Fx1E;
-        OP_ARR_F_[0x29] = &chip8::op_Fx29;
-        OP_ARR_F_[0x33] = &chip8::op_Fx33;
-        OP_ARR_F_[0x55] = &chip8::op_Fx55;
-        OP_ARR_F_[0x65] = &chip8::op_Fx65;
-        return OP_ARR_F_;
-    }();
+    void op_00Cn();
+
+    void op_00FB();
+
+    void op_00FC();
+
+    void op_00FD();
+
+    void op_00FE();
+
+    void op_00FF();
+
+    void op_Fx30();
+
+    void op_Fx75();
+
+    void op_Fx85();
+
+    void op_00Dn();
+
+    void op_5xy2();
+
+    void op_5xy3();
+
+    void op_F000();
+
+    void op_Fn01();
+
+    void op_F002();
+
+    void op_Fx3A();
+
+    // the handlers for one combination of quirks, patched from these defaults by make_dispatch
+    struct dispatch_table {
+        std::array<op_type, 0xF + 1> OP_ARR_MAIN = [] consteval {
+            auto OP_ARR_MAIN_ = decltype(OP_ARR_MAIN){};
+            OP_ARR_MAIN_.fill(&chip8::op_null);
+            OP_ARR_MAIN_[0x0] = &chip8::op_arr_0;
+            OP_ARR_MAIN_[0x1] = &chip8::op_1nnn;
+            OP_ARR_MAIN_[0x2] = &chip8::op_2nnn;
+            OP_ARR_MAIN_[0x3] = &chip8::op_3xnn;
+            OP_ARR_MAIN_[0x4] = &chip8::op_4xnn;
+            OP_ARR_MAIN_[0x5] = &chip8::op_5xy0;
+            OP_ARR_MAIN_[0x6] = &chip8::op_6xnn;
+            OP_ARR_MAIN_[0x7] = &chip8::op_7xnn;
+            OP_ARR_MAIN_[0x8] = &chip8::op_arr_8;
+            OP_ARR_MAIN_[0x9] = &chip8::op_9xy0;
+            OP_ARR_MAIN_[0xA] = &chip8::op_Annn;
+            OP_ARR_MAIN_[0xB] = &chip8::op_Bnnn;
+            OP_ARR_MAIN_[0xC] = &chip8::op_Cxnn;
+            OP_ARR_MAIN_[0xD] = &chip8::op_Dxyn;
+            OP_ARR_MAIN_[0xE] = &chip8::op_arr_E;
+            OP_ARR_MAIN_[0xF] = &chip8::op_arr_F;
+            return OP_ARR_MAIN_;
+        }();
+
+        std::array<op_type, 0xF + 1> OP_ARR_5 = [] consteval {
+            auto OP_ARR_5_ = decltype(OP_ARR_5){};
+            OP_ARR_5_.fill(&chip8::op_null);
+            OP_ARR_5_[0x0] = &chip8::op_5xy0;
+            OP_ARR_5_[0x2] = &chip8::op_5xy2;
+            OP_ARR_5_[0x3] = &chip8::op_5xy3;
+            return OP_ARR_5_;
+        }();
+
+        std::array<op_type, 0xFF + 1> OP_ARR_0 = [] consteval {
+            auto OP_ARR_0_ = decltype(OP_ARR_0){};
+            OP_ARR_0_.fill(&chip8::op_null);
+            OP_ARR_0_[0xE0] = &chip8::op_00E0;
+            OP_ARR_0_[0xEE] = &chip8::op_00EE;
+            return OP_ARR_0_;
+        }();
+
+        std::array<op_type, 0xF + 1> OP_ARR_8 = [] consteval {
+            auto OP_ARR_8_ = decltype(OP_ARR_8){};
+            OP_ARR_8_.fill(&chip8::op_null);
+            OP_ARR_8_[0x0] = &chip8::op_8xy0;
+            OP_ARR_8_[0x1] = &chip8::op_8xy1;
+            OP_ARR_8_[0x2] = &chip8::op_8xy2;
+            OP_ARR_8_[0x3] = &chip8::op_8xy3;
+            OP_ARR_8_[0x4] = &chip8::op_8xy4;
+            OP_ARR_8_[0x5] = &chip8::op_8xy5;
+            OP_ARR_8_[0x6] = &chip8::op_8xy6;
+            OP_ARR_8_[0x7] = &chip8::op_8xy7;
+            OP_ARR_8_[0xE] = &chip8::op_8xyE;
+            return OP_ARR_8_;
+        }();
+
+        std::array<op_type, 0xF + 1> OP_ARR_E = [] consteval {
+            auto OP_ARR_E_ = decltype(OP_ARR_E){};
+            OP_ARR_E_.fill(&chip8::op_null);
+            OP_ARR_E_[0x1] = &chip8::op_ExA1;
+            OP_ARR_E_[0xE] = &chip8::op_Ex9E;
+            return OP_ARR_E_;
+        }();
+
+        std::array<op_type, 0xFF + 1> OP_ARR_F = [] consteval {
+            auto OP_ARR_F_ = decltype(OP_ARR_F){};
+            OP_ARR_F_.fill(&chip8::op_null);
+            OP_ARR_F_[0x07] = &chip8::op_Fx07;
+            OP_ARR_F_[0x0A] = &chip8::op_Fx0A;
+            OP_ARR_F_[0x15] = &chip8::op_Fx15;
+            OP_ARR_F_[0x18] = &chip8::op_Fx18;
+            OP_ARR_F_[0x1E] = &chip8::op_Fx1E;
+            OP_ARR_F_[0x29] = &chip8::op_Fx29;
+            OP_ARR_F_[0x33] = &chip8::op_Fx33;
+            OP_ARR_F_[0x55] = &chip8::op_Fx55;
+            OP_ARR_F_[0x65] = &chip8::op_Fx65;
+            return OP_ARR_F_;
+        }();
+    };
+
+    // one table per combination of quirks, built on first use and shared by every instance with those quirks
+    static auto dispatch_for(const alt_t &alt_ops) -> const dispatch_table &;
+
+    static auto make_dispatch(const alt_t &alt_ops) -> dispatch_table;
 };
@@ -0,0 +1,69 @@
+// Runs the Wasm core off the main thread. The module's memory is a SharedArrayBuffer, which is posted to the page
+// once so it can render straight from the pixel buffer without a copy per frame.
+importScripts('mic8_core.js');
+
+const FRAME_MS = 1000 / 60;
+const STOP_HALTED = 1;
+
+let core = null;
+const ready = create_mic8_core().then((module) => {
+    core = module;
+    postMessage({
+        type: 'ready',
+        memory: core.HEAPU8.buffer,
+        pixels: core._mic8_pixels(),
+        frameCount: core._mic8_frame_count()
+    });
+});
+let cyclesPerFrame = 1000;
+let timer = null;
+let nextFrame = 0;
+
+function tick() {
+    // catch up on frames missed while the worker was busy, but never more than a few at once
+    const now = performance.now();
+    let frames = 0;
+    while (nextFrame <= now && frames < 4) {
+        if (core._mic8_run_frame(cyclesPerFrame) === STOP_HALTED) {
+            stop();
+            postMessage({type: 'halted', cycles: core._mic8_cycles()});
+            return;
+        }
+        nextFrame += FRAME_MS;
+        ++frames;
+    }
+    if (nextFrame <= now) { nextFrame = now + FRAME_MS; }
+    timer = setTimeout(tick, Math.max(0, nextFrame - performance.now()));
+}
+
+function stop() {
+    if (timer !== null) {
+        clearTimeout(timer);
+        timer = null;
+    }
+}
+
+onmessage = async (e) => {
+    const msg = e.data;
+    await ready;
+    switch (msg.type) {
+        case 'load':
+            stop();
+            core._mic8_create(msg.variant, msg.seed);
+            core.FS.writeFile('/rom', new Uint8Array(msg.rom));
+            if (core.ccall('mic8_load', 'number', ['string'], ['/rom']) !== 0) {
+                postMessage({type: 'error', message: 'Failed to load the ROM!'});
+                return;
+            }
+            cyclesPerFrame = msg.cyclesPerFrame;
+            nextFrame = performance.now();
+            tick();
+            break;
+        case 'key':
+            core._mic8_set_key(msg.key, msg.down ? 1 : 0);
+            break;
+        case 'stats':
+            postMessage({type: 'stats', cycles: core._mic8_cycles()});
+            break;
+    }
+};
@@ -0,0 +1,216 @@
+#include "hash.hpp"
+#include "headless.hpp"
+#include "shard_pool.hpp"
+#include "shared_frame.hpp"
+#include "telemetry.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <format>
+#include <memory>
+#include <random>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace {
+    struct options {
+        shard_pool::options pool{"./mic8_server.elf", std::max(1u, std::thread::hardware_concurrency())};
+        std::size_t instances{1};
+        std::uint64_t frames{600};
+        std::uint64_t batch{1};
+        std::uint32_t seed{1};
+        bool keys{};
+        bool restart{};
+        std::string telemetry;
+        std::vector<std::string> paths;
+    };
+
+    auto parse_options(const std::span<char *> args) -> options {
+        options opts;
+        for (std::size_t i = 1; i < args.size(); ++i) {
+            const std::string_view arg = args[i];
+            const auto value = [&] {
+                if (i + 1 >= args.size()) { throw std::invalid_argument(std::format("Missing value for {}", arg)); }
+                return std::string_view(args[++i]);
+            };
+            if (arg == "--shards") {
+                opts.pool.shards = std::max<std::uint64_t>(1, headless::parse_number(value()));
+            } else if (arg == "--instances") {
+                opts.instances = headless::parse_number(value());
+            } else if (arg == "--frames") {
+                opts.frames = headless::parse_number(value());
+            } else if (arg == "--batch") {
+                opts.batch = std::max<std::uint64_t>(1, headless::parse_number(value()));
+            } else if (arg == "--cpf") {
+                opts.pool.cycles_per_frame = std::max<std::uint64_t>(1, headless::parse_number(value()));
+            } else if (arg == "--seed") {
+                opts.seed = static_cast<std::uint32_t>(headless::parse_number(value()));
+            } else if (arg == "--server") {
+                opts.pool.server = value();
+            } else if (arg == "--timeout") {
+                opts.pool.timeout = std::chrono::milliseconds(headless::parse_number(value()));
+            } else if (arg == "--no-pin") {
+                opts.pool.pin = false;
+            } else if (arg == "--keys") {
+                opts.keys = true;
+            } else if (arg == "--restart") {
+                opts.restart = true;
+            } else if (arg == "--telemetry") {
+                opts.telemetry = value();
+            } else if (arg.starts_with("--")) {
+                throw std::invalid_argument(std::format("Unknown option: {}", arg));
+            } else {
+                opts.paths.emplace_back(arg);
+            }
+        }
+        return opts;
+    }
+
+    // what an instance last published, read out of its shard's shared memory
+    struct published {
+        std::uint64_t frame{};
+        std::uint64_t cycles{};
+        std::uint64_t fb_hash{};
+        bool halted{};
+    };
+
+    auto read_published(const shard_pool &pool, const std::size_t index, published &out) -> bool {
+        return pool.read_frame(index, [&out](const shared_frame &frame) {
+            out.frame = frame.frame;
+            out.cycles = frame.cycles;
+            out.fb_hash = hash::fnv1a(std::as_bytes(std::span(frame.fb)));
+            out.halted = (frame.flags & shared_frame::FLAG_HALTED) != 0;
+        });
+    }
+
+    auto state_name(const shard_pool &pool, const std::size_t index) -> std::string_view {
+        const auto &inst = pool.get_instances()[index];
+        if (inst.lost) { return "lost"; }
+        return inst.halted ? "halted" : "running";
+    }
+
+    class telemetry_sampler {
+    public:
+        explicit telemetry_sampler(const std::string &path, const std::size_t instances)
+            : writer(path), last_cycles(instances) {}
+
+        // instances run unthrottled, so there is no target rate
+        void sample(const shard_pool &pool) {
+            const auto now = std::chrono::steady_clock::now();
+            const auto seconds = std::chrono::duration<double>(now - last_time).count();
+            if (seconds < 1) { return; }
+            std::vector<telemetry_row> rows;
+            telemetry_row totals{pool.get_instances().size(), "fleet", 0, {}, 0};
+            for (std::size_t i = 0; i < pool.get_instances().size(); ++i) {
+                published now_published;
+                telemetry_row row{i, state_name(pool, i), 0, {}, 0};
+                if (read_published(pool, i, now_published)) {
+                    // an instance recreated by --restart counts from 0 again
+                    if (now_published.cycles < last_cycles[i]) { last_cycles[i] = 0; }
+                    row.rates.ips = static_cast<double>(now_published.cycles - last_cycles[i]) / seconds;
+                    last_cycles[i] = now_published.cycles;
+                } else {
+                    last_cycles[i] = 0;
+                }
+                totals.rates.ips += row.rates.ips;
+                rows.push_back(row);
+            }
+            writer.write(rows, totals);
+            last_time = now;
+        }
+
+    private:
+        telemetry_writer writer;
+        std::vector<std::uint64_t> last_cycles;
+        std::chrono::steady_clock::time_point last_time{std::chrono::steady_clock::now()};
+    };
+}
+
+// runs a fleet of instances across worker processes and aggregates what they publish, a fleet hash that does not
+// depend on the number of shards shows the sharding is transparent
+auto main(int argc, char *argv[]) -> int {
+    try {
+        const auto opts = parse_options(std::span(argv, static_cast<std::size_t>(argc)));
+        if (opts.paths.empty()) {
+            std::fputs("usage: mic8_fleet.elf [--shards n] [--instances n per ROM] [--frames n] [--batch frames] "
+                       "[--cpf n] [--seed n] [--server path] [--timeout ms] [--no-pin] [--keys] [--restart] "
+                       "[--telemetry file.json|file.csv] rom|dir...\n",
+                       stderr);
+            return 2;
+        }
+        shard_pool pool(opts.pool);
+        std::uint32_t seed = opts.seed;
+        for (const auto &rom: headless::collect_roms(opts.paths)) {
+            for (std::size_t i = 0; i < opts.instances; ++i) {
+                pool.add(rom.string(), headless::guess_variant(rom), seed++);
+            }
+        }
+        std::unique_ptr<telemetry_sampler> sampler;
+        if (!opts.telemetry.empty()) {
+            sampler = std::make_unique<telemetry_sampler>(opts.telemetry, pool.get_instances().size());
+        }
+
+        std::minstd_rand rng(opts.seed);
+        const auto start = std::chrono::steady_clock::now();
+        for (std::uint64_t frame = 0; frame < opts.frames; frame += opts.batch) {
+            if (opts.keys) {
+                for (std::size_t i = 0; i < pool.get_instances().size(); ++i) {
+                    pool.set_keys(i, static_cast<std::uint16_t>(1u << rng() % chip8::KEY_COUNT));
+                }
+            }
+            pool.run(std::min(opts.batch, opts.frames - frame));
+            if (opts.restart) {
+                for (std::size_t s = 0; s < pool.get_shards().size(); ++s) {
+                    if (pool.get_shards()[s].state != shard_pool::shard_state::running) { pool.restart(s); }
+                }
+            }
+            if (sampler) { sampler->sample(pool); }
+        }
+        const auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        // the per-shard totals come from shared memory rather than the replies, as a consumer of the frames sees them
+        std::vector<published> shard_totals(pool.get_shards().size());
+        std::uint64_t fleet_hash = hash::FNV_OFFSET;
+        std::size_t lost = 0;
+        for (std::size_t i = 0; i < pool.get_instances().size(); ++i) {
+            published p;
+            if (!read_published(pool, i, p)) {
+                ++lost;
+                continue;
+            }
+            auto &total = shard_totals[pool.get_instances()[i].shard];
+            total.frame += p.frame;
+            total.cycles += p.cycles;
+            fleet_hash = hash::fnv1a_of(p.fb_hash, fleet_hash);
+        }
+
+        std::uint64_t total_frames = 0;
+        std::uint64_t total_cycles = 0;
+        for (std::size_t s = 0; s < pool.get_shards().size(); ++s) {
+            const auto &shard = pool.get_shards()[s];
+            std::printf("shard %zu node %zu %-9s %6zu instances %10llu frames %14llu cycles\n", s, shard.node,
+                        shard_pool::shard_state_strings[static_cast<std::size_t>(shard.state)], shard.instances,
+                        static_cast<unsigned long long>(shard_totals[s].frame),
+                        static_cast<unsigned long long>(shard_totals[s].cycles));
+            total_frames += shard_totals[s].frame;
+            total_cycles += shard_totals[s].cycles;
+        }
+        std::printf("%zu instances on %zu shards (%zu NUMA nodes), %zu lost: %llu frames, %llu cycles in %.3f s, "
+                    "%.2f MIPS, fleet hash %016llx\n", pool.get_instances().size(), pool.get_shards().size(),
+                    pool.get_nodes().size(), lost, static_cast<unsigned long long>(total_frames),
+                    static_cast<unsigned long long>(total_cycles), seconds,
+                    seconds > 0 ? static_cast<double>(total_cycles) / seconds / 1e6 : 0,
+                    static_cast<unsigned long long>(fleet_hash));
+        return lost == 0 ? 0 : 1;
+    } catch (const std::exception &e) {
+        std::fprintf(stderr, "%s\n", e.what());
+        return 2;
+    }
+}
@@ -0,0 +1,274 @@
+#include "aot.hpp"
+#include "chip8.hpp"
+#include "hash.hpp"
+#include "headless.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <format>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <new>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace {
+    // heap allocations on this thread while an allocation_counter is alive
+    thread_local bool counting_allocations{};
+    thread_local std::uint64_t allocations{};
+
+    // a run is allocation free once its ROM is loaded, so instances scale across threads without meeting in the
+    // allocator; every run counts what it allocates from there and the harness fails any that did
+    class allocation_counter {
+    public:
+        allocation_counter() {
+            allocations = 0;
+            counting_allocations = true;
+        }
+
+        ~allocation_counter() { counting_allocations = false; }
+
+        allocation_counter(const allocation_counter &) = delete;
+
+        auto operator=(const allocation_counter &) -> allocation_counter & = delete;
+
+        [[nodiscard]] auto count() const -> std::uint64_t { return allocations; }
+    };
+
+    struct options {
+        std::string golden{"golden.txt"};
+        std::string input;
+        std::string aot;
+        std::uint64_t cycles{20'000};
+        std::uint64_t cycles_per_frame{20};
+        std::uint32_t seed{1};
+        unsigned threads{std::max(1u, std::thread::hardware_concurrency())};
+        std::optional<chip8::variant> variant;
+        bool update{};
+        std::vector<std::string> paths;
+    };
+
+    struct job {
+        std::string rom;
+        std::size_t combo;
+        chip8::alt_t alt_ops;
+    };
+
+    struct result {
+        std::uint64_t fb_hash{};
+        std::uint64_t state_hash{};
+        // heap allocations after the ROM was loaded, which must be none
+        std::uint64_t allocations{};
+        std::string error;
+        bool compiled{};
+    };
+
+    auto parse_options(const std::span<char *> args) -> options {
+        options opts;
+        for (std::size_t i = 1; i < args.size(); ++i) {
+            const std::string_view arg = args[i];
+            const auto value = [&] {
+                if (i + 1 >= args.size()) { throw std::invalid_argument(std::format("Missing value for {}", arg)); }
+                return std::string_view(args[++i]);
+            };
+            if (arg == "--golden") {
+                opts.golden = value();
+            } else if (arg == "--input") {
+                opts.input = value();
+            } else if (arg == "--cycles") {
+                opts.cycles = headless::parse_number(value());
+            } else if (arg == "--cpf") {
+                opts.cycles_per_frame = std::max<std::uint64_t>(1, headless::parse_number(value()));
+            } else if (arg == "--seed") {
+                opts.seed = static_cast<std::uint32_t>(headless::parse_number(value()));
+            } else if (arg == "--threads") {
+                opts.threads = std::max(1u, static_cast<unsigned>(headless::parse_number(value())));
+            } else if (arg == "--aot") {
+                opts.aot = value();
+            } else if (arg == "--update") {
+                opts.update = true;
+            } else if (arg == "--variant") {
+                opts.variant = headless::parse_variant(value());
+            } else if (arg.starts_with("--")) {
+                throw std::invalid_argument(std::format("Unknown option: {}", arg));
+            } else {
+                opts.paths.emplace_back(arg);
+            }
+        }
+        return opts;
+    }
+
+    auto run_job(const job &job, const options &opts, const std::vector<headless::input_event> &events) -> result {
+        result res;
+        try {
+            chip8 interpreter(job.alt_ops);
+            interpreter.seed(opts.seed);
+            interpreter.load_rom(job.rom);
+            std::optional<aot_runner> aot;
+            if (!opts.aot.empty()) {
+                if (auto module = aot_module::find(opts.aot, job.rom, job.alt_ops)) { aot.emplace(std::move(module)); }
+            }
+            // described every frame as the instruction log would, which must not allocate either
+            std::array<char, 64> text{};
+            const std::function<void(const chip8 &)> on_tick = [&text](const chip8 &c) {
+                static_cast<void>(c.describe(c.get_executed(), text));
+            };
+            {
+                const allocation_counter counter;
+                headless::run(interpreter, events, opts.cycles, opts.cycles_per_frame, on_tick, aot ? &*aot : nullptr);
+                res.allocations = counter.count();
+            }
+            res.compiled = aot.has_value();
+            res.fb_hash = hash::fb_hash(interpreter);
+            res.state_hash = hash::state_hash(interpreter);
+        } catch (const std::invalid_argument &e) {
+            res.error = e.what();
+        }
+        return res;
+    }
+
+    // "<rom> <combo> <fb hash> <state hash>" per line
+    auto load_golden(const std::string &path) -> std::map<std::pair<std::string, std::size_t>, std::string> {
+        std::map<std::pair<std::string, std::size_t>, std::string> golden;
+        std::ifstream file(path);
+        std::string rom;
+        std::size_t combo{};
+        std::string fb_hash;
+        std::string state_hash;
+        while (file >> rom >> combo >> fb_hash >> state_hash) {
+            golden[{rom, combo}] = fb_hash + ' ' + state_hash;
+        }
+        return golden;
+    }
+
+    auto format_result(const result &res) -> std::string {
+        if (!res.error.empty()) { return "error error"; }
+        return std::format("{:016x} {:016x}", res.fb_hash, res.state_hash);
+    }
+
+    auto allocate(const std::size_t size) -> void * {
+        if (counting_allocations) { ++allocations; }
+        if (void *p = std::malloc(size == 0 ? 1 : size)) { return p; } // NOLINT(*-no-malloc)
+        throw std::bad_alloc();
+    }
+
+    auto allocate(const std::size_t size, const std::align_val_t align) -> void * {
+        if (counting_allocations) { ++allocations; }
+        // aligned_alloc wants a multiple of the alignment
+        const auto alignment = static_cast<std::size_t>(align);
+        const auto rounded = (std::max<std::size_t>(size, 1) + alignment - 1) / alignment * alignment;
+        if (void *p = std::aligned_alloc(alignment, rounded)) { return p; } // NOLINT(*-no-malloc)
+        throw std::bad_alloc();
+    }
+}
+
+// every allocation in the harness goes through these, so runs can be checked for allocating
+auto operator new(const std::size_t size) -> void * { return allocate(size); }
+
+auto operator new[](const std::size_t size) -> void * { return allocate(size); }
+
+auto operator new(const std::size_t size, const std::align_val_t align) -> void * { return allocate(size, align); }
+
+auto operator new[](const std::size_t size, const std::align_val_t align) -> void * { return allocate(size, align); }
+
+//@formatter:off
+void operator delete(void *p) noexcept { std::free(p); } // NOLINT(*-no-malloc)
+void operator delete[](void *p) noexcept { std::free(p); } // NOLINT(*-no-malloc)
+void operator delete(void *p, std::size_t) noexcept { std::free(p); } // NOLINT(*-no-malloc)
+void operator delete[](void *p, std::size_t) noexcept { std::free(p); } // NOLINT(*-no-malloc)
+void operator delete(void *p, std::align_val_t) noexcept { std::free(p); } // NOLINT(*-no-malloc)
+void operator delete[](void *p, std::align_val_t) noexcept { std::free(p); } // NOLINT(*-no-malloc)
+void operator delete(void *p, std::size_t, std::align_val_t) noexcept { std::free(p); } // NOLINT(*-no-malloc)
+void operator delete[](void *p, std::size_t, std::align_val_t) noexcept { std::free(p); } // NOLINT(*-no-malloc)
+//@formatter:on
+
+auto main(int argc, char *argv[]) -> int {
+    try {
+        const auto opts = parse_options(std::span(argv, static_cast<std::size_t>(argc)));
+        if (opts.paths.empty()) {
+            std::fputs("usage: mic8_harness.elf [--golden file] [--update] [--cycles n] [--cpf n] [--seed n] "
+                       "[--input file] [--threads n] [--variant chip8|schip|xochip] [--aot dir] rom|dir...\n", stderr);
+            return 2;
+        }
+        const auto events = headless::load_input(opts.input, opts.cycles);
+
+        std::vector<job> jobs;
+        for (const auto &rom: headless::collect_roms(opts.paths)) {
+            const auto variant = opts.variant.value_or(headless::guess_variant(rom));
+            for (std::size_t combo = 0; combo < headless::QUIRK_COMBOS; ++combo) {
+                jobs.push_back({rom.generic_string(), combo, headless::make_alt_ops(combo, variant)});
+            }
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+        std::vector<result> results(jobs.size());
+        std::atomic<std::size_t> next{};
+        {
+            std::vector<std::jthread> workers;
+            for (unsigned t = 0; t < opts.threads; ++t) {
+                workers.emplace_back([&] {
+                    for (auto i = next++; i < jobs.size(); i = next++) {
+                        results[i] = run_job(jobs[i], opts, events);
+                    }
+                });
+            }
+        }
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        if (opts.update) {
+            std::ofstream file(opts.golden);
+            for (std::size_t i = 0; i < jobs.size(); ++i) {
+                file << std::format("{} {} {}\n", jobs[i].rom, jobs[i].combo, format_result(results[i]));
+            }
+            std::printf("Wrote %zu runs to %s in %.2f s\n", jobs.size(), opts.golden.c_str(), elapsed.count());
+            return 0;
+        }
+
+        const auto golden = load_golden(opts.golden);
+        std::size_t passed = 0;
+        std::size_t failed = 0;
+        std::size_t missing = 0;
+        std::size_t compiled = 0;
+        std::size_t allocating = 0;
+        for (std::size_t i = 0; i < jobs.size(); ++i) {
+            const auto actual = format_result(results[i]);
+            compiled += static_cast<std::size_t>(results[i].compiled);
+            if (results[i].allocations != 0) {
+                ++allocating;
+                std::printf("ALLOC %s %zu made %llu heap allocations after loading\n", jobs[i].rom.c_str(),
+                            jobs[i].combo, static_cast<unsigned long long>(results[i].allocations));
+            }
+            const auto it = golden.find({jobs[i].rom, jobs[i].combo});
+            if (it == golden.end()) {
+                ++missing;
+                std::printf("NEW  %s %zu %s\n", jobs[i].rom.c_str(), jobs[i].combo, actual.c_str());
+            } else if (it->second != actual) {
+                ++failed;
+                std::printf("FAIL %s %zu expected %s got %s\n", jobs[i].rom.c_str(), jobs[i].combo, it->second.c_str(),
+                            actual.c_str());
+            } else {
+                ++passed;
+            }
+        }
+        std::printf("%zu runs on %u threads in %.2f s: %zu passed, %zu failed, %zu missing, %zu allocating\n",
+                    jobs.size(), opts.threads, elapsed.count(), passed, failed, missing, allocating);
+        if (!opts.aot.empty()) { std::printf("%zu runs used a compiled module from %s\n", compiled, opts.aot.c_str()); }
+        return failed == 0 && missing == 0 && allocating == 0 ? 0 : 1;
+    } catch (const std::invalid_argument &e) {
+        std::fprintf(stderr, "%s\n", e.what());
+        return 2;
+    }
+}
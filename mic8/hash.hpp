@@ -0,0 +1,39 @@
+#pragma once
+
+#include "chip8.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+// FNV-1a, used for golden files, movie ROM checks and anything else that compares runs across builds
+namespace hash {
+    constexpr std::uint64_t FNV_OFFSET = 0xCBF2'9CE4'8422'2325;
+    constexpr std::uint64_t FNV_PRIME = 0x0000'0100'0000'01B3;
+
+    inline auto fnv1a(const std::span<const std::byte> bytes, std::uint64_t hash = FNV_OFFSET) -> std::uint64_t {
+        for (const auto byte: bytes) {
+            hash = (hash ^ static_cast<std::uint8_t>(byte)) * FNV_PRIME;
+        }
+        return hash;
+    }
+
+    template<typename T>
+    auto fnv1a_of(const T &value, const std::uint64_t hash) -> std::uint64_t {
+        return fnv1a(std::as_bytes(std::span(&value, 1)), hash);
+    }
+
+    inline auto fb_hash(const chip8 &interpreter) -> std::uint64_t { return fnv1a(std::as_bytes(interpreter.get_fb())); }
+
+    inline auto state_hash(const chip8 &interpreter) -> std::uint64_t {
+        auto hash = fnv1a(std::as_bytes(interpreter.get_mem()));
+        hash = fnv1a(std::as_bytes(interpreter.get_reg()), hash);
+        hash = fnv1a(std::as_bytes(interpreter.get_stack()), hash);
+        hash = fnv1a_of(interpreter.get_pc(), hash);
+        hash = fnv1a_of(interpreter.get_ir(), hash);
+        hash = fnv1a_of(interpreter.get_sp(), hash);
+        hash = fnv1a_of(interpreter.get_dt(), hash);
+        hash = fnv1a_of(interpreter.get_st(), hash);
+        return hash;
+    }
+}
@@ -0,0 +1,112 @@
+#include "headless.hpp"
+#include "chip8.hpp"
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <format>
+#include <fstream>
+#include <ios>
+#include <stdexcept>
+
+auto headless::parse_number(const std::string_view text) -> std::uint64_t {
+    std::uint64_t value{};
+    const auto [ptr, ec] = std::from_chars(text.data(), text.data() + text.size(), value);
+    if (ec != std::errc{} || ptr != text.data() + text.size()) {
+        throw std::invalid_argument(std::format("Invalid number: {}", text));
+    }
+    return value;
+}
+
+auto headless::parse_variant(const std::string_view name) -> chip8::variant {
+    if (name == "chip8") { return chip8::variant::chip8; }
+    if (name == "schip") { return chip8::variant::schip; }
+    if (name == "xochip") { return chip8::variant::xochip; }
+    throw std::invalid_argument(std::format("Unknown variant: {}", name));
+}
+
+auto headless::guess_variant(const std::filesystem::path &path) -> chip8::variant {
+    const auto ext = path.extension();
+    if (ext == ".xo8") { return chip8::variant::xochip; }
+    if (ext == ".sc8" || path.parent_path().filename() == "hires") { return chip8::variant::schip; }
+    return chip8::variant::chip8;
+}
+
+auto headless::make_alt_ops(const std::size_t combo, const chip8::variant variant) -> chip8::alt_t {
+    chip8::alt_t alt_ops;
+    alt_ops.vip_alu = (combo & 1u) != 0;
+    alt_ops.chip48_jmp = (combo & 2u) != 0;
+    alt_ops.chip48_shf = (combo & 4u) != 0;
+    alt_ops.ls_mode = static_cast<chip8::ls_mode>(combo / 8);
+    alt_ops.variant = variant;
+    return alt_ops;
+}
+
+// one "<cycle> <key> <0|1>" triple per line, key in hex
+auto headless::load_input(const std::string &path, const std::uint64_t cycles) -> std::vector<input_event> {
+    std::vector<input_event> events;
+    if (path.empty()) {
+        // press every key in turn for 200 cycles out of each 2000
+        for (std::uint64_t cycle = 1000; cycle < cycles; cycle += 2000) {
+            const auto key = static_cast<std::uint8_t>(cycle / 2000 % chip8::KEY_COUNT);
+            events.push_back({cycle, key, true});
+            events.push_back({cycle + 200, key, false});
+        }
+        return events;
+    }
+    std::ifstream file(path);
+    if (!file) { throw std::invalid_argument("Failed to open the input script!"); }
+    std::uint64_t cycle{};
+    unsigned key{};
+    unsigned down{};
+    while (file >> std::dec >> cycle >> std::hex >> key >> std::dec >> down) {
+        events.push_back({cycle, static_cast<std::uint8_t>(key & 0xFu), down != 0});
+    }
+    std::ranges::stable_sort(events, {}, &input_event::cycle);
+    return events;
+}
+
+auto headless::collect_roms(const std::vector<std::string> &paths) -> std::vector<std::filesystem::path> {
+    static constexpr std::array extensions{".ch8", ".sc8", ".xo8"};
+    std::vector<std::filesystem::path> roms;
+    for (const auto &path: paths) {
+        if (std::filesystem::is_directory(path)) {
+            for (const auto &entry: std::filesystem::recursive_directory_iterator(path)) {
+                if (entry.is_regular_file() && std::ranges::find(extensions, entry.path().extension()) !=
+                    extensions.end()) {
+                    roms.push_back(entry.path());
+                }
+            }
+        } else {
+            roms.emplace_back(path);
+        }
+    }
+    std::ranges::sort(roms);
+    roms.erase(std::ranges::unique(roms).begin(), roms.end());
+    return roms;
+}
+
+auto headless::run(chip8 &interpreter, const std::vector<input_event> &events, const std::uint64_t cycles,
+                   const std::uint64_t cycles_per_frame,
+                   const std::function<void(const chip8 &)> &on_tick, aot_runner *aot) -> std::uint64_t {
+    auto event = events.begin();
+    std::uint64_t cycle = 0;
+    while (cycle < cycles) {
+        for (; event != events.end() && event->cycle <= cycle; ++event) {
+            interpreter.keys[event->key] = event->down;
+        }
+        // batches end at the next timer tick, input event or the cycle limit
+        const auto next_tick = (cycle / cycles_per_frame + 1) * cycles_per_frame;
+        auto budget = std::min(next_tick, cycles) - cycle;
+        if (event != events.end()) { budget = std::min(budget, event->cycle - cycle); }
+        const auto [reason, executed] = aot != nullptr ? aot->run_cycles(interpreter, budget)
+                                                       : interpreter.run_cycles(budget);
+        cycle += executed;
+        if (cycle % cycles_per_frame == 0) {
+            interpreter.decrement_timers();
+            if (on_tick) { on_tick(interpreter); }
+        }
+        if (reason == chip8::stop_reason::halted) { break; }
+    }
+    return cycle;
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "aot.hpp"
+#include "chip8.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// shared by the command line tools that run the core without a window
+namespace headless {
+    // every combination of the quirks the regression harness runs each ROM with
+    constexpr std::size_t QUIRK_COMBOS{24};
+
+    struct input_event {
+        std::uint64_t cycle;
+        std::uint8_t key;
+        bool down;
+    };
+
+    auto parse_number(std::string_view text) -> std::uint64_t;
+
+    auto parse_variant(std::string_view name) -> chip8::variant;
+
+    auto guess_variant(const std::filesystem::path &path) -> chip8::variant;
+
+    // combo bits: 0 vip_alu, 1 chip48_jmp, 2 chip48_shf, combo / 8 selects the load/store mode
+    auto make_alt_ops(std::size_t combo, chip8::variant variant) -> chip8::alt_t;
+
+    // without a path every key is pressed in turn so ROMs waiting on Fx0A make progress
+    auto load_input(const std::string &path, std::uint64_t cycles) -> std::vector<input_event>;
+
+    // expands directories into the .ch8/.sc8/.xo8 files below them, sorted and deduplicated
+    auto collect_roms(const std::vector<std::string> &paths) -> std::vector<std::filesystem::path>;
+
+    // returns the number of cycles executed, which is less than cycles only if the ROM halted. With aot the cycles run
+    // through the ROM's compiled module instead.
+    auto run(chip8 &interpreter, const std::vector<input_event> &events, std::uint64_t cycles,
+             std::uint64_t cycles_per_frame, const std::function<void(const chip8 &)> &on_tick = {},
+             aot_runner *aot = nullptr) -> std::uint64_t;
+}
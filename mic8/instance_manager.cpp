@@ -1,9 +1,19 @@
 #include "instance_manager.hpp"
 #include "chip8.hpp"
+#include "lz.hpp"
+#include <algorithm>
 #include <chrono>
+#include <cctype>
 #include <cmath>
+#include <format>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <random>
+#include <stdexcept>
 #include <string>
 #include <string_view>
+#include <vector>
 #include <GLFW/glfw3.h>
 
 namespace {
@@ -19,6 +29,25 @@ namespace {
 
     std::string error;
     bool modal = false;
+
+    constexpr std::array<std::uint32_t, 4> palette{0x0000'0000, 0xFFFF'FFFF, 0xFFAA'AAAA, 0xFF55'5555};
+
+    std::array<std::uint32_t, chip8::HIRES_WIDTH * chip8::HIRES_HEIGHT> fb_pixels{};
+
+    void convert_fb(const chip8 &interpreter) {
+        const std::size_t scale = interpreter.get_hires() ? 1 : 2;
+        const auto fb = interpreter.get_fb();
+        for (std::size_t y = 0; y < chip8::HIRES_HEIGHT; ++y) {
+            const std::size_t row = y / scale;
+            for (std::size_t x = 0; x < chip8::HIRES_WIDTH; ++x) {
+                const std::size_t col = x / scale;
+                const std::size_t word = row * chip8::ROW_WORDS + col / 64;
+                const std::size_t bit = 63 - col % 64;
+                const auto color = (fb[0][word] >> bit & 1u) | (fb[1][word] >> bit & 1u) << 1u;
+                fb_pixels[x + y * chip8::HIRES_WIDTH] = palette[color];
+            }
+        }
+    }
 }
 
 auto instance_manager::instance_search() const -> std::size_t {
@@ -33,48 +62,81 @@ auto instance_manager::instance_search() const -> std::size_t {
 }
 
 auto instance_manager::selected_search() const -> ssize_t {
-    for (const auto &instance: instances) {
-        if (instance.selected) { return static_cast<ssize_t>(instance.get_id()); }
-    }
-    return -1;
+    // the position, not the id, which differ once an instance before it was deleted
+    const auto it = std::ranges::find_if(instances, &instance::selected);
+    return it == instances.end() ? -1 : static_cast<ssize_t>(it - instances.begin());
 }
 
-instance_manager::instance::instance(const std::size_t id, const chip8::alt_t alt_ops) : interpreter(chip8(alt_ops)),
-    id(id), alt_ops(alt_ops) {
+instance_manager::instance::instance(const std::size_t id, const chip8::alt_t alt_ops) : interpreter(
+    std::make_unique<chip8>(alt_ops)), id(id), alt_ops(alt_ops) {
+    interpreter->set_trace_id(static_cast<std::uint32_t>(id));
+    // UI resources live in view, an idle instance is little more than its interpreter. That is still about 6.7 KB
+    // with a CHIP-8 interpreter and 68 KB with an XO-CHIP one, 670 MB or more per 100,000 instances; it takes
+    // hibernation, which swaps the interpreter for a compressed save state, to get them down to about 1 KB each.
+    static_assert(sizeof(instance) <= 256);
+}
+
+instance_manager::instance::view::view() {
     glGenTextures(1, &tex_id);
     glBindTexture(GL_TEXTURE_2D, tex_id);
+    instruction_log.reserve(INSTRUCTION_LOG_MAX);
 
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, chip8::VIDEO_WIDTH, chip8::VIDEO_HEIGHT, 0, GL_RGBA, GL_UNSIGNED_BYTE,
-                 interpreter.get_fb().data());
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, chip8::HIRES_WIDTH, chip8::HIRES_HEIGHT, 0, GL_RGBA, GL_UNSIGNED_BYTE,
+                 nullptr);
 
     glBindTexture(GL_TEXTURE_2D, 0);
 }
 
+void instance_manager::instance::view::log(const chip8::executed &op) {
+    if (instruction_log.size() < INSTRUCTION_LOG_MAX) {
+        instruction_log.push_back(op);
+        return;
+    }
+    instruction_log[log_start] = op;
+    log_start = (log_start + 1) % instruction_log.size();
+}
+
+void instance_manager::instance::view::clear_log() {
+    instruction_log.clear();
+    log_start = 0;
+}
+
+instance_manager::instance::view::~view() { glDeleteTextures(1, &tex_id); }
+
 void instance_manager::run() {
     selected_id = selected_search();
+    if (selected_id != -1) { instances[selected_id].wake(); }
 
     instance_manager_window();
 
+    // creating, deleting or selecting an instance moves the selection, and a newly selected one may be hibernated
+    selected_id = selected_search();
+    if (selected_id != -1) { instances[selected_id].wake(); }
+
     if (selected_id != -1) {
         instances[selected_id].controller_window();
-        instances[selected_id].fb_window();
-        instances[selected_id].cpu_view_window();
-        instances[selected_id].mem_view_window();
-        instances[selected_id].instruction_log_window();
+        if (instances[selected_id].get_state() != instance::state::TURBO) {
+            instances[selected_id].fb_window();
+            instances[selected_id].cpu_view_window();
+            instances[selected_id].mem_view_window();
+            instances[selected_id].instruction_log_window();
+            ram_search_window();
+            quirk_bisect_window();
+        }
     }
 
     for (auto &instance: instances) {
-        if (instance.get_state() == instance::state::RUNNING) {
-            instance.run();
-            if (instance.get_input_enabled()) { instance.process_input(); }
-        }
+        if (!instance.selected) { instance.release_view(); }
     }
 
+    frame_times[frame_offset] = ImGui::GetIO().DeltaTime * 1000.0f;
+    frame_offset = (frame_offset + 1) % frame_times.size();
+
     const ImVec2 center = ImGui::GetMainViewport()->GetCenter();
     ImGui::SetNextWindowPos(center, ImGuiCond_Appearing, ImVec2(0.5f, 0.5f));
 
@@ -91,6 +153,116 @@ void instance_manager::run() {
     }
 }
 
+void instance_manager::emulate() {
+    const auto now = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < instances.size(); ++i) {
+        auto &instance = instances[i];
+        if (instance.get_state() == instance::state::RUNNING) {
+            if (instance.get_input_enabled()) {
+                for (const auto &event: key_events) { instance.queue_input(event); }
+            }
+            // the selected instance is never held back, so it keeps its configured speed under load. At speed 0 run
+            // only takes the queued input, which would otherwise pile up.
+            if (instance.selected || instance.target_ips() == 0) {
+                instance.run();
+            } else if (instance.target_ips() > 0 && instance.next_deadline() <= now) {
+                run_order.push_back(i);
+            }
+        } else if (instance.get_state() == instance::state::TURBO) {
+            instance.poll_turbo();
+        }
+        // the RAM search reads its instances' memory every frame
+        if (std::ranges::find(search_ids, instance.get_id()) != search_ids.end()) {
+            instance.touch(now);
+        } else {
+            instance.hibernate(now, HIBERNATE_AFTER);
+        }
+    }
+
+    key_events.clear();
+
+    // the rest share a slice, most urgent first; whoever misses out is first in line next time
+    std::ranges::sort(run_order, std::greater{}, [&](const std::size_t i) { return instances[i].urgency(now); });
+    const auto window = std::chrono::duration_cast<std::chrono::nanoseconds>(now - last_sample_time);
+    const auto slice_end = std::chrono::steady_clock::now() + BACKGROUND_SLICE;
+    for (const auto i: run_order) {
+        if (std::chrono::steady_clock::now() >= slice_end || instances[i].over_budget(window)) {
+            instances[i].throttle();
+        } else {
+            instances[i].run();
+        }
+    }
+    run_order.clear();
+
+    if (std::chrono::steady_clock::now() - last_sample_time >= SAMPLE_INTERVAL) { sample_telemetry(); }
+}
+
+void instance_manager::sample_telemetry() {
+    const auto now = std::chrono::steady_clock::now();
+    const std::chrono::duration<double> elapsed = now - last_sample_time;
+    last_sample_time = now;
+
+    telemetry_rows.clear();
+    telemetry_totals = {0, "Total", 0, {}, 0};
+    for (auto &instance: instances) {
+        instance.sample_telemetry(elapsed);
+        const auto row = telemetry_rows.emplace_back(instance.telemetry());
+        if (instance.get_state() == instance::state::RUNNING || instance.get_state() == instance::state::TURBO) {
+            ++telemetry_totals.id;
+            telemetry_totals.rates.wait_percent += row.rates.wait_percent;
+            telemetry_totals.rates.throttle_percent += row.rates.throttle_percent;
+        }
+        telemetry_totals.target_ips += row.target_ips;
+        telemetry_totals.rates.ips += row.rates.ips;
+        telemetry_totals.rates.draws_per_second += row.rates.draws_per_second;
+        telemetry_totals.rates.run_percent += row.rates.run_percent;
+        telemetry_totals.behind += row.behind;
+    }
+    // the run time adds up to the share of one core, waits and throttling are averaged over active instances
+    if (telemetry_totals.id > 0) {
+        telemetry_totals.rates.wait_percent /= static_cast<double>(telemetry_totals.id);
+        telemetry_totals.rates.throttle_percent /= static_cast<double>(telemetry_totals.id);
+    }
+
+    if (telemetry_export && export_countdown-- == 0) {
+        telemetry_export->write(telemetry_rows, telemetry_totals);
+        export_countdown = static_cast<std::uint64_t>(export_interval - 1);
+    }
+}
+
+auto instance_manager::next_deadline() const -> std::optional<std::chrono::time_point<std::chrono::steady_clock>> {
+    std::optional<std::chrono::time_point<std::chrono::steady_clock>> deadline;
+    const auto window = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() -
+                                                                              last_sample_time);
+    for (const auto &instance: instances) {
+        // at speed 0 run does nothing, so the instance has nothing due until its speed changes
+        if (instance.get_state() != instance::state::RUNNING || instance.target_ips() == 0) { continue; }
+        auto due = instance.next_deadline();
+        // one at its CPU limit is held back until the next sample clears its run time, waking for it before then
+        // would only throttle it again
+        if (!instance.selected && instance.over_budget(window)) {
+            due = std::max(due, last_sample_time + SAMPLE_INTERVAL);
+        }
+        if (!deadline || due < *deadline) { deadline = due; }
+    }
+    return deadline;
+}
+
+auto instance_manager::active_count() const -> std::size_t {
+    return static_cast<std::size_t>(std::ranges::count_if(instances, [](const instance &instance) {
+        return instance.get_state() == instance::state::RUNNING || instance.get_state() == instance::state::TURBO;
+    }));
+}
+
+void instance_manager::key_callback(GLFWwindow *, const int key, int, const int action, int) {
+    // typing into a text field is not keypad input, but a release still goes through so no key is left down
+    if (action == GLFW_REPEAT || (action == GLFW_PRESS && ImGui::GetIO().WantCaptureKeyboard)) { return; }
+    const auto it = std::ranges::find(key_map, key);
+    if (it == key_map.end()) { return; }
+    key_events.push_back({std::chrono::steady_clock::now(), static_cast<std::uint8_t>(it - key_map.begin()),
+                          action == GLFW_PRESS});
+}
+
 void instance_manager::instance_manager_window() {
     if (!ImGui::Begin("Instance Manager")) {
         ImGui::End();
@@ -125,6 +297,20 @@ void instance_manager::instance_manager_window() {
         }
         ImGui::SameLine();
         help_marker("FX55 / FX65 no longer increment I at all");
+        ImGui::SeparatorText("Variant");
+        if (ImGui::RadioButton("CHIP-8", alt_ops.variant == chip8::variant::chip8)) {
+            alt_ops.variant = chip8::variant::chip8;
+        }
+        if (ImGui::RadioButton("SUPER-CHIP", alt_ops.variant == chip8::variant::schip)) {
+            alt_ops.variant = chip8::variant::schip;
+        }
+        ImGui::SameLine();
+        help_marker("128x64 hires mode, 16x16 sprites, scrolling, big font and flag registers");
+        if (ImGui::RadioButton("XO-CHIP", alt_ops.variant == chip8::variant::xochip)) {
+            alt_ops.variant = chip8::variant::xochip;
+        }
+        ImGui::SameLine();
+        help_marker("SUPER-CHIP plus 64 KB memory, two bitplanes, F000 NNNN, audio patterns and wrapping sprites");
         ImGui::Separator();
         if (ImGui::Button("Create", ImVec2(ImGui::GetContentRegionAvail().x, 0))) {
             const auto pos = instance_search();
@@ -135,6 +321,8 @@ void instance_manager::instance_manager_window() {
         ImGui::Spacing();
     }
 
+    rom_library_section();
+
     if (ImGui::CollapsingHeader("Selected Instance", ImGuiTreeNodeFlags_DefaultOpen)) {
         ImGui::SeparatorText("Instance Attributes");
 
@@ -142,6 +330,7 @@ void instance_manager::instance_manager_window() {
         std::string chip48_jmp = "Unknown";
         std::string chip48_shf = "Unknown";
         std::string ls_mode = "Unknown";
+        std::string variant = "Unknown";
 
         if (selected_id != -1) {
             vip_alu = instances[selected_id].get_alt_ops().vip_alu ? "Yes" : "No";
@@ -157,6 +346,16 @@ void instance_manager::instance_manager_window() {
                 case chip8::ls_mode::schip11_ls:
                     ls_mode = "SUPER-CHIP 1.1";
             }
+            switch (instances[selected_id].get_alt_ops().variant) {
+                case chip8::variant::chip8:
+                    variant = "CHIP-8";
+                    break;
+                case chip8::variant::schip:
+                    variant = "SUPER-CHIP";
+                    break;
+                case chip8::variant::xochip:
+                    variant = "XO-CHIP";
+            }
         }
 
         static constexpr ImGuiTableFlags flags =
@@ -179,6 +378,10 @@ void instance_manager::instance_manager_window() {
             ImGui::Text("L/S Mode:");
             ImGui::TableNextColumn();
             ImGui::Text("%s", ls_mode.c_str());
+            ImGui::TableNextColumn();
+            ImGui::Text("Variant:");
+            ImGui::TableNextColumn();
+            ImGui::Text("%s", variant.c_str());
             ImGui::EndTable();
         }
         ImGui::Separator();
@@ -195,7 +398,7 @@ void instance_manager::instance_manager_window() {
         }
 
         if (ImGuiFileDialog::Instance()->Display("load_dlg_key")) {
-            if (ImGuiFileDialog::Instance()->IsOk()) {
+            if (ImGuiFileDialog::Instance()->IsOk() && selected_id != -1) {
                 instances[selected_id].load(ImGuiFileDialog::Instance()->GetFilePathName());
             }
             ImGuiFileDialog::Instance()->Close();
@@ -204,7 +407,12 @@ void instance_manager::instance_manager_window() {
         ImGui::SameLine();
 
         if (ImGui::Button("Delete", ImVec2(button_width, 0))) {
+            instances[selected_id].stop_turbo();
+            instances[selected_id].stop_video();
             instances.erase(instances.begin() + selected_id);
+            // nothing is selected until the user picks another, the windows skip this frame
+            for (auto &instance: instances) { instance.selected = false; }
+            selected_id = -1;
         }
         ImGui::EndDisabled();
         ImGui::Spacing();
@@ -213,9 +421,16 @@ void instance_manager::instance_manager_window() {
     if (ImGui::CollapsingHeader("Current Instances", ImGuiTreeNodeFlags_DefaultOpen)) {
         static constexpr ImGuiTableFlags flags =
                 (ImGuiTableFlags_Borders ^ ImGuiTableFlags_BordersInnerV) | ImGuiTableFlags_ScrollY;
-        if (ImGui::BeginTable("instances_table", 2, flags)) {
+        if (ImGui::BeginTable("instances_table", 9, flags)) {
             ImGui::TableSetupColumn("ID");
             ImGui::TableSetupColumn("State");
+            ImGui::TableSetupColumn("Priority");
+            ImGui::TableSetupColumn("IPS / Target");
+            ImGui::TableSetupColumn("Behind");
+            ImGui::TableSetupColumn("Draws/s");
+            ImGui::TableSetupColumn("Run %");
+            ImGui::TableSetupColumn("Wait %");
+            ImGui::TableSetupColumn("Throttled %");
             ImGui::TableSetupScrollFreeze(0, 1);
             ImGui::TableHeadersRow();
             ImGui::TableNextRow();
@@ -226,51 +441,553 @@ void instance_manager::instance_manager_window() {
                                       ImGuiSelectableFlags_SpanAllColumns)) {
                     if (selected_id != -1) { instances[selected_id].selected = false; }
                 }
+                const auto row = instance.telemetry();
+                ImGui::TableNextColumn();
+                if (instance.get_hibernated()) {
+                    ImGui::TextDisabled("%s", instance::state_strings[static_cast<int>(instance.get_state())]);
+                } else if (row.rates.throttle_percent > 0 && instance.get_state() == instance::state::RUNNING) {
+                    ImGui::TextColored(ImVec4(1.0f, 0.7f, 0.2f, 1.0f), "Throttled");
+                } else {
+                    ImGui::Text("%s", instance::state_strings[static_cast<int>(instance.get_state())]);
+                }
+                ImGui::TableNextColumn();
+                if (instance.selected) {
+                    ImGui::Text("Selected");
+                } else {
+                    ImGui::Text("%s", instance::priority_strings[static_cast<int>(instance.get_priority())]);
+                }
                 ImGui::TableNextColumn();
-                ImGui::Text("%s", instance::state_strings[static_cast<int>(instance.get_state())]);
+                if (row.target_ips > 0) {
+                    ImGui::Text("%.0f / %.0f", row.rates.ips, row.target_ips);
+                } else {
+                    ImGui::Text("%.0f", row.rates.ips);
+                }
+                ImGui::TableNextColumn();
+                ImGui::Text("%llu", static_cast<unsigned long long>(row.behind));
+                ImGui::TableNextColumn();
+                ImGui::Text("%.1f", row.rates.draws_per_second);
+                ImGui::TableNextColumn();
+                ImGui::Text("%.1f", row.rates.run_percent);
+                ImGui::TableNextColumn();
+                ImGui::Text("%.1f", row.rates.wait_percent);
+                ImGui::TableNextColumn();
+                ImGui::Text("%.1f", row.rates.throttle_percent);
             }
             ImGui::EndTable();
         }
     }
+
+    telemetry_section();
     ImGui::End();
 }
 
-void instance_manager::instance::run() {
-    if (ips == 0) { return; }
+void instance_manager::filter_library() {
+    const std::string_view filter(library_filter.data());
+    const auto matches = [filter](const std::string_view text) {
+        return std::ranges::search(text, filter, [](const char a, const char b) {
+            return std::tolower(static_cast<unsigned char>(a)) == std::tolower(static_cast<unsigned char>(b));
+        }).begin() != text.end() || filter.empty();
+    };
+    library_view.clear();
+    const auto &entries = library.get_entries();
+    for (std::size_t i = 0; i < entries.size(); ++i) {
+        if (matches(entries[i].name) || (entries[i].profile && matches(entries[i].profile->title))) {
+            library_view.push_back(i);
+        }
+    }
+    library_selected.reset();
+}
+
+void instance_manager::rom_library_section() {
+    if (library.poll()) { filter_library(); }
+    if (!ImGui::CollapsingHeader("ROM Library")) { return; }
+
+    ImGui::SetNextItemWidth(ImGui::GetContentRegionAvail().x - 100);
+    if (ImGui::InputText("##library_filter", library_filter.data(), library_filter.size())) { filter_library(); }
+    ImGui::SameLine();
+    ImGui::BeginDisabled(library.get_scanning());
+    if (ImGui::Button("Rescan", ImVec2(ImGui::GetContentRegionAvail().x, 0))) { library.rescan(); }
+    ImGui::EndDisabled();
+
+    const auto &entries = library.get_entries();
+    if (library.get_scanning()) {
+        ImGui::Text("Indexing %s...", library.get_dir().c_str());
+    } else {
+        ImGui::Text("%zu of %zu ROMs in %s", library_view.size(), entries.size(), library.get_dir().c_str());
+    }
+    if (!library.get_error().empty()) {
+        ImGui::SameLine();
+        ImGui::TextDisabled("(%s)", library.get_error().c_str());
+    }
+
+    static constexpr ImGuiTableFlags flags =
+            (ImGuiTableFlags_Borders ^ ImGuiTableFlags_BordersInnerV) | ImGuiTableFlags_ScrollY;
+    if (ImGui::BeginTable("library_table", 3, flags, ImVec2(0, ImGui::GetTextLineHeightWithSpacing() * 10))) {
+        ImGui::TableSetupColumn("ROM");
+        ImGui::TableSetupColumn("Title");
+        ImGui::TableSetupColumn("Variant");
+        ImGui::TableSetupScrollFreeze(0, 1);
+        ImGui::TableHeadersRow();
+        ImGuiListClipper clipper;
+        clipper.Begin(static_cast<int>(library_view.size()));
+        while (clipper.Step()) {
+            for (auto row = clipper.DisplayStart; row < clipper.DisplayEnd; ++row) {
+                const auto index = library_view[row];
+                const auto &entry = entries[index];
+                ImGui::TableNextColumn();
+                ImGui::PushID(static_cast<int>(index));
+                if (ImGui::Selectable(entry.name.c_str(), library_selected == index,
+                                      ImGuiSelectableFlags_SpanAllColumns)) { library_selected = index; }
+                ImGui::PopID();
+                ImGui::TableNextColumn();
+                ImGui::Text("%s", entry.profile ? entry.profile->title.c_str() : "");
+                ImGui::TableNextColumn();
+                if (entry.profile) {
+                    constexpr std::array<const char *, 3> variants{"CHIP-8", "SUPER-CHIP", "XO-CHIP"};
+                    ImGui::Text("%s", variants[static_cast<int>(entry.profile->alt_ops.variant)]);
+                }
+            }
+        }
+        ImGui::EndTable();
+    }
+
+    ImGui::BeginDisabled(!library_selected);
+    if (ImGui::Button("Create from ROM", ImVec2(ImGui::GetContentRegionAvail().x, 0))) {
+        const auto &entry = entries[*library_selected];
+        const auto pos = instance_search();
+        auto &created = *instances.insert(instances.begin() + static_cast<decltype(instances)::difference_type>(pos),
+                                          instance(pos, entry.profile ? entry.profile->alt_ops : chip8::alt_t{}));
+        created.load(entry.path);
+        if (entry.profile && entry.profile->tickrate > 0) {
+            created.set_tickrate(entry.profile->tickrate, glfwGetVideoMode(glfwGetPrimaryMonitor())->refreshRate);
+        }
+    }
+    ImGui::EndDisabled();
+    ImGui::SameLine();
+    help_marker("ROMs under ./roms, indexed in the background and cached by path, mtime and hash. Quirks, variant "
+        "and speed come from roms/programs.json (copied from chip8Archive by make roms) when the file name or contents "
+        "match an entry, otherwise the defaults are used.");
+    ImGui::Spacing();
+}
+
+void instance_manager::telemetry_section() {
+    if (!ImGui::CollapsingHeader("Telemetry")) { return; }
+
+    const auto &totals = telemetry_totals;
+    ImGui::Text("%zu active, %.0f / %.0f IPS, %.1f draws/s", totals.id, totals.rates.ips, totals.target_ips,
+                totals.rates.draws_per_second);
+    ImGui::Text("%.1f%% of a core in run, %.1f%% waiting, %.1f%% throttled, %llu cycles behind",
+                totals.rates.run_percent, totals.rates.wait_percent, totals.rates.throttle_percent,
+                static_cast<unsigned long long>(totals.behind));
+    ImGui::SameLine();
+    help_marker("IPS is sampled every second against the instance's IPS x multiplier. Behind counts cycles the "
+        "schedule asked for while the main loop was too late to run them, they are skipped rather than caught up. "
+        "Waiting is the share of batches cut short by Fx0A or a halt. Throttled is the share of due batches held "
+        "back because the selected instance came first, the background slice ran out or the instance reached its "
+        "CPU limit.");
+
+    std::size_t hibernated = 0;
+    std::size_t resident = 0;
+    for (const auto &instance: instances) {
+        hibernated += instance.get_hibernated() ? 1 : 0;
+        resident += instance.resident_size();
+    }
+    ImGui::Text("%zu of %zu instances hibernated, %.1f KB of interpreter state", hibernated, instances.size(),
+                static_cast<double>(resident) / 1024.0);
+    ImGui::SameLine();
+    help_marker("Instances left stopped and unselected for 10 seconds are compressed into a save state and restored "
+        "when selected.");
+
+    const float max_frame_time = *std::ranges::max_element(frame_times);
+    const auto overlay = std::format("{:.1f} ms", frame_times[(frame_offset + frame_times.size() - 1) %
+                                                              frame_times.size()]);
+    ImGui::PlotLines("Frame time", frame_times.data(), static_cast<int>(frame_times.size()),
+                     static_cast<int>(frame_offset), overlay.c_str(), 0.0f, std::max(max_frame_time, 20.0f),
+                     ImVec2(0, 60));
+
+    ImGui::SeparatorText("Export");
+    ImGui::BeginDisabled(telemetry_export != nullptr);
+    ImGui::SetNextItemWidth(100);
+    if (ImGui::InputInt("Interval (s)", &export_interval)) { export_interval = std::clamp(export_interval, 1, 3600); }
+    ImGui::EndDisabled();
+    if (!telemetry_export) {
+        if (ImGui::Button("Export Telemetry", ImVec2(200, 0))) {
+            IGFD::FileDialogConfig file_dlg_config;
+            file_dlg_config.path = ".";
+            file_dlg_config.flags = ImGuiFileDialogFlags_Modal | ImGuiFileDialogFlags_ConfirmOverwrite;
+            ImGuiFileDialog::Instance()->OpenDialog("save_telemetry_key", "Export Telemetry", ".json,.csv",
+                                                    file_dlg_config);
+        }
+    } else {
+        if (ImGui::Button("Stop Export", ImVec2(200, 0))) { telemetry_export.reset(); }
+    }
+    ImGui::SameLine();
+    help_marker("Appends a sample of every instance and the totals at each interval, as JSON lines or CSV rows "
+        "depending on the extension.");
+    if (ImGuiFileDialog::Instance()->Display("save_telemetry_key")) {
+        if (ImGuiFileDialog::Instance()->IsOk()) {
+            try {
+                telemetry_export = std::make_unique<telemetry_writer>(ImGuiFileDialog::Instance()->GetFilePathName());
+                export_countdown = 0;
+            } catch (const std::invalid_argument &e) {
+                error = e.what();
+                modal = true;
+            }
+        }
+        ImGuiFileDialog::Instance()->Close();
+    }
+}
+
+void instance_manager::start_search() {
+    const auto &primary = instances[selected_id];
+    search_ids = {primary.get_id()};
+    if (search_same_rom) {
+        for (auto &instance: instances) {
+            if (instance.get_id() != primary.get_id() && instance.get_state() != instance::state::EMPTY &&
+                instance.get_rom_path() == primary.get_rom_path() &&
+                instance.get_alt_ops().variant == primary.get_alt_ops().variant) {
+                instance.wake();
+                search_ids.push_back(instance.get_id());
+            }
+        }
+    }
+    search.reset(search_memories());
+}
+
+auto instance_manager::search_memories() -> std::span<const std::span<const std::uint8_t>> {
+    search_mems.clear();
+    for (const auto id: search_ids) {
+        const auto it = std::ranges::find_if(instances, [id](const instance &instance) {
+            return instance.get_id() == id;
+        });
+        if (it == instances.end() || (!search_mems.empty() && it->get_mem().size() != search_mems.front().size())) {
+            search_mems.clear();
+            break;
+        }
+        search_mems.push_back(it->get_mem());
+    }
+    return search_mems;
+}
+
+void instance_manager::ram_search_window() {
+    if (!ImGui::Begin("RAM Search")) {
+        ImGui::End();
+        return;
+    }
+    const auto &primary = instances[selected_id];
+
+    ImGui::BeginDisabled(primary.get_state() == instance::state::EMPTY);
+    if (ImGui::Button("New Search", ImVec2(200, 0))) { start_search(); }
+    ImGui::EndDisabled();
+    ImGui::SameLine();
+    ImGui::Checkbox("Every instance running this ROM", &search_same_rom);
+    ImGui::SameLine();
+    help_marker("Snapshots memory and starts over with every address a candidate. Each filter keeps the addresses "
+        "meeting the condition against the last snapshot, then snapshots again. With every instance running the same "
+        "ROM, an address must meet the condition in all of them, which narrows a score or lives counter quickly when "
+        "the instances play differently.");
 
-    static constexpr std::chrono::nanoseconds timer_interval(16'666'667);
-    std::chrono::nanoseconds cycle_interval(static_cast<unsigned>(std::round(1e9 / ips)));
+    const auto mems = search_memories();
+    const bool active = search.get_lanes() > 0 && search_ids.front() == primary.get_id();
+    // a searched instance was deleted or loaded a ROM for another variant
+    if (active && (mems.empty() || mems.front().size() != search.get_size())) {
+        search = {};
+        search_ids.clear();
+    }
+    // turbo instances run on their own thread
+    const bool busy = std::ranges::any_of(search_ids, [this](const std::size_t id) {
+        return std::ranges::any_of(instances, [id](const instance &instance) {
+            return instance.get_id() == id && instance.get_state() == instance::state::TURBO;
+        });
+    });
+
+    ImGui::BeginDisabled(!active || mems.empty() || busy);
+    auto condition = static_cast<int>(search_condition);
+    ImGui::SetNextItemWidth(200);
+    if (ImGui::Combo("Condition", &condition, ram_search::condition_strings.data(),
+                     static_cast<int>(ram_search::condition_strings.size()))) {
+        search_condition = static_cast<ram_search::condition>(condition);
+    }
+    if (ram_search::takes_value(search_condition)) {
+        ImGui::SetNextItemWidth(200);
+        ImGui::InputScalar("Value", ImGuiDataType_U8, &search_value, nullptr, nullptr, "%02X",
+                           ImGuiInputTextFlags_CharsHexadecimal);
+    }
+    if (ImGui::Button("Filter", ImVec2(200, 0)) || (search_every_frame && active && !mems.empty() && !busy)) {
+        search.filter(mems, search_condition, search_value);
+    }
+    ImGui::SameLine();
+    ImGui::Checkbox("Every frame", &search_every_frame);
+    ImGui::EndDisabled();
+
+    if (!active || mems.empty()) {
+        ImGui::TextDisabled("No search for this instance");
+        ImGui::End();
+        return;
+    }
+    ImGui::Text("%zu candidates across %zu instances after %llu filters", search.get_candidates().size(),
+                search.get_lanes(), static_cast<unsigned long long>(search.get_filters()));
+
+    static constexpr ImGuiTableFlags flags =
+            (ImGuiTableFlags_Borders ^ ImGuiTableFlags_BordersInnerV) | ImGuiTableFlags_ScrollY;
+    if (ImGui::BeginTable("search_table", 3, flags)) {
+        ImGui::TableSetupColumn("ADDR");
+        ImGui::TableSetupColumn("VAL");
+        ImGui::TableSetupColumn("PREV");
+        ImGui::TableSetupScrollFreeze(0, 1);
+        ImGui::TableHeadersRow();
+        const auto &candidates = search.get_candidates();
+        ImGuiListClipper clipper;
+        clipper.Begin(static_cast<int>(candidates.size()));
+        while (clipper.Step()) {
+            for (auto row = clipper.DisplayStart; row < clipper.DisplayEnd; ++row) {
+                const auto addr = candidates[row];
+                ImGui::TableNextColumn();
+                ImGui::Text("%04X", addr);
+                ImGui::TableNextColumn();
+                ImGui::Text("%02X", mems.front()[addr]);
+                ImGui::TableNextColumn();
+                ImGui::Text("%02X", search.get_previous(0, addr));
+            }
+        }
+        ImGui::EndTable();
+    }
+    ImGui::End();
+}
+
+void instance_manager::start_bisect() {
+    const auto &primary = instances[selected_id];
+    auto run = std::make_unique<bisect_run>();
+    run->id = primary.get_id();
+    run->rom_path = primary.get_rom_path();
+    quirk_bisect::options opts;
+    opts.cycles_per_frame = primary.cycles_per_frame();
+    opts.cycles = static_cast<std::uint64_t>(bisect_frames) * opts.cycles_per_frame;
+    run->worker = std::jthread([run = run.get(), opts, reference = primary.get_alt_ops()](const std::stop_token &stop) {
+        try {
+            run->report = quirk_bisect::run(run->rom_path, reference, opts, headless::load_input({}, opts.cycles), stop);
+        } catch (const std::invalid_argument &e) {
+            run->error = e.what();
+        }
+        run->done.store(true, std::memory_order_release);
+    });
+    // replacing a bisect still running stops it first
+    bisect = std::move(run);
+}
+
+void instance_manager::quirk_bisect_window() {
+    if (!ImGui::Begin("Quirk Bisect")) {
+        ImGui::End();
+        return;
+    }
+    const auto &primary = instances[selected_id];
+    const bool running = bisect && !bisect->done.load(std::memory_order_acquire);
+
+    ImGui::BeginDisabled(primary.get_state() == instance::state::EMPTY || running);
+    if (ImGui::Button("Bisect Quirks", ImVec2(200, 0))) { start_bisect(); }
+    ImGui::EndDisabled();
+    ImGui::SameLine();
+    ImGui::SetNextItemWidth(200);
+    if (ImGui::InputInt("Frames", &bisect_frames, 60, 600)) { bisect_frames = std::clamp(bisect_frames, 1, 360'000); }
+    ImGui::SameLine();
+    help_marker("Runs this ROM from power on under all 24 quirk combinations at once, with the same seed and every "
+        "key pressed in turn, and compares each against this instance's quirks at the end of every frame. For each "
+        "combination that behaves differently it shows the first instruction whose result differs and the quirk "
+        "whose flip alone changes it. Combinations that never differ are left out.");
+
+    if (!bisect || bisect->id != primary.get_id()) {
+        ImGui::TextDisabled("No bisect for this instance");
+        ImGui::End();
+        return;
+    }
+    if (running) {
+        ImGui::Text("Bisecting %s...", bisect->rom_path.c_str());
+        if (ImGui::Button("Cancel", ImVec2(200, 0))) {
+            bisect->cancelled = true;
+            bisect->worker.request_stop();
+        }
+        ImGui::End();
+        return;
+    }
+    if (!bisect->error.empty()) {
+        ImGui::TextColored(ImVec4(1.0f, 0.3f, 0.3f, 1.0f), "%s", bisect->error.c_str());
+        ImGui::End();
+        return;
+    }
+
+    const auto &rep = bisect->report;
+    const auto diverged = std::ranges::count_if(rep.outcomes, &quirk_bisect::outcome::diverged);
+    ImGui::Text("%lld of %zu combinations differ from %s in %.2f s%s", static_cast<long long>(diverged),
+                rep.outcomes.size() - 1, quirk_bisect::describe(rep.reference).c_str(), rep.seconds,
+                bisect->cancelled ? ", cancelled" : "");
+
+    static constexpr ImGuiTableFlags flags =
+            (ImGuiTableFlags_Borders ^ ImGuiTableFlags_BordersInnerV) | ImGuiTableFlags_ScrollY;
+    if (ImGui::BeginTable("bisect_table", 5, flags)) {
+        ImGui::TableSetupColumn("Quirks");
+        ImGui::TableSetupColumn("Cycle");
+        ImGui::TableSetupColumn("PC");
+        ImGui::TableSetupColumn("Instruction");
+        ImGui::TableSetupColumn("Blamed");
+        ImGui::TableSetupScrollFreeze(0, 1);
+        ImGui::TableHeadersRow();
+        for (const auto &out: rep.outcomes) {
+            if (!out.diverged) { continue; }
+            ImGui::TableNextColumn();
+            ImGui::Text("%s", quirk_bisect::describe(out.combo).c_str());
+            ImGui::TableNextColumn();
+            ImGui::Text("%llu", static_cast<unsigned long long>(out.cycle));
+            ImGui::TableNextColumn();
+            ImGui::Text("%03X", out.pc);
+            ImGui::TableNextColumn();
+            ImGui::Text("%s", out.instruction.c_str());
+            ImGui::TableNextColumn();
+            ImGui::Text("%s", out.culprit ? quirk_bisect::quirk_strings[static_cast<int>(*out.culprit)] : "combination");
+        }
+        ImGui::EndTable();
+    }
+    ImGui::End();
+}
+
+auto instance_manager::instance::cycle_interval() const -> std::chrono::nanoseconds {
+    return std::chrono::nanoseconds(static_cast<unsigned>(std::round(1e9 / ips)));
+}
+
+auto instance_manager::instance::target_ips() const -> double {
+    return state == state::RUNNING ? static_cast<double>(ips) * multiplier : 0;
+}
+
+auto instance_manager::instance::cycles_per_frame() const -> std::uint64_t {
+    const auto per_frame = static_cast<double>(ips) * multiplier * std::chrono::duration<double>(TIMER_INTERVAL).count();
+    return std::max<std::uint64_t>(1, std::llround(per_frame));
+}
+
+auto instance_manager::instance::telemetry() const -> telemetry_row {
+    const auto rates = stats ? stats->last : instance_telemetry::rates{};
+    return {id, state_strings[static_cast<int>(state)], target_ips(), rates, stats ? stats->behind : 0};
+}
+
+void instance_manager::instance::sample_telemetry(const std::chrono::duration<double> elapsed) {
+    if (!stats) {
+        if (state != state::TURBO) { return; }
+        stats = std::make_unique<instance_telemetry>();
+    }
+    stats->sample(elapsed);
+    // turbo runs on its own thread and keeps its own count
+    if (state == state::TURBO) { stats->last.ips = turbo->mips * 1e6; }
+}
+
+auto instance_manager::instance::next_deadline() const -> std::chrono::time_point<std::chrono::steady_clock> {
+    if (ips == 0) { return last_timer_time + TIMER_INTERVAL; }
+    return std::min(last_timer_time + TIMER_INTERVAL, last_cycle_time + cycle_interval());
+}
+
+auto instance_manager::instance::urgency(const std::chrono::time_point<std::chrono::steady_clock> now) const -> double {
+    static constexpr std::array<double, 3> weights{4, 2, 1};
+    return std::chrono::duration<double>(now - next_deadline()).count() * weights[static_cast<int>(priority)];
+}
+
+auto instance_manager::instance::over_budget(const std::chrono::nanoseconds window) const -> bool {
+    return cpu_limit != 0 && stats && stats->run_time * 100 > window * cpu_limit;
+}
+
+void instance_manager::instance::throttle() {
+    if (!stats) { stats = std::make_unique<instance_telemetry>(); }
+    if (!stats->held_back) { ++stats->throttled; }
+    stats->held_back = true;
+}
+
+void instance_manager::instance::run() {
+    if (ips == 0) {
+        apply_input(std::chrono::steady_clock::now());
+        return;
+    }
+    if (!stats) { stats = std::make_unique<instance_telemetry>(); }
+    stats->held_back = false;
 
     auto current_time = std::chrono::steady_clock::now();
     auto elapsed_timer_time = current_time - last_timer_time;
     auto elapsed_cycle_time = current_time - last_cycle_time;
 
-    if (elapsed_timer_time >= timer_interval) {
-        interpreter.decrement_timers();
+    if (elapsed_timer_time >= TIMER_INTERVAL) {
+        if (voice) { voice->generate(*interpreter, audio_voice::FRAME_SAMPLES); }
+        interpreter->decrement_timers();
+        if (recording) { recording->record_tick(movie_cycle); }
+        if (video) { video->capture(*interpreter); }
         last_timer_time = current_time;
     }
 
-    if (elapsed_cycle_time >= cycle_interval) {
-        for (unsigned char i = 0; i < multiplier; ++i) {
-            interpreter.run_cycle();
-            while (instruction_log.size() >= instruction_log_max) { instruction_log.pop_front(); }
-            instruction_log.emplace_back(interpreter.get_instruction());
+    if (elapsed_cycle_time >= cycle_interval()) {
+        // intervals the main loop slept through are dropped, not caught up
+        stats->behind += static_cast<std::uint64_t>(elapsed_cycle_time / cycle_interval() - 1) * multiplier;
+        ++stats->batches;
+        for (unsigned i = 0; i < multiplier;) {
+            apply_input(last_cycle_time + elapsed_cycle_time * i / multiplier);
+            // single cycles while input is pending or the log is on screen, otherwise the rest of the batch
+            const auto budget = (ui && ui->log_visible) || !pending_input.empty() ? 1u : multiplier - i;
+            const auto [reason, cycles] = interpreter->run_cycles(budget, true);
+            i += static_cast<unsigned>(cycles);
+            movie_cycle += cycles;
+            stats->cycles += cycles;
+            if (selected) { log_instruction(); }
+            if (reason == chip8::stop_reason::draw) { ++stats->draws; }
+            if (reason == chip8::stop_reason::breakpoint) {
+                state = state::LOADED;
+                break;
+            }
+            if (reason == chip8::stop_reason::halted ||
+                (reason == chip8::stop_reason::key_wait && pending_input.empty())) {
+                ++stats->waits;
+                break;
+            }
         }
-        scroll_flag = true;
+        if (ui) { ui->scroll_flag = true; }
         last_cycle_time = current_time;
     }
+    stats->run_time += std::chrono::steady_clock::now() - current_time;
+}
+
+void instance_manager::instance::step() {
+    movie_cycle += interpreter->run_cycles(1).cycles;
+    log_instruction();
+    if (ui) { ui->scroll_flag = true; }
+}
+
+void instance_manager::instance::log_instruction() {
+    if (!ui) { return; }
+    const auto op = interpreter->get_executed();
+    if (op.pc != 0) { ui->log(op); }
 }
 
 void instance_manager::instance::reset() {
-    interpreter.reset();
-    instruction_log.clear();
+    interpreter->reset();
+    if (ui) { ui->clear_log(); }
+}
+
+void instance_manager::instance::set_speed(const unsigned short ips, const unsigned char multiplier) {
+    this->ips = ips;
+    this->multiplier = multiplier;
+}
+
+void instance_manager::instance::set_tickrate(const unsigned tickrate, const unsigned short ips_max) {
+    // programs.json counts cycles per 60 Hz frame, spread over as many batches a second as the display allows
+    const auto total = std::uint64_t{tickrate} * 60;
+    const auto batch = std::clamp<std::uint64_t>((total + ips_max - 1) / ips_max, 1, MULTIPLIER_MAX);
+    set_speed(static_cast<unsigned short>(std::clamp<std::uint64_t>((total + batch / 2) / batch, 1, ips_max)),
+              static_cast<unsigned char>(batch));
+    this->tickrate = static_cast<unsigned short>(std::min(tickrate, 0xFFFFu));
 }
 
 void instance_manager::instance::load(const std::string_view path) {
+    stop_turbo();
+    recording.reset();
+    playback.reset();
+    tickrate = 0;
     try {
-        interpreter.unload_rom();
+        interpreter->unload_rom();
         state = state::EMPTY;
-        interpreter.load_rom(path);
+        interpreter->load_rom(path);
+        rom_path = path;
         state = state::LOADED;
     } catch (const std::invalid_argument &e) {
         error = e.what();
@@ -278,9 +995,191 @@ void instance_manager::instance::load(const std::string_view path) {
     }
 }
 
-void instance_manager::instance::process_input() {
-    for (std::size_t i = 0; i < chip8::KEY_COUNT; ++i) {
-        interpreter.keys[i] = ImGui::IsKeyDown(input[i]);
+void instance_manager::instance::queue_input(const key_event &event) { pending_input.push_back(event); }
+
+void instance_manager::instance::apply_input(const std::chrono::time_point<std::chrono::steady_clock> time) {
+    std::array<bool, chip8::KEY_COUNT> pressed{};
+    std::array<bool, chip8::KEY_COUNT> deferred{};
+    auto kept = pending_input.begin();
+    auto it = pending_input.begin();
+    for (; it != pending_input.end() && it->time <= time; ++it) {
+        // a release in the same cycle as its press is held back so the press lasts at least one cycle, along with
+        // whatever follows for that key; the other keys go ahead
+        if (deferred[it->key] || (!it->down && pressed[it->key])) {
+            deferred[it->key] = true;
+            *kept++ = *it;
+            continue;
+        }
+        if (recording && interpreter->keys[it->key] != it->down) {
+            recording->record_key(movie_cycle, it->key, it->down);
+        }
+        interpreter->keys[it->key] = it->down;
+        pressed[it->key] = it->down;
+    }
+    pending_input.erase(kept, it);
+}
+
+void instance_manager::instance::start_turbo() {
+    if (state == state::EMPTY || state == state::TURBO) { return; }
+
+    const std::uint64_t limit = turbo_cycle_limit;
+    const std::uint64_t cycles_per_tick = std::max<std::uint64_t>(1, static_cast<std::uint64_t>(ips) * multiplier / 60);
+
+    turbo = std::make_unique<turbo_run>();
+    state = state::TURBO;
+    turbo->worker = std::jthread([interpreter = interpreter.get(), turbo = turbo.get(), video = video.get(), limit,
+                cycles_per_tick](const std::stop_token &stop) {
+                static constexpr std::uint64_t chunk = 0x1000;
+                std::uint64_t cycles = 0;
+                std::uint64_t tick = 0;
+                const char *reason = nullptr;
+                while (reason == nullptr) {
+                    if (stop.stop_requested()) {
+                        reason = "Stopped";
+                        break;
+                    }
+                    if (limit != 0 && cycles == limit) {
+                        reason = "Cycle limit reached";
+                        break;
+                    }
+                    auto budget = std::min(chunk, cycles_per_tick - tick);
+                    if (limit != 0) { budget = std::min(budget, limit - cycles); }
+                    const auto result = interpreter->run_cycles(budget);
+                    cycles += result.cycles;
+                    tick += result.cycles;
+                    if (tick == cycles_per_tick) {
+                        interpreter->decrement_timers();
+                        if (video != nullptr) { video->capture(*interpreter); }
+                        tick = 0;
+                    }
+                    if (result.reason == chip8::stop_reason::halted) { reason = "Halted"; }
+                    if (result.reason == chip8::stop_reason::breakpoint) { reason = "Breakpoint hit"; }
+                    // no input reaches the turbo thread, Fx0A would wait a cycle at a time forever
+                    if (result.reason == chip8::stop_reason::key_wait) { reason = "Waiting for key"; }
+                    turbo->cycles.store(cycles, std::memory_order_relaxed);
+                }
+                turbo->finish(reason);
+            });
+}
+
+void instance_manager::instance::turbo_run::finish(const char *reason) {
+    stop_reason = reason;
+    end_time = std::chrono::steady_clock::now();
+    done.store(true, std::memory_order_release);
+}
+
+void instance_manager::instance::stop_turbo() {
+    if (turbo && turbo->worker.joinable()) {
+        turbo->worker.request_stop();
+        turbo->worker.join();
+    }
+    // only the worker reads the movie, and a finished one would keep the instance from hibernating
+    playback.reset();
+    if (state == state::TURBO) {
+        state = state::LOADED;
+        interpreter->drw_flag = true;
+    }
+}
+
+void instance_manager::instance::replace_interpreter(std::unique_ptr<chip8> replacement) {
+    interpreter = std::move(replacement);
+    interpreter->set_trace_id(static_cast<std::uint32_t>(id));
+    for (const auto addr: breakpoints) { interpreter->set_breakpoint(addr, true); }
+    if (ui) { ui->clear_log(); }
+    state = state::LOADED;
+}
+
+// recordings start from power on, so the interpreter is rebuilt with a fresh seed and ROM
+void instance_manager::instance::start_recording() {
+    if (state == state::EMPTY) { return; }
+    stop_turbo();
+    try {
+        auto m = std::make_unique<movie>(rom_path, std::random_device{}(), alt_ops);
+        replace_interpreter(m->make_interpreter());
+        recording = std::move(m);
+        movie_cycle = 0;
+    } catch (const std::invalid_argument &e) {
+        error = e.what();
+        modal = true;
+    }
+}
+
+void instance_manager::instance::stop_recording(const std::string_view path) {
+    recording->length = movie_cycle;
+    try {
+        recording->save(path);
+    } catch (const std::invalid_argument &e) {
+        error = e.what();
+        modal = true;
+    }
+    recording.reset();
+}
+
+// plays back on the turbo worker, unthrottled, leaving the interpreter at the movie's final state
+void instance_manager::instance::start_playback(const std::string_view path) {
+    stop_turbo();
+    recording.reset();
+    try {
+        playback = std::make_unique<movie>(movie::load(path));
+        replace_interpreter(playback->make_interpreter());
+    } catch (const std::invalid_argument &e) {
+        playback.reset();
+        error = e.what();
+        modal = true;
+        return;
+    }
+    alt_ops = playback->alt_ops;
+    rom_path = playback->rom;
+
+    turbo = std::make_unique<turbo_run>();
+    state = state::TURBO;
+    turbo->worker = std::jthread([interpreter = interpreter.get(), turbo = turbo.get(), playback = playback.get(),
+                video = video.get()](const std::stop_token &stop) {
+                static constexpr std::uint64_t chunk = 0x1000;
+                std::function<void(const chip8 &)> on_tick;
+                if (video != nullptr) { on_tick = [video](const chip8 &c) { video->capture(c); }; }
+                movie_player player(*playback, on_tick);
+                const char *reason = "Movie finished";
+                while (!player.done()) {
+                    if (stop.stop_requested()) {
+                        reason = "Stopped";
+                        break;
+                    }
+                    player.play(*interpreter, chunk);
+                    turbo->cycles.store(player.get_cycle(), std::memory_order_relaxed);
+                }
+                turbo->finish(reason);
+            });
+}
+
+void instance_manager::instance::start_video(const std::string_view path) {
+    try {
+        video = std::make_shared<video_recorder>(make_video_sink(path));
+        video_encoder::global().add(video);
+    } catch (const std::invalid_argument &e) {
+        error = e.what();
+        modal = true;
+    }
+}
+
+void instance_manager::instance::stop_video() {
+    if (!video) { return; }
+    video->close();
+    video.reset();
+}
+
+void instance_manager::instance::poll_turbo() {
+    const auto now = std::chrono::steady_clock::now();
+    const auto cycles = turbo->cycles.load(std::memory_order_relaxed);
+    const std::chrono::duration<double> elapsed = now - turbo->sample_time;
+    if (elapsed.count() >= 0.25) {
+        turbo->mips = static_cast<double>(cycles - turbo->sample_cycles) / elapsed.count() / 1e6;
+        turbo->sample_cycles = cycles;
+        turbo->sample_time = now;
+    }
+    if (turbo->done.load(std::memory_order_acquire)) {
+        stop_turbo();
+        if (ui) { ui->scroll_flag = true; }
     }
 }
 
@@ -293,43 +1192,191 @@ void instance_manager::instance::controller_window() {
     constexpr unsigned short speed_min = 0;
     unsigned short speed_max = glfwGetVideoMode(monitor)->refreshRate;
     constexpr unsigned char multiplier_min = 1;
-    constexpr unsigned char multiplier_max = 50;
+    constexpr unsigned char multiplier_max = MULTIPLIER_MAX;
     ImGui::SliderScalar("Execution Speed", ImGuiDataType_U16, &ips, &speed_min, &speed_max, "%u ips");
     ImGui::SliderScalar("Speed Multiplier", ImGuiDataType_U8, &multiplier, &multiplier_min, &multiplier_max, "x%u");
+    if (std::uint64_t{tickrate} * 60 > std::uint64_t{speed_max} * multiplier_max) {
+        ImGui::TextColored(ImVec4(1.0f, 0.7f, 0.2f, 1.0f), "The ROM asks for %u cycles a frame, the sliders reach %u",
+                           static_cast<unsigned>(tickrate), static_cast<unsigned>(speed_max * multiplier_max / 60));
+    }
+    constexpr unsigned char cpu_limit_min = 0;
+    constexpr unsigned char cpu_limit_max = 100;
+    auto priority_index = static_cast<int>(priority);
+    if (ImGui::Combo("Priority", &priority_index, priority_strings.data(), static_cast<int>(priority_strings.size()))) {
+        priority = static_cast<enum priority>(priority_index);
+    }
+    ImGui::SliderScalar("CPU Limit", ImGuiDataType_U8, &cpu_limit, &cpu_limit_min, &cpu_limit_max,
+                        cpu_limit == 0 ? "None" : "%u%% of a core");
+    ImGui::SameLine();
+    help_marker("Apply while the instance is not selected. The selected instance always runs first at its full "
+        "speed. The others share what is left: each loop gives them 4 ms, the most overdue first, with High "
+        "weighted twice Normal and Normal twice Low. An instance over its CPU limit waits for the next second.");
     ImGui::Separator();
     ImGui::BeginDisabled(state == state::EMPTY);
-    ImGui::BeginDisabled(state == state::RUNNING);
-    if (ImGui::Button("Run", ImVec2(200, 0))) { state = state::RUNNING; }
-    if (ImGui::Button("Step", ImVec2(200, 0))) { run(); }
+    ImGui::BeginDisabled(state == state::RUNNING || state == state::TURBO);
+    if (ImGui::Button("Run", ImVec2(200, 0))) {
+        // due at once, without counting the time spent stopped as behind schedule
+        last_cycle_time = std::chrono::steady_clock::now();
+        if (ips > 0) { last_cycle_time -= cycle_interval(); }
+        state = state::RUNNING;
+    }
+    if (ImGui::Button("Step", ImVec2(200, 0))) { step(); }
+    ImGui::BeginDisabled(recording != nullptr);
+    if (ImGui::Button("Turbo", ImVec2(200, 0))) { start_turbo(); }
+    ImGui::EndDisabled();
     ImGui::EndDisabled();
-    if (ImGui::Button("Stop", ImVec2(200, 0))) { state = state::LOADED; }
+    if (ImGui::Button("Stop", ImVec2(200, 0))) {
+        stop_turbo();
+        state = state::LOADED;
+    }
+    ImGui::BeginDisabled(state == state::TURBO || recording != nullptr);
     if (ImGui::Button("Reset", ImVec2(200, 0))) { reset(); }
     if (ImGui::Button("Reset + Stop", ImVec2(200, 0))) {
         reset();
         state = state::LOADED;
     }
     ImGui::EndDisabled();
+    ImGui::EndDisabled();
     ImGui::Checkbox("Enable Input", &input_enabled);
+    if (ImGui::Checkbox("Enable Audio", &audio_enabled)) {
+        if (audio_enabled) {
+            voice = std::make_shared<audio_voice>();
+            audio_mixer::global().add(voice);
+        } else {
+            voice.reset();
+        }
+    }
+
+    ImGui::SeparatorText("Movie");
+    ImGui::BeginDisabled(state == state::TURBO);
+    if (!recording) {
+        ImGui::BeginDisabled(state == state::EMPTY);
+        if (ImGui::Button("Record", ImVec2(200, 0))) { start_recording(); }
+        ImGui::EndDisabled();
+    } else {
+        if (ImGui::Button("Stop Recording", ImVec2(200, 0))) {
+            IGFD::FileDialogConfig file_dlg_config;
+            file_dlg_config.path = ".";
+            file_dlg_config.flags = ImGuiFileDialogFlags_Modal | ImGuiFileDialogFlags_ConfirmOverwrite;
+            ImGuiFileDialog::Instance()->OpenDialog("save_movie_key", "Save Movie", ".m8m", file_dlg_config);
+        }
+        ImGui::SameLine();
+        if (ImGui::Button("Discard")) { recording.reset(); }
+        ImGui::Text("%zu events over %llu cycles", recording->events.size(),
+                    static_cast<unsigned long long>(movie_cycle));
+    }
+    if (ImGui::Button("Play Movie", ImVec2(200, 0))) {
+        IGFD::FileDialogConfig file_dlg_config;
+        file_dlg_config.path = ".";
+        file_dlg_config.countSelectionMax = 1;
+        file_dlg_config.flags = ImGuiFileDialogFlags_Modal;
+        ImGuiFileDialog::Instance()->OpenDialog("play_movie_key", "Play Movie", ".m8m", file_dlg_config);
+    }
+    ImGui::SameLine();
+    help_marker("A movie records the seed, quirks and every input change and timer tick by cycle from power on. "
+        "Playback runs unthrottled like Turbo and reproduces the session exactly.");
+    ImGui::EndDisabled();
+    if (ImGuiFileDialog::Instance()->Display("save_movie_key")) {
+        if (ImGuiFileDialog::Instance()->IsOk() && recording) {
+            stop_recording(ImGuiFileDialog::Instance()->GetFilePathName());
+        }
+        ImGuiFileDialog::Instance()->Close();
+    }
+    if (ImGuiFileDialog::Instance()->Display("play_movie_key")) {
+        if (ImGuiFileDialog::Instance()->IsOk()) { start_playback(ImGuiFileDialog::Instance()->GetFilePathName()); }
+        ImGuiFileDialog::Instance()->Close();
+    }
+
+    ImGui::SeparatorText("Video");
+    ImGui::BeginDisabled(state == state::TURBO);
+    if (!video) {
+        if (ImGui::Button("Record Video", ImVec2(200, 0))) {
+            IGFD::FileDialogConfig file_dlg_config;
+            file_dlg_config.path = ".";
+            file_dlg_config.flags = ImGuiFileDialogFlags_Modal | ImGuiFileDialogFlags_ConfirmOverwrite;
+            ImGuiFileDialog::Instance()->OpenDialog("save_video_key", "Record Video", ".gif,.png,.y4m",
+                                                    file_dlg_config);
+        }
+    } else {
+        if (ImGui::Button("Stop Video", ImVec2(200, 0))) { stop_video(); }
+    }
+    ImGui::SameLine();
+    help_marker("Captures a frame at every 60 Hz timer tick, including in Turbo and movie playback, and encodes "
+        "on a background thread. The format follows the extension: animated GIF, APNG (.png) or Y4M. Capture never "
+        "holds up emulation, so Turbo can outrun the encoder and drop frames; mic8_bench.elf --movie file --video gif "
+        "exports a movie losslessly.");
+    ImGui::EndDisabled();
+    if (video) {
+        ImGui::Text("%llu frames, %llu dropped", static_cast<unsigned long long>(video->get_frames()),
+                    static_cast<unsigned long long>(video->get_dropped()));
+    }
+    if (ImGuiFileDialog::Instance()->Display("save_video_key")) {
+        if (ImGuiFileDialog::Instance()->IsOk()) { start_video(ImGuiFileDialog::Instance()->GetFilePathName()); }
+        ImGuiFileDialog::Instance()->Close();
+    }
+
+    ImGui::SeparatorText("Turbo");
+    ImGui::BeginDisabled(state == state::TURBO);
+    ImGui::InputScalar("Cycle Limit", ImGuiDataType_U64, &turbo_cycle_limit);
+    ImGui::SameLine();
+    help_marker("Turbo runs unthrottled until this many cycles have executed (0 for no limit), the interpreter "
+        "halts, a breakpoint is hit or Stop is pressed. Timers tick every (ips * multiplier / 60) cycles. "
+        "Breakpoints also stop a normal run.");
+    ImGui::InputScalar("Breakpoint", ImGuiDataType_U16, &breakpoint_addr, nullptr, nullptr, "%03X",
+                       ImGuiInputTextFlags_CharsHexadecimal);
+    ImGui::SameLine();
+    if (ImGui::Button("Add") && breakpoint_addr < interpreter->get_mem().size() &&
+        !std::ranges::binary_search(breakpoints, breakpoint_addr)) {
+        breakpoints.insert(std::ranges::upper_bound(breakpoints, breakpoint_addr), breakpoint_addr);
+        interpreter->set_breakpoint(breakpoint_addr, true);
+    }
+    for (auto it = breakpoints.begin(); it != breakpoints.end();) {
+        ImGui::PushID(*it);
+        ImGui::Text("0x%03X", *it);
+        ImGui::SameLine();
+        if (ImGui::Button("Remove")) {
+            interpreter->set_breakpoint(*it, false);
+            it = breakpoints.erase(it);
+        } else {
+            ++it;
+        }
+        ImGui::PopID();
+    }
+    ImGui::EndDisabled();
+    if (turbo) {
+        const auto cycles = turbo->cycles.load(std::memory_order_relaxed);
+        const auto end = state == state::TURBO ? std::chrono::steady_clock::now() : turbo->end_time;
+        const std::chrono::duration<double> elapsed = end - turbo->start_time;
+        const double mips = state == state::TURBO ? turbo->mips : static_cast<double>(cycles) / elapsed.count() / 1e6;
+        ImGui::Text("%.2f MIPS", mips);
+        ImGui::Text("%llu cycles in %.2f s", static_cast<unsigned long long>(cycles), elapsed.count());
+        if (state != state::TURBO) { ImGui::Text("%s", turbo->stop_reason); }
+    }
     ImGui::End();
 }
 
 void instance_manager::instance::fb_window() {
-    if (interpreter.drw_flag) {
+    if (!ui) {
+        ui = std::make_unique<view>();
+        interpreter->drw_flag = true;
+    }
+    if (interpreter->drw_flag) {
 #if defined(GL_UNPACK_ROW_LENGHT) && !defined(__EMSCRIPTEM__)
         glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
 #endif
-        glBindTexture(GL_TEXTURE_2D, tex_id);
-        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, chip8::VIDEO_WIDTH, chip8::VIDEO_HEIGHT, GL_RGBA, GL_UNSIGNED_BYTE,
-                        interpreter.get_fb().data());
+        glBindTexture(GL_TEXTURE_2D, ui->tex_id);
+        convert_fb(*interpreter);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, chip8::HIRES_WIDTH, chip8::HIRES_HEIGHT, GL_RGBA, GL_UNSIGNED_BYTE,
+                        fb_pixels.data());
         glBindTexture(GL_TEXTURE_2D, 0);
-        interpreter.drw_flag = false;
+        interpreter->drw_flag = false;
     }
     if (!ImGui::Begin("Frame Buffer", &windows.show_fb)) {
         ImGui::End();
         return;
     }
     const auto fb_window_height = ImGui::GetContentRegionAvail().y;
-    ImGui::Image(reinterpret_cast<void *>(static_cast<std::uintptr_t>(tex_id)),
+    ImGui::Image(reinterpret_cast<void *>(static_cast<std::uintptr_t>(ui->tex_id)),
                  ImVec2(fb_window_height * 2, fb_window_height));
     // NOLINT(*-pro-type-reinterpret-cast, *-no-int-to-ptr)
     ImGui::End();
@@ -345,7 +1392,7 @@ void instance_manager::instance::cpu_view_window() {
             ImGui::TableSetupColumn("REG");
             ImGui::TableSetupColumn("VAL");
             ImGui::TableHeadersRow();
-            for (unsigned char i = 0; const auto &reg: interpreter.get_reg()) {
+            for (unsigned char i = 0; const auto &reg: interpreter->get_reg()) {
                 ImGui::TableNextColumn();
                 ImGui::Text("V%X", i);
                 ImGui::TableNextColumn();
@@ -359,13 +1406,13 @@ void instance_manager::instance::cpu_view_window() {
             ImGui::TableSetupColumn("LVL");
             ImGui::TableSetupColumn("ADDR");
             ImGui::TableHeadersRow();
-            for (unsigned char i = 0; const auto &addr: interpreter.get_stack()) {
+            for (unsigned char i = 0; const auto &addr: interpreter->get_stack()) {
                 ImGui::TableNextColumn();
-                if (i < interpreter.get_sp() - 1) {
+                if (i < interpreter->get_sp() - 1) {
                     ImGui::Text("%d", i);
                     ImGui::TableNextColumn();
                     ImGui::Text("%04x", addr);
-                } else if (i == interpreter.get_sp() - 1) {
+                } else if (i == interpreter->get_sp() - 1) {
                     ImGui::TableSetBgColor(ImGuiTableBgTarget_RowBg0, ImGui::GetColorU32(ImGuiCol_HeaderHovered));
                     ImGui::Text("%d", i);
                     ImGui::TableNextColumn();
@@ -381,15 +1428,15 @@ void instance_manager::instance::cpu_view_window() {
         }
         if (ImGui::BeginTable("other_registers", 2, 0, ImVec2(128.0f, 0.0f))) {
             ImGui::TableNextColumn();
-            ImGui::Text("PC: %X", interpreter.get_pc());
+            ImGui::Text("PC: %X", interpreter->get_pc());
             ImGui::TableNextColumn();
-            ImGui::Text("DT: %X", interpreter.get_dt());
+            ImGui::Text("DT: %X", interpreter->get_dt());
             ImGui::TableNextColumn();
-            ImGui::Text("IR: %X", interpreter.get_ir());
+            ImGui::Text("IR: %X", interpreter->get_ir());
             ImGui::TableNextColumn();
-            ImGui::Text("ST: %X", interpreter.get_st());
+            ImGui::Text("ST: %X", interpreter->get_st());
             ImGui::TableNextColumn();
-            ImGui::Text("SP: %X", interpreter.get_sp());
+            ImGui::Text("SP: %X", interpreter->get_sp());
             ImGui::EndTable();
         }
     }
@@ -401,23 +1448,79 @@ void instance_manager::instance::mem_view_window() {
         ImGui::End();
         return;
     }
-    mem_edit.HighlightMin = interpreter.get_pc();
-    mem_edit.HighlightMax = interpreter.get_pc() + chip8::INSTRUCTION_SIZE;
-    mem_edit.DrawContents(const_cast<unsigned char *>(interpreter.get_mem().data()), chip8::MEM_SIZE);
+    ui->mem_edit.HighlightMin = interpreter->get_pc();
+    ui->mem_edit.HighlightMax = interpreter->get_pc() + chip8::INSTRUCTION_SIZE;
+    ui->mem_edit.DrawContents(const_cast<unsigned char *>(interpreter->get_mem().data()),
+                          interpreter->get_mem().size());
     ImGui::End();
 }
 
 void instance_manager::instance::instruction_log_window() {
-    if (!ImGui::Begin("Instruction Log")) {
+    ui->log_visible = ImGui::Begin("Instruction Log");
+    if (!ui->log_visible) {
         ImGui::End();
         return;
     }
-    for (const auto &instruction: instruction_log) {
-        ImGui::Text("%s", instruction.data());
+    const auto &log = ui->instruction_log;
+    std::array<char, 64> text{};
+    ImGuiListClipper clipper;
+    clipper.Begin(static_cast<int>(log.size()));
+    while (clipper.Step()) {
+        for (auto row = clipper.DisplayStart; row < clipper.DisplayEnd; ++row) {
+            const auto &op = log[(ui->log_start + static_cast<std::size_t>(row)) % log.size()];
+            const auto length = interpreter->describe(op, text);
+            ImGui::TextUnformatted(text.data(), text.data() + length);
+        }
     }
-    if (scroll_flag) {
+    if (ui->scroll_flag) {
         ImGui::SetScrollY(ImGui::GetScrollMaxY());
-        scroll_flag = false;
+        ui->scroll_flag = false;
     }
     ImGui::End();
 }
+
+void instance_manager::instance::release_view() { ui.reset(); }
+
+auto instance_manager::instance::resident_size() const -> std::size_t {
+    if (frozen) { return sizeof(hibernated) + frozen->blob.capacity(); }
+    return sizeof(chip8) + interpreter->get_mem().size();
+}
+
+void instance_manager::instance::touch(const std::chrono::time_point<std::chrono::steady_clock> now) {
+    last_active = now;
+}
+
+auto instance_manager::instance::hibernate(const std::chrono::time_point<std::chrono::steady_clock> now,
+                                           const std::chrono::nanoseconds idle) -> bool {
+    if (selected || state == state::RUNNING || state == state::TURBO) {
+        last_active = now;
+        return false;
+    }
+    // input left over from when it was stopped would keep it awake
+    if (!pending_input.empty() && interpreter) { apply_input(now); }
+    // recordings and captures hold on to the interpreter
+    if (frozen || recording || playback || video || !pending_input.empty() || now - last_active < idle) {
+        return false;
+    }
+    const auto saved = interpreter->save_state();
+    frozen = std::make_unique<hibernated>(hibernated{lz::compress(saved), saved.size()});
+    frozen->blob.shrink_to_fit();
+    interpreter.reset();
+    return true;
+}
+
+void instance_manager::instance::wake() {
+    if (!frozen) { return; }
+    auto replacement = std::make_unique<chip8>(alt_ops);
+    try {
+        replacement->load_state(lz::decompress(frozen->blob, frozen->size));
+    } catch (const std::invalid_argument &e) {
+        error = e.what();
+        modal = true;
+        replacement = std::make_unique<chip8>(alt_ops);
+        state = state::EMPTY;
+    }
+    interpreter = std::move(replacement);
+    interpreter->set_trace_id(static_cast<std::uint32_t>(id));
+    frozen.reset();
+}
@@ -1,6 +1,13 @@
 #pragma once
 
+#include "audio.hpp"
 #include "chip8.hpp"
+#include "movie.hpp"
+#include "quirk_bisect.hpp"
+#include "ram_search.hpp"
+#include "rom_library.hpp"
+#include "telemetry.hpp"
+#include "video.hpp"
 #include "imgui.h"
 #include "imgui_memory_editor.h"
 #include "ImGuiFileDialog.h"
@@ -8,26 +15,84 @@
 #include <GLFW/glfw3.h>
 
 #include <array>
+#include <atomic>
+#include <chrono>
 #include <cstddef>
-#include <deque>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <span>
 #include <string>
 #include <string_view>
+#include <thread>
 #include <vector>
 
 class instance_manager {
 public:
+    // draws the UI, call between ImGui::NewFrame and ImGui::Render
     void run();
 
+    // steps every running instance that is due and polls turbo runs, whether or not the UI is drawn
+    void emulate();
+
+    // when emulate next has work to do, nothing if no instance is running
+    [[nodiscard]] auto next_deadline() const -> std::optional<std::chrono::time_point<std::chrono::steady_clock>>;
+
+    // instances running or in turbo
+    [[nodiscard]] auto active_count() const -> std::size_t;
+
+    static void key_callback(GLFWwindow *window, int key, int scancode, int action, int mods);
+
 private:
+    struct key_event {
+        std::chrono::time_point<std::chrono::steady_clock> time;
+        std::uint8_t key;
+        bool down;
+    };
+
+    //@formatter:off
+    static constexpr std::array<int, chip8::KEY_COUNT> key_map {
+            GLFW_KEY_X,
+            GLFW_KEY_1,
+            GLFW_KEY_2,
+            GLFW_KEY_3,
+            GLFW_KEY_Q,
+            GLFW_KEY_W,
+            GLFW_KEY_E,
+            GLFW_KEY_A,
+            GLFW_KEY_S,
+            GLFW_KEY_D,
+            GLFW_KEY_Z,
+            GLFW_KEY_C,
+            GLFW_KEY_4,
+            GLFW_KEY_R,
+            GLFW_KEY_F,
+            GLFW_KEY_V
+    };
+    //@formatter:on
+
+    static inline std::vector<key_event> key_events;
+
     class instance {
     public:
         enum class state : unsigned char {
             EMPTY,
             LOADED,
-            RUNNING
+            RUNNING,
+            TURBO
+        };
+
+        static inline constexpr std::array<const char *, 4> state_strings = {"Empty", "Loaded", "Running", "Turbo"};
+
+        // how unselected instances share the time the selected one leaves, weighted rather than strict so low
+        // priority instances slow down under load instead of stopping
+        enum class priority : unsigned char {
+            high,
+            normal,
+            low
         };
 
-        static inline constexpr std::array<const char *, 3> state_strings = {"Empty", "Loaded", "Running"};
+        static inline constexpr std::array<const char *, 3> priority_strings = {"High", "Normal", "Low"};
 
         bool selected{};
 
@@ -39,15 +104,70 @@ private:
 
         [[nodiscard]] constexpr auto get_input_enabled() const -> bool { return input_enabled; }
 
+        [[nodiscard]] constexpr auto get_priority() const -> priority { return priority; }
+
         [[nodiscard]] constexpr auto get_alt_ops() const -> chip8::alt_t { return alt_ops; }
 
+        [[nodiscard]] constexpr auto get_rom_path() const -> const std::string & { return rom_path; }
+
+        [[nodiscard]] auto get_mem() const -> std::span<const std::uint8_t> { return interpreter->get_mem(); }
+
+        [[nodiscard]] auto next_deadline() const -> std::chrono::time_point<std::chrono::steady_clock>;
+
+        // how overdue it is, scaled by its priority; the scheduler serves the most urgent first
+        [[nodiscard]] auto urgency(std::chrono::time_point<std::chrono::steady_clock> now) const -> double;
+
+        // whether it has used its CPU limit within the current telemetry window
+        [[nodiscard]] auto over_budget(std::chrono::nanoseconds window) const -> bool;
+
+        // holds back a due batch, counted once per batch however many times it is passed over
+        void throttle();
+
+        // cycles per second the schedule asks for, 0 unless running
+        [[nodiscard]] auto target_ips() const -> double;
+
+        // cycles between timer ticks at its current speed, at least 1
+        [[nodiscard]] auto cycles_per_frame() const -> std::uint64_t;
+
+        // the latest rates and the cycles lost so far, all zero for an instance that never ran
+        [[nodiscard]] auto telemetry() const -> telemetry_row;
+
+        void sample_telemetry(std::chrono::duration<double> elapsed);
+
         void run();
 
+        void step();
+
         void reset();
 
         void load(std::string_view path);
 
-        void process_input();
+        void set_speed(unsigned short ips, unsigned char multiplier);
+
+        // the speed for tickrate cycles per 60 Hz frame, within the controller's ips_max and MULTIPLIER_MAX
+        void set_tickrate(unsigned tickrate, unsigned short ips_max);
+
+        void queue_input(const key_event &event);
+
+        void log_instruction();
+
+        void apply_input(std::chrono::time_point<std::chrono::steady_clock> time);
+
+        void start_turbo();
+
+        void stop_turbo();
+
+        void poll_turbo();
+
+        void start_recording();
+
+        void stop_recording(std::string_view path);
+
+        void start_playback(std::string_view path);
+
+        void start_video(std::string_view path);
+
+        void stop_video();
 
         void controller_window();
 
@@ -59,25 +179,117 @@ private:
 
         void instruction_log_window();
 
+        void release_view();
+
+        [[nodiscard]] constexpr auto get_hibernated() const -> bool { return frozen != nullptr; }
+
+        // bytes held for the interpreter, compressed or not
+        [[nodiscard]] auto resident_size() const -> std::size_t;
+
+        // keeps the instance awake for another idle period
+        void touch(std::chrono::time_point<std::chrono::steady_clock> now);
+
+        // compresses the interpreter away if nothing has used it for idle, true if it did
+        auto hibernate(std::chrono::time_point<std::chrono::steady_clock> now, std::chrono::nanoseconds idle) -> bool;
+
+        // restores the interpreter, a no-op unless hibernating
+        void wake();
+
     private:
-        chip8 interpreter;
-        GLuint tex_id{};
-        MemoryEditor mem_edit;
-        std::deque<std::string> instruction_log;
-        decltype(instruction_log)::size_type instruction_log_max{1000};
-        bool scroll_flag{};
+        struct turbo_run {
+            std::atomic<std::uint64_t> cycles{};
+            std::atomic<bool> done{};
+            const char *stop_reason{"Stopped"};
+            std::chrono::time_point<std::chrono::steady_clock> start_time{std::chrono::steady_clock::now()};
+            std::chrono::time_point<std::chrono::steady_clock> end_time{};
+            std::chrono::time_point<std::chrono::steady_clock> sample_time{start_time};
+            std::uint64_t sample_cycles{};
+            double mips{};
+            std::jthread worker;
+
+            void finish(const char *reason);
+        };
+
+        // only exists while the instance is selected, idle instances carry no GL or editor state
+        struct view {
+            GLuint tex_id{};
+            MemoryEditor mem_edit;
+            // the last INSTRUCTION_LOG_MAX instructions, oldest first from log_start. Reserved up front and described
+            // only for the rows on screen, so logging every cycle allocates nothing.
+            std::vector<chip8::executed> instruction_log;
+            std::size_t log_start{};
+            bool scroll_flag{};
+            // whether the log window was open and not collapsed when last drawn
+            bool log_visible{};
+
+            view();
+
+            void log(const chip8::executed &op);
+
+            void clear_log();
+
+            ~view();
+
+            view(const view &) = delete;
+
+            auto operator=(const view &) -> view & = delete;
+        };
+
+        static constexpr std::size_t INSTRUCTION_LOG_MAX{1000};
+        static constexpr std::chrono::nanoseconds TIMER_INTERVAL{16'666'667};
+        static constexpr unsigned char MULTIPLIER_MAX{50};
+
+        std::unique_ptr<chip8> interpreter;
+        std::string rom_path;
+        std::unique_ptr<view> ui;
+        std::vector<key_event> pending_input;
 
         std::size_t id;
         state state{};
         unsigned short ips{15};
         unsigned char multiplier{1};
         bool input_enabled{};
+        priority priority{priority::normal};
+        // percent of one core it may use while unselected, 0 for no limit
+        unsigned char cpu_limit{};
+        // cycles per frame the ROM's profile asks for, shown when the sliders cannot reach it
+        unsigned short tickrate{};
 
         //this is kind of ugly to be honest...
         std::chrono::time_point<std::chrono::steady_clock> last_timer_time{std::chrono::steady_clock::now()};
         std::chrono::time_point<std::chrono::steady_clock> last_cycle_time{std::chrono::steady_clock::now()};
 
         chip8::alt_t alt_ops;
+        bool audio_enabled{};
+        std::uint16_t breakpoint_addr{chip8::ROM_ADDR};
+
+        std::shared_ptr<audio_voice> voice;
+
+        std::unique_ptr<turbo_run> turbo;
+        std::uint64_t turbo_cycle_limit{};
+        std::vector<std::uint16_t> breakpoints;
+
+        std::unique_ptr<movie> recording;
+        std::unique_ptr<movie> playback;
+        std::uint64_t movie_cycle{};
+
+        std::shared_ptr<video_recorder> video;
+
+        // created on the first run
+        std::unique_ptr<instance_telemetry> stats;
+
+        // the interpreter's save state while hibernating, when interpreter is null
+        struct hibernated {
+            std::vector<std::uint8_t> blob;
+            std::size_t size;
+        };
+
+        std::unique_ptr<hibernated> frozen;
+        std::chrono::time_point<std::chrono::steady_clock> last_active{std::chrono::steady_clock::now()};
+
+        void replace_interpreter(std::unique_ptr<chip8> replacement);
+
+        [[nodiscard]] auto cycle_interval() const -> std::chrono::nanoseconds;
 
         struct {
             bool show_controller{true};
@@ -86,34 +298,84 @@ private:
             bool show_mem_view{true};
             bool show_op_log{true};
         } windows;
-
-        //@formatter:off
-        std::array<ImGuiKey, 16> input {
-                ImGuiKey_X,
-                ImGuiKey_1,
-                ImGuiKey_2,
-                ImGuiKey_3,
-                ImGuiKey_Q,
-                ImGuiKey_W,
-                ImGuiKey_E,
-                ImGuiKey_A,
-                ImGuiKey_S,
-                ImGuiKey_D,
-                ImGuiKey_Z,
-                ImGuiKey_C,
-                ImGuiKey_4,
-                ImGuiKey_R,
-                ImGuiKey_F,
-                ImGuiKey_V
-        };
-        //@formatter:on
     };
 
+    static constexpr std::chrono::seconds SAMPLE_INTERVAL{1};
+    // how long a stopped, unselected instance keeps its interpreter before hibernating
+    static constexpr std::chrono::seconds HIBERNATE_AFTER{10};
+    static constexpr std::size_t FRAME_HISTORY{240};
+    // longest emulate spends on unselected instances before holding the rest back, so a busy loop still gets back to
+    // the selected instance and the UI in time
+    static constexpr std::chrono::milliseconds BACKGROUND_SLICE{4};
+
     std::vector<instance> instances{};
     ssize_t selected_id{-1};
+    // due unselected instances, kept to avoid reallocating every loop
+    std::vector<std::size_t> run_order;
+
+    std::chrono::time_point<std::chrono::steady_clock> last_sample_time{std::chrono::steady_clock::now()};
+    std::vector<telemetry_row> telemetry_rows;
+    telemetry_row telemetry_totals{};
+    // milliseconds between UI frames, oldest first from frame_offset
+    std::array<float, FRAME_HISTORY> frame_times{};
+    std::size_t frame_offset{};
+    std::unique_ptr<telemetry_writer> telemetry_export;
+    int export_interval{1};
+    std::uint64_t export_countdown{};
+
+    rom_library library{"roms"};
+    // indices into the library entries matching library_filter
+    std::vector<std::size_t> library_view;
+    std::array<char, 64> library_filter{};
+    std::optional<std::size_t> library_selected;
+
+    // the selected instance first, then any others running the same ROM
+    ram_search search;
+    std::vector<std::size_t> search_ids;
+    std::vector<std::span<const std::uint8_t>> search_mems;
+    ram_search::condition search_condition{ram_search::condition::changed};
+    std::uint8_t search_value{};
+    bool search_same_rom{};
+    bool search_every_frame{};
+
+    // the last quirk bisect, run on its own thread and shown until the next one starts
+    struct bisect_run {
+        std::size_t id{};
+        std::string rom_path;
+        std::atomic<bool> done{};
+        bool cancelled{};
+        quirk_bisect::report report;
+        std::string error;
+        // last, so it stops before the members it fills are destroyed
+        std::jthread worker;
+    };
+
+    std::unique_ptr<bisect_run> bisect;
+    int bisect_frames{3600};
 
     void instance_manager_window();
 
+    void telemetry_section();
+
+    void sample_telemetry();
+
+    void rom_library_section();
+
+    void filter_library();
+
+    void ram_search_window();
+
+    void start_search();
+
+    void quirk_bisect_window();
+
+    // bisects the selected instance's ROM against its quirks
+    void start_bisect();
+
+    // memories of the searched instances, empty once one of them is deleted or changes memory size. Valid until the
+    // next call, which reuses the buffer since the window asks every frame.
+    [[nodiscard]] auto search_memories() -> std::span<const std::span<const std::uint8_t>>;
+
     [[nodiscard]] auto instance_search() const -> std::size_t;
 
     [[nodiscard]] auto selected_search() const -> ssize_t;
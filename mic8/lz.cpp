@@ -0,0 +1,119 @@
+#include "lz.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <stdexcept>
+
+// a block is a run of sequences: a token with 4 bits each of literal count and match length - MIN_MATCH, either of
+// which continues in extra bytes of 255 when it reaches 15, then the literals, then a 16 bit little endian offset.
+// The last sequence has literals only.
+namespace {
+    constexpr std::size_t MIN_MATCH{4};
+    constexpr std::size_t MAX_OFFSET{0xFFFF};
+    constexpr unsigned HASH_BITS{12};
+
+    auto read32(const std::uint8_t *bytes) -> std::uint32_t {
+        std::uint32_t value;
+        std::memcpy(&value, bytes, sizeof(value));
+        return value;
+    }
+
+    void put_length(std::vector<std::uint8_t> &out, std::size_t length) {
+        while (length >= 255) {
+            out.push_back(255);
+            length -= 255;
+        }
+        out.push_back(static_cast<std::uint8_t>(length));
+    }
+
+    void put_sequence(std::vector<std::uint8_t> &out, const std::span<const std::uint8_t> literals,
+                      const std::size_t offset, const std::size_t match) {
+        const auto literal_nibble = std::min<std::size_t>(literals.size(), 15);
+        const auto match_nibble = match == 0 ? 0 : std::min<std::size_t>(match - MIN_MATCH, 15);
+        out.push_back(static_cast<std::uint8_t>(literal_nibble << 4u | match_nibble));
+        if (literal_nibble == 15) { put_length(out, literals.size() - 15); }
+        out.insert(out.end(), literals.begin(), literals.end());
+        if (match == 0) { return; }
+        out.push_back(static_cast<std::uint8_t>(offset));
+        out.push_back(static_cast<std::uint8_t>(offset >> 8u));
+        if (match_nibble == 15) { put_length(out, match - MIN_MATCH - 15); }
+    }
+
+    [[noreturn]] void corrupt() { throw std::invalid_argument("Corrupt compressed block!"); }
+}
+
+auto lz::compress(const std::span<const std::uint8_t> src) -> std::vector<std::uint8_t> {
+    std::vector<std::uint8_t> out;
+    out.reserve(src.size() / 16 + 16);
+    // position + 1 of the last sequence hashed to each slot, 0 if none
+    std::array<std::uint32_t, 1u << HASH_BITS> table{};
+    std::size_t anchor = 0;
+    std::size_t pos = 0;
+    while (pos + MIN_MATCH <= src.size()) {
+        const auto sequence = read32(src.data() + pos);
+        const auto slot = sequence * 2654435761u >> (32 - HASH_BITS);
+        const std::size_t candidate = table[slot];
+        table[slot] = static_cast<std::uint32_t>(pos + 1);
+        if (candidate == 0 || pos - (candidate - 1) > MAX_OFFSET || read32(src.data() + candidate - 1) != sequence) {
+            ++pos;
+            continue;
+        }
+        const auto start = candidate - 1;
+        auto match = MIN_MATCH;
+        while (pos + match + 8 <= src.size() && std::memcmp(&src[start + match], &src[pos + match], 8) == 0) {
+            match += 8;
+        }
+        while (pos + match < src.size() && src[start + match] == src[pos + match]) { ++match; }
+        put_sequence(out, src.subspan(anchor, pos - anchor), pos - start, match);
+        pos += match;
+        anchor = pos;
+    }
+    put_sequence(out, src.subspan(anchor), 0, 0);
+    return out;
+}
+
+auto lz::decompress(const std::span<const std::uint8_t> src, const std::size_t size) -> std::vector<std::uint8_t> {
+    std::vector<std::uint8_t> out(size);
+    std::size_t in = 0;
+    std::size_t pos = 0;
+    const auto length = [&](std::size_t value) {
+        if (value != 15) { return value; }
+        std::uint8_t byte;
+        do {
+            if (in >= src.size()) { corrupt(); }
+            byte = src[in++];
+            value += byte;
+        } while (byte == 255);
+        return value;
+    };
+    while (true) {
+        if (in >= src.size()) { corrupt(); }
+        const auto token = src[in++];
+        const auto literals = length(token >> 4u);
+        if (literals > src.size() - in || literals > size - pos) { corrupt(); }
+        std::ranges::copy(src.subspan(in, literals), out.begin() + static_cast<std::ptrdiff_t>(pos));
+        in += literals;
+        pos += literals;
+        if (in == src.size()) { break; }
+        if (in + 2 > src.size()) { corrupt(); }
+        const std::size_t offset = src[in] | src[in + 1] << 8u;
+        in += 2;
+        const auto match = length(token & 0xFu) + MIN_MATCH;
+        if (offset == 0 || offset > pos || match > size - pos) { corrupt(); }
+        // a match may overlap what it is copying, so it goes in pieces no longer than the offset
+        if (offset == 1) {
+            std::memset(out.data() + pos, out[pos - 1], match);
+            pos += match;
+            continue;
+        }
+        for (auto left = match; left > 0;) {
+            const auto piece = std::min(left, offset);
+            std::memcpy(out.data() + pos, out.data() + pos - offset, piece);
+            pos += piece;
+            left -= piece;
+        }
+    }
+    if (pos != size) { corrupt(); }
+    return out;
+}
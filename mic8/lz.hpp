@@ -0,0 +1,15 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// LZ77 in the style of an LZ4 block: greedy matches found through a small hash table, no entropy coding. Built for
+// interpreter state, which is mostly zeroes and compresses to a few percent in microseconds.
+namespace lz {
+    auto compress(std::span<const std::uint8_t> src) -> std::vector<std::uint8_t>;
+
+    // size is the length of the original data, throws if src is not a block of exactly that length
+    auto decompress(std::span<const std::uint8_t> src, std::size_t size) -> std::vector<std::uint8_t>;
+}
@@ -16,7 +16,20 @@
 
 #include "instance_manager.hpp"
 
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+
 namespace {
+    // the UI redraws at most this often while instances run, and less often once many of them do
+    constexpr std::chrono::nanoseconds REDRAW_INTERVAL{16'666'667};
+    constexpr std::chrono::nanoseconds BUSY_REDRAW_INTERVAL{50'000'000};
+    constexpr std::size_t BUSY_INSTANCES{4};
+    // with nothing running the loop sleeps until input, waking this often (in seconds) to refresh anyway
+    constexpr double IDLE_TIMEOUT{0.5};
+    // ImGui takes a few frames to settle after input
+    constexpr int SETTLE_FRAMES{3};
+
     void glfw_error_callback(const int error_code, const char *description) {
         fprintf(stderr, "GLFW Error %d: %s\n", error_code, description);
     }
@@ -48,7 +61,8 @@ auto main() -> int {
     GLFWwindow *window = glfwCreateWindow(1280, 720, "MIC8 Interpreter", nullptr, nullptr);
     if (window == nullptr) { return 1; }
     glfwMakeContextCurrent(window);
-    glfwSwapInterval(1);
+    // redraws are paced by the main loop, waiting on vsync would hold up instances due in between
+    glfwSwapInterval(0);
 
     IMGUI_CHECKVERSION();
     ImGui::CreateContext();
@@ -59,6 +73,8 @@ auto main() -> int {
 
     ImGui::StyleColorsDark();
 
+    // installed before the backend so ImGui chains to it
+    glfwSetKeyCallback(window, instance_manager::key_callback);
     ImGui_ImplGlfw_InitForOpenGL(window, true);
 #ifdef __EMSCRIPTEN__
     ImGui_ImplGlfw_InstallEmscriptenCanvasResizeCallback("#canvas");
@@ -69,33 +85,67 @@ auto main() -> int {
 
     instance_manager manager;
 
+    using clock = std::chrono::steady_clock;
+    auto next_redraw = clock::now();
+    int settle_frames{};
+
 #ifdef __EMSCRIPTEN__
     EMSCRIPTEN_MAINLOOP_BEGIN
 #else
     while (glfwWindowShouldClose(window) == 0)
 #endif
     {
+        const bool hidden = glfwGetWindowAttrib(window, GLFW_ICONIFIED) != 0 ||
+                            glfwGetWindowAttrib(window, GLFW_VISIBLE) == 0;
+#ifdef __EMSCRIPTEN__
+        // the browser paces the loop
         glfwPollEvents();
+        const bool redraw = true;
+#else
+        // sleep until an instance is due, the UI needs redrawing or an event arrives
+        auto wake = manager.next_deadline();
+        if (!hidden && (settle_frames > 0 || manager.active_count() > 0)) {
+            wake = wake ? std::min(*wake, next_redraw) : next_redraw;
+        }
+        const auto before = clock::now();
+        const auto timeout = wake ? std::chrono::duration<double>(*wake - before).count() : IDLE_TIMEOUT;
+        if (timeout > 0) {
+            glfwWaitEventsTimeout(timeout);
+        } else {
+            glfwPollEvents();
+        }
+        const auto now = clock::now();
+        if (timeout > 0 && now - before < std::chrono::duration<double>(timeout)) { settle_frames = SETTLE_FRAMES; }
+        const bool redraw = !hidden && (settle_frames > 0 || now >= next_redraw);
+#endif
+
+        manager.emulate();
+
+        if (redraw) {
+            ImGui_ImplOpenGL3_NewFrame();
+            ImGui_ImplGlfw_NewFrame();
+            ImGui::NewFrame();
 
-        ImGui_ImplOpenGL3_NewFrame();
-        ImGui_ImplGlfw_NewFrame();
-        ImGui::NewFrame();
+            ImGui::DockSpaceOverViewport();
 
-        ImGui::DockSpaceOverViewport();
+            manager.run();
 
-        manager.run();
+            ImGui::Render();
+            int display_w{};
+            int display_h{};
+            glfwGetFramebufferSize(window, &display_w, &display_h);
+            glViewport(0, 0, display_w, display_h);
+            glClearColor(clear_color.x * clear_color.w, clear_color.y * clear_color.w,
+                         clear_color.z * clear_color.w, clear_color.w);
+            glClear(GL_COLOR_BUFFER_BIT);
+            ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
 
-        ImGui::Render();
-        int display_w{};
-        int display_h{};
-        glfwGetFramebufferSize(window, &display_w, &display_h);
-        glViewport(0, 0, display_w, display_h);
-        glClearColor(clear_color.x * clear_color.w, clear_color.y * clear_color.w, clear_color.z * clear_color.w,
-                     clear_color.w);
-        glClear(GL_COLOR_BUFFER_BIT);
-        ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+            glfwSwapBuffers(window);
 
-        glfwSwapBuffers(window);
+            if (settle_frames > 0) { --settle_frames; }
+            next_redraw = clock::now() + (manager.active_count() > BUSY_INSTANCES ? BUSY_REDRAW_INTERVAL
+                                                                                   : REDRAW_INTERVAL);
+        }
     }
 #ifdef __EMSCRIPTEN__
     EMSCRIPTEN_MAINLOOP_END;
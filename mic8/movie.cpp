@@ -0,0 +1,170 @@
+#include "movie.hpp"
+#include "chip8.hpp"
+#include "hash.hpp"
+
+#include <algorithm>
+#include <array>
+#include <fstream>
+#include <ios>
+#include <iterator>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+    constexpr std::array<char, 8> magic{'M', 'I', 'C', '8', 'M', 'O', 'V', 1};
+    constexpr std::size_t max_rom_path = 0x1000;
+
+    // LEB128, so event deltas and most counts take a single byte
+    void write_varint(std::ofstream &file, std::uint64_t value) {
+        while (value >= 0x80) {
+            file.put(static_cast<char>((value & 0x7F) | 0x80));
+            value >>= 7u;
+        }
+        file.put(static_cast<char>(value));
+    }
+
+    auto read_varint(std::ifstream &file) -> std::uint64_t {
+        std::uint64_t value = 0;
+        for (unsigned shift = 0; shift < 64; shift += 7) {
+            const auto byte = file.get();
+            if (byte == std::ifstream::traits_type::eof()) { throw std::invalid_argument("Truncated movie file!"); }
+            value |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+            if ((byte & 0x80) == 0) { return value; }
+        }
+        throw std::invalid_argument("Corrupt movie file!");
+    }
+
+    auto read_byte(std::ifstream &file) -> std::uint8_t {
+        const auto byte = file.get();
+        if (byte == std::ifstream::traits_type::eof()) { throw std::invalid_argument("Truncated movie file!"); }
+        return static_cast<std::uint8_t>(byte);
+    }
+}
+
+movie::movie(const std::string_view rom, const std::minstd_rand::result_type seed, const chip8::alt_t alt_ops)
+    : rom(rom), rom_hash(hash_rom(rom)), seed(seed), alt_ops(alt_ops) {}
+
+// magic, seed, quirk bits, l/s mode, variant, ROM hash and path, length, then (cycle delta, key | down << 4) pairs
+void movie::save(const std::string_view path) const {
+    std::ofstream file(path.data(), std::ios::binary);
+    if (!file) {
+        throw std::invalid_argument("Failed to open the movie file!");
+    }
+    file.write(magic.data(), magic.size());
+    write_varint(file, seed);
+    file.put(static_cast<char>(alt_ops.vip_alu | alt_ops.chip48_jmp << 1u | alt_ops.chip48_shf << 2u));
+    file.put(static_cast<char>(alt_ops.ls_mode));
+    file.put(static_cast<char>(alt_ops.variant));
+    write_varint(file, rom_hash);
+    write_varint(file, rom.size());
+    file.write(rom.data(), static_cast<std::streamsize>(rom.size()));
+    write_varint(file, length);
+    write_varint(file, events.size());
+    std::uint64_t last = 0;
+    for (const auto &e: events) {
+        write_varint(file, e.cycle - last);
+        file.put(static_cast<char>(e.key == TIMER_TICK ? TIMER_TICK : e.key | e.down << 4u));
+        last = e.cycle;
+    }
+}
+
+auto movie::load(const std::string_view path) -> movie {
+    std::ifstream file(path.data(), std::ios::binary);
+    if (!file) {
+        throw std::invalid_argument("Failed to open the movie file!");
+    }
+    std::array<char, magic.size()> header{};
+    file.read(header.data(), header.size());
+    if (!file || header != magic) {
+        throw std::invalid_argument("Not a movie file!");
+    }
+    movie m;
+    m.seed = static_cast<std::minstd_rand::result_type>(read_varint(file));
+    const auto quirks = read_byte(file);
+    m.alt_ops.vip_alu = (quirks & 1u) != 0;
+    m.alt_ops.chip48_jmp = (quirks & 2u) != 0;
+    m.alt_ops.chip48_shf = (quirks & 4u) != 0;
+    const auto ls = read_byte(file);
+    const auto var = read_byte(file);
+    if (ls > static_cast<std::uint8_t>(chip8::ls_mode::schip11_ls) ||
+        var > static_cast<std::uint8_t>(chip8::variant::xochip)) {
+        throw std::invalid_argument("Corrupt movie file!");
+    }
+    m.alt_ops.ls_mode = static_cast<chip8::ls_mode>(ls);
+    m.alt_ops.variant = static_cast<chip8::variant>(var);
+    m.rom_hash = read_varint(file);
+    const auto rom_size = read_varint(file);
+    if (rom_size > max_rom_path) { throw std::invalid_argument("Corrupt movie file!"); }
+    m.rom.resize(rom_size);
+    file.read(m.rom.data(), static_cast<std::streamsize>(rom_size));
+    m.length = read_varint(file);
+    const auto count = read_varint(file);
+    std::uint64_t cycle = 0;
+    for (std::uint64_t i = 0; i < count; ++i) {
+        cycle += read_varint(file);
+        const auto code = read_byte(file);
+        if (code == TIMER_TICK) {
+            m.events.push_back({cycle, TIMER_TICK, false});
+        } else {
+            m.events.push_back({cycle, static_cast<std::uint8_t>(code & 0xFu), (code & 0x10u) != 0});
+        }
+    }
+    return m;
+}
+
+auto movie::hash_rom(const std::string_view path) -> std::uint64_t {
+    std::ifstream file(path.data(), std::ios::binary);
+    if (!file) {
+        throw std::invalid_argument("Failed to open the file!");
+    }
+    const std::vector<char> bytes{std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+    return hash::fnv1a(std::as_bytes(std::span(bytes)));
+}
+
+auto movie::make_interpreter() const -> std::unique_ptr<chip8> {
+    if (hash_rom(rom) != rom_hash) {
+        throw std::invalid_argument("The ROM has changed since the movie was recorded!");
+    }
+    auto interpreter = std::make_unique<chip8>(alt_ops);
+    interpreter->seed(seed);
+    interpreter->load_rom(rom);
+    return interpreter;
+}
+
+void movie::record_key(const std::uint64_t cycle, const std::uint8_t key, const bool down) {
+    events.push_back({cycle, key, down});
+    length = std::max(length, cycle);
+}
+
+void movie::record_tick(const std::uint64_t cycle) {
+    events.push_back({cycle, TIMER_TICK, false});
+    length = std::max(length, cycle);
+}
+
+auto movie_player::play(chip8 &interpreter, const std::uint64_t budget) -> chip8::run_result {
+    std::uint64_t executed = 0;
+    while (!finished) {
+        for (; next < recording.events.size() && recording.events[next].cycle <= cycle; ++next) {
+            const auto &e = recording.events[next];
+            if (e.key == movie::TIMER_TICK) {
+                interpreter.decrement_timers();
+                if (on_tick) { on_tick(interpreter); }
+            } else {
+                interpreter.keys[e.key] = e.down;
+            }
+        }
+        if (cycle >= recording.length) {
+            finished = true;
+            break;
+        }
+        if (executed == budget) { break; }
+        auto limit = recording.length;
+        if (next < recording.events.size()) { limit = std::min(limit, recording.events[next].cycle); }
+        const auto [reason, cycles] = interpreter.run_cycles(std::min(limit - cycle, budget - executed));
+        cycle += cycles;
+        executed += cycles;
+        if (reason == chip8::stop_reason::halted) { return {reason, executed}; }
+    }
+    return {chip8::stop_reason::budget, executed};
+}
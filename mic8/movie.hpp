@@ -0,0 +1,75 @@
+#pragma once
+
+#include "chip8.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <random>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// A recorded session: everything needed to rebuild the interpreter, plus every input change and timer tick keyed
+// by the number of cycles executed before it. Replaying it reproduces the session exactly, at any speed.
+class movie {
+public:
+    static constexpr std::uint8_t TIMER_TICK{0xFF};
+
+    struct event {
+        std::uint64_t cycle;
+        // a key index, or TIMER_TICK
+        std::uint8_t key;
+        bool down;
+    };
+
+    std::string rom;
+    std::uint64_t rom_hash{};
+    std::minstd_rand::result_type seed{};
+    chip8::alt_t alt_ops;
+    std::vector<event> events;
+    std::uint64_t length{};
+
+    movie() = default;
+
+    // starts a recording of rom from power on
+    movie(std::string_view rom, std::minstd_rand::result_type seed, chip8::alt_t alt_ops);
+
+    static auto load(std::string_view path) -> movie;
+
+    void save(std::string_view path) const;
+
+    static auto hash_rom(std::string_view path) -> std::uint64_t;
+
+    // the interpreter as it was when the recording started, throws if the ROM on disk no longer matches
+    [[nodiscard]] auto make_interpreter() const -> std::unique_ptr<chip8>;
+
+    void record_key(std::uint64_t cycle, std::uint8_t key, bool down);
+
+    void record_tick(std::uint64_t cycle);
+};
+
+class movie_player {
+public:
+    // on_tick runs after each recorded timer tick, for anything that samples at 60 Hz
+    explicit movie_player(const movie &recording, std::function<void(const chip8 &)> on_tick = {}) :
+        recording(recording), on_tick(std::move(on_tick)) {}
+
+    // runs at most budget cycles, stopping early at the end of the movie or when the ROM halts. A halted ROM was
+    // still stepped while recording, so playback carries on until done(). Events recorded after the last cycle
+    // are applied too, so the final state matches the recording's.
+    auto play(chip8 &interpreter, std::uint64_t budget) -> chip8::run_result;
+
+    [[nodiscard]] constexpr auto get_cycle() const -> std::uint64_t { return cycle; }
+
+    [[nodiscard]] constexpr auto done() const -> bool { return finished; }
+
+private:
+    const movie &recording;
+    std::function<void(const chip8 &)> on_tick;
+    std::size_t next{};
+    std::uint64_t cycle{};
+    bool finished{};
+};
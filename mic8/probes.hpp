@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstdint>
+#include <type_traits>
+
+// USDT probes in the note format of systemtap's sys/sdt.h, so perf, bpftrace and bcc find them without that header
+// being installed. Each probe compiles to one nop plus an ELF note naming it and saying where its arguments live.
+// A tracer patches the nop when it attaches, until then a probe costs the nop and moving its arguments into place.
+// Every argument is passed as an unsigned 64 bit value, pointers included. List them with
+//   readelf -n mic8.elf | grep -A4 stapsdt
+// and attach with, for example,
+//   bpftrace -e 'usdt:./mic8.elf:mic8:batch_end { @cycles[arg0] = sum(arg2); }'
+// Defining MIC8_NO_PROBES compiles them out entirely.
+namespace probes {
+    template<typename T>
+    auto arg(const T value) -> std::uint64_t {
+        if constexpr (std::is_pointer_v<T>) {
+            return reinterpret_cast<std::uintptr_t>(value); // NOLINT(*-pro-type-reinterpret-cast)
+        } else {
+            return static_cast<std::uint64_t>(value);
+        }
+    }
+}
+
+#if defined(__linux__) && (defined(__x86_64__) || defined(__aarch64__)) && !defined(MIC8_NO_PROBES)
+
+//@formatter:off
+#define MIC8_PROBE_NOTE(name, args)                                                     \
+    "990: nop\n"                                                                        \
+    ".pushsection .note.stapsdt, \"?\", \"note\"\n"                                     \
+    ".balign 4\n"                                                                       \
+    ".4byte 992f-991f, 994f-993f, 3\n"                                                  \
+    "991: .asciz \"stapsdt\"\n"                                                         \
+    "992: .balign 4\n"                                                                  \
+    "993: .8byte 990b\n"                                                                \
+    ".8byte _.stapsdt.base\n"                                                           \
+    ".8byte 0\n"                                                                        \
+    ".asciz \"mic8\"\n"                                                                 \
+    ".asciz \"" #name "\"\n"                                                            \
+    ".asciz \"" args "\"\n"                                                             \
+    "994: .balign 4\n"                                                                  \
+    ".popsection\n"                                                                     \
+    ".ifndef _.stapsdt.base\n"                                                          \
+    ".pushsection .stapsdt.base, \"aG\", \"progbits\", .stapsdt.base, comdat\n"         \
+    ".weak _.stapsdt.base\n"                                                            \
+    ".hidden _.stapsdt.base\n"                                                          \
+    "_.stapsdt.base: .space 1\n"                                                        \
+    ".size _.stapsdt.base, 1\n"                                                         \
+    ".popsection\n"                                                                     \
+    ".endif\n"
+
+#define MIC8_PROBE2(name, v0, v1)                                                       \
+    __asm__ __volatile__(MIC8_PROBE_NOTE(name, "8@%[a0] 8@%[a1]")                       \
+                         :: [a0] "nor"(probes::arg(v0)), [a1] "nor"(probes::arg(v1)))
+
+#define MIC8_PROBE3(name, v0, v1, v2)                                                   \
+    __asm__ __volatile__(MIC8_PROBE_NOTE(name, "8@%[a0] 8@%[a1] 8@%[a2]")               \
+                         :: [a0] "nor"(probes::arg(v0)), [a1] "nor"(probes::arg(v1)),   \
+                            [a2] "nor"(probes::arg(v2)))
+
+#define MIC8_PROBE4(name, v0, v1, v2, v3)                                               \
+    __asm__ __volatile__(MIC8_PROBE_NOTE(name, "8@%[a0] 8@%[a1] 8@%[a2] 8@%[a3]")       \
+                         :: [a0] "nor"(probes::arg(v0)), [a1] "nor"(probes::arg(v1)),   \
+                            [a2] "nor"(probes::arg(v2)), [a3] "nor"(probes::arg(v3)))
+//@formatter:on
+
+#else
+
+#define MIC8_PROBE2(name, v0, v1) static_cast<void>(0)
+#define MIC8_PROBE3(name, v0, v1, v2) static_cast<void>(0)
+#define MIC8_PROBE4(name, v0, v1, v2, v3) static_cast<void>(0)
+
+#endif
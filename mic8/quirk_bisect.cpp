@@ -0,0 +1,191 @@
+#include "quirk_bisect.hpp"
+#include "hash.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <format>
+
+namespace {
+    // one combination, advanced the way headless::run advances an interpreter so the runs agree on when inputs
+    // arrive and timers tick
+    class lane {
+    public:
+        lane(const std::string &rom, const chip8::alt_t &alt_ops, const quirk_bisect::options &opts,
+             const std::vector<headless::input_event> &events)
+            : interpreter(alt_ops), events(events), cycles_per_frame(std::max<std::uint64_t>(1, opts.cycles_per_frame)) {
+            interpreter.seed(opts.seed);
+            interpreter.load_rom(rom);
+        }
+
+        void run_to(const std::uint64_t until) {
+            while (cycle < until && !halted) {
+                for (; event < events.size() && events[event].cycle <= cycle; ++event) {
+                    interpreter.keys[events[event].key] = events[event].down;
+                }
+                const auto next_tick = (cycle / cycles_per_frame + 1) * cycles_per_frame;
+                auto budget = std::min(next_tick, until) - cycle;
+                if (event < events.size()) { budget = std::min(budget, events[event].cycle - cycle); }
+                const auto [reason, executed] = interpreter.run_cycles(budget);
+                cycle += executed;
+                if (cycle % cycles_per_frame == 0) { interpreter.decrement_timers(); }
+                halted = reason == chip8::stop_reason::halted;
+            }
+        }
+
+        // everything a quirk changes directly, cheap enough to take every frame. Memory is left out, a store that
+        // differs shows up in the index register or the registers stored first.
+        [[nodiscard]] auto state_hash() const -> std::uint64_t {
+            auto value = hash::fnv1a(std::as_bytes(interpreter.get_reg()));
+            value = hash::fnv1a(std::as_bytes(interpreter.get_stack()), value);
+            value = hash::fnv1a_of(interpreter.get_pc(), value);
+            value = hash::fnv1a_of(interpreter.get_ir(), value);
+            value = hash::fnv1a_of(interpreter.get_sp(), value);
+            value = hash::fnv1a_of(interpreter.get_dt(), value);
+            value = hash::fnv1a_of(interpreter.get_st(), value);
+            value = hash::fnv1a_of(cycle, value);
+            value = hash::fnv1a_of(halted, value);
+            // a word at a time, the screen is most of the state
+            for (const auto &plane: interpreter.get_fb()) {
+                for (const auto word: plane) { value = (value ^ word) * hash::FNV_PRIME; }
+            }
+            return value;
+        }
+
+        [[nodiscard]] auto opcode() const -> std::uint16_t {
+            const auto mem = interpreter.get_mem();
+            const auto pc = interpreter.get_pc();
+            return static_cast<std::uint16_t>(mem[pc & (mem.size() - 1)] << 8u | mem[(pc + 1u) & (mem.size() - 1)]);
+        }
+
+        chip8 interpreter;
+
+    private:
+        const std::vector<headless::input_event> &events;
+        std::uint64_t cycles_per_frame;
+        std::size_t event{};
+        std::uint64_t cycle{};
+        bool halted{};
+    };
+
+    // the combo that differs from reference only in quirk, taking that quirk's setting from combo
+    auto neighbour(const std::size_t reference, const std::size_t combo, const quirk_bisect::quirk quirk)
+        -> std::size_t {
+        if (quirk == quirk_bisect::quirk::ls_mode) { return combo / 8 * 8 + reference % 8; }
+        const auto bit = 1u << static_cast<unsigned>(quirk);
+        return (reference & ~std::size_t{bit}) | (combo & bit);
+    }
+}
+
+auto quirk_bisect::combo_of(const chip8::alt_t &alt_ops) -> std::size_t { return pack_alt_ops(alt_ops) & 0x1Fu; }
+
+auto quirk_bisect::differences(const std::size_t a, const std::size_t b) -> unsigned {
+    return static_cast<unsigned>((a ^ b) & 7u) | (a / 8 != b / 8 ? 8u : 0u);
+}
+
+auto quirk_bisect::describe(const std::size_t combo) -> std::string {
+    std::string text;
+    for (unsigned q = 0; q < 3; ++q) {
+        if ((combo >> q & 1u) != 0) { text += std::format("{} ", quirk_strings[q]); }
+    }
+    return text + ls_mode_strings[combo / 8];
+}
+
+auto quirk_bisect::run(const std::string &rom, const chip8::alt_t &reference, const options &opts,
+                       const std::vector<headless::input_event> &events, const std::stop_token stop) -> report {
+    const auto start = std::chrono::steady_clock::now();
+    const auto cycles_per_frame = std::max<std::uint64_t>(1, opts.cycles_per_frame);
+    const auto frame_end = [&](const std::uint64_t frame) {
+        return std::min((frame + 1) * cycles_per_frame, opts.cycles);
+    };
+    report rep{combo_of(reference), reference.variant};
+
+    // the reference's rolling hash at the end of each frame, which every other combination is held to
+    std::vector<std::uint64_t> trail;
+    {
+        lane ref(rom, reference, opts, events);
+        std::uint64_t rolling = hash::FNV_OFFSET;
+        for (std::uint64_t frame = 0; frame * cycles_per_frame < opts.cycles && !stop.stop_requested(); ++frame) {
+            ref.run_to(frame_end(frame));
+            rolling = hash::fnv1a_of(ref.state_hash(), rolling);
+            trail.push_back(rolling);
+        }
+    }
+
+    rep.outcomes.resize(headless::QUIRK_COMBOS);
+    for (std::size_t combo = 0; combo < rep.outcomes.size(); ++combo) { rep.outcomes[combo].combo = combo; }
+
+    // whether combo agrees with the reference before cycle and not after it
+    const auto diverges_at = [&](const std::size_t combo, const std::uint64_t cycle) {
+        lane a(rom, reference, opts, events);
+        lane b(rom, headless::make_alt_ops(combo, reference.variant), opts, events);
+        a.run_to(cycle - 1);
+        b.run_to(cycle - 1);
+        if (a.state_hash() != b.state_hash()) { return false; }
+        a.run_to(cycle);
+        b.run_to(cycle);
+        return a.state_hash() != b.state_hash();
+    };
+
+    const auto compare = [&](outcome &out) {
+        const auto alt_ops = headless::make_alt_ops(out.combo, reference.variant);
+        lane other(rom, alt_ops, opts, events);
+        std::uint64_t rolling = hash::FNV_OFFSET;
+        std::uint64_t frame = 0;
+        for (; frame < trail.size(); ++frame) {
+            if (stop.stop_requested()) { return; }
+            other.run_to(frame_end(frame));
+            rolling = hash::fnv1a_of(other.state_hash(), rolling);
+            if (rolling != trail[frame]) { break; }
+        }
+        if (frame == trail.size()) { return; }
+
+        // both agreed at the start of this frame, so step them side by side through it
+        lane a(rom, reference, opts, events);
+        lane b(rom, alt_ops, opts, events);
+        a.run_to(frame * cycles_per_frame);
+        b.run_to(frame * cycles_per_frame);
+        out.diverged = true;
+        out.frame = frame;
+        out.cycle = frame_end(frame);
+        for (auto cycle = frame * cycles_per_frame; cycle < frame_end(frame); ++cycle) {
+            const auto pc = a.interpreter.get_pc();
+            const auto opcode = a.opcode();
+            a.run_to(cycle + 1);
+            b.run_to(cycle + 1);
+            if (a.state_hash() != b.state_hash()) {
+                out.cycle = cycle + 1;
+                out.pc = pc;
+                out.opcode = opcode;
+                out.instruction = a.interpreter.get_instruction();
+                break;
+            }
+        }
+
+        // a quirk is to blame when flipping it alone changes what that instruction does, whether or not the runs
+        // come back together afterwards
+        const auto diff = differences(out.combo, rep.reference);
+        for (unsigned q = 0; q < quirk_strings.size(); ++q) {
+            if ((diff >> q & 1u) == 0) { continue; }
+            if (diff == 1u << q || diverges_at(neighbour(rep.reference, out.combo, static_cast<quirk>(q)), out.cycle)) {
+                out.culprit = static_cast<quirk>(q);
+                break;
+            }
+        }
+    };
+
+    std::atomic<std::size_t> next{};
+    {
+        std::vector<std::jthread> workers;
+        const auto threads = std::clamp<std::size_t>(opts.threads, 1, headless::QUIRK_COMBOS - 1);
+        for (std::size_t t = 0; t < threads; ++t) {
+            workers.emplace_back([&] {
+                for (auto i = next++; i < rep.outcomes.size(); i = next++) {
+                    if (i != rep.reference) { compare(rep.outcomes[i]); }
+                }
+            });
+        }
+    }
+
+    rep.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return rep;
+}
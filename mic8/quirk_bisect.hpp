@@ -0,0 +1,79 @@
+#pragma once
+
+#include "chip8.hpp"
+#include "headless.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <stop_token>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Finds which quirk a ROM depends on. The ROM runs under every quirk combination of its variant with the same seed
+// and inputs, frame by frame against a reference combination, comparing a rolling hash of the registers, stack,
+// timers and screen at the end of each frame. A combination that parts from the reference is replayed up to that
+// frame and then stepped one cycle at a time to find the instruction where it diverged. The quirk blamed is the one
+// whose flip alone changes the result of that instruction too.
+class quirk_bisect {
+public:
+    enum class quirk : unsigned char {
+        vip_alu,
+        chip48_jmp,
+        chip48_shf,
+        ls_mode
+    };
+
+    static inline constexpr std::array<const char *, 4> quirk_strings = {"vip_alu", "chip48_jmp", "chip48_shf",
+                                                                         "ls_mode"};
+    static inline constexpr std::array<const char *, 3> ls_mode_strings = {"chip8_ls", "chip48_ls", "schip11_ls"};
+
+    struct options {
+        std::uint64_t cycles{100'000};
+        std::uint64_t cycles_per_frame{20};
+        std::uint32_t seed{1};
+        unsigned threads{std::max(1u, std::thread::hardware_concurrency())};
+    };
+
+    // how one combination compares with the reference
+    struct outcome {
+        // as in headless::make_alt_ops
+        std::size_t combo{};
+        bool diverged{};
+        // the frame it was noticed at the end of, counting from 0
+        std::uint64_t frame{};
+        // the cycle of the first instruction whose result differs, counting from 1
+        std::uint64_t cycle{};
+        std::uint16_t pc{};
+        std::uint16_t opcode{};
+        // the reference's disassembly of it
+        std::string instruction;
+        // empty if only flipping several quirks together changes the instruction
+        std::optional<quirk> culprit;
+    };
+
+    struct report {
+        std::size_t reference{};
+        chip8::variant variant{};
+        // one per combination, the reference included
+        std::vector<outcome> outcomes;
+        double seconds{};
+    };
+
+    // the harness' combo number of a set of quirks
+    static auto combo_of(const chip8::alt_t &alt_ops) -> std::size_t;
+
+    // the quirks two combos differ in, bit n for quirk n
+    static auto differences(std::size_t a, std::size_t b) -> unsigned;
+
+    // the quirks set in a combo, e.g. "vip_alu chip48_shf schip11_ls"
+    static auto describe(std::size_t combo) -> std::string;
+
+    // runs every combination against reference on opts.threads threads, checking stop between frames; throws if the
+    // ROM does not load
+    static auto run(const std::string &rom, const chip8::alt_t &reference, const options &opts,
+                    const std::vector<headless::input_event> &events, std::stop_token stop = {}) -> report;
+};
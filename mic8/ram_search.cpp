@@ -0,0 +1,112 @@
+#include "ram_search.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <stdexcept>
+
+namespace {
+    // GCC and Clang vector extensions: SSE2 on x86, NEON on ARM, wasm SIMD or plain loops elsewhere
+    constexpr std::size_t VECTOR{16};
+    using vec = std::uint8_t __attribute__((vector_size(VECTOR)));
+
+    auto load(const std::uint8_t *bytes) -> vec {
+        vec v;
+        std::memcpy(&v, bytes, VECTOR);
+        return v;
+    }
+
+    // the tail of a memory whose size is not a multiple of VECTOR reads as zeroes
+    auto load(const std::span<const std::uint8_t> mem, const std::size_t offset) -> vec {
+        if (offset + VECTOR <= mem.size()) { return load(mem.data() + offset); }
+        vec v{};
+        std::memcpy(&v, mem.data() + offset, mem.size() - offset);
+        return v;
+    }
+
+    void store(std::uint8_t *bytes, const vec v) { std::memcpy(bytes, &v, VECTOR); }
+
+    auto none(const vec v) -> bool {
+        const auto words = std::bit_cast<std::array<std::uint64_t, VECTOR / 8>>(v);
+        return (words[0] | words[1]) == 0;
+    }
+
+    // keep(current, previous) returns 0xFF where an address stays a candidate. Blocks with no candidates left are
+    // skipped, snapshots included, since nothing reads them again.
+    template<typename F>
+    void narrow(const std::span<const std::span<const std::uint8_t>> mems,
+                std::vector<std::vector<std::uint8_t>> &snapshots, std::vector<std::uint8_t> &mask, const F &keep) {
+        for (std::size_t offset = 0; offset < mask.size(); offset += VECTOR) {
+            auto m = load(mask.data() + offset);
+            if (none(m)) { continue; }
+            for (std::size_t lane = 0; lane < mems.size(); ++lane) {
+                const auto current = load(mems[lane], offset);
+                m &= std::bit_cast<vec>(keep(current, load(snapshots[lane].data() + offset)));
+                store(snapshots[lane].data() + offset, current);
+            }
+            store(mask.data() + offset, m);
+        }
+    }
+}
+
+void ram_search::check(const std::span<const std::span<const std::uint8_t>> mems) const {
+    if (mems.size() != snapshots.size()) { throw std::invalid_argument("Expected one memory per search lane!"); }
+    if (std::ranges::any_of(mems, [this](const auto mem) { return mem.size() != size; })) {
+        throw std::invalid_argument("Every memory in a search must be the same size!");
+    }
+}
+
+void ram_search::reset(const std::span<const std::span<const std::uint8_t>> mems) {
+    if (mems.empty()) { throw std::invalid_argument("A search needs at least one memory!"); }
+    size = mems.front().size();
+    const auto padded = (size + VECTOR - 1) / VECTOR * VECTOR;
+    snapshots.assign(mems.size(), std::vector<std::uint8_t>(padded));
+    check(mems);
+    for (std::size_t lane = 0; lane < mems.size(); ++lane) { std::ranges::copy(mems[lane], snapshots[lane].begin()); }
+    mask.assign(padded, 0);
+    std::fill_n(mask.begin(), size, 0xFF);
+    candidates.resize(size);
+    for (std::size_t addr = 0; addr < size; ++addr) { candidates[addr] = static_cast<std::uint16_t>(addr); }
+    filters = 0;
+}
+
+void ram_search::filter(const std::span<const std::span<const std::uint8_t>> mems, const condition cond,
+                        const std::uint8_t value) {
+    check(mems);
+    const vec k = vec{} + value;
+    switch (cond) {
+        case condition::equal:
+            narrow(mems, snapshots, mask, [k](const vec c, vec) { return c == k; });
+            break;
+        case condition::not_equal:
+            narrow(mems, snapshots, mask, [k](const vec c, vec) { return c != k; });
+            break;
+        case condition::greater:
+            narrow(mems, snapshots, mask, [k](const vec c, vec) { return c > k; });
+            break;
+        case condition::less:
+            narrow(mems, snapshots, mask, [k](const vec c, vec) { return c < k; });
+            break;
+        case condition::changed:
+            narrow(mems, snapshots, mask, [](const vec c, const vec p) { return c != p; });
+            break;
+        case condition::unchanged:
+            narrow(mems, snapshots, mask, [](const vec c, const vec p) { return c == p; });
+            break;
+        case condition::increased:
+            narrow(mems, snapshots, mask, [](const vec c, const vec p) { return c > p; });
+            break;
+        case condition::decreased:
+            narrow(mems, snapshots, mask, [](const vec c, const vec p) { return c < p; });
+            break;
+        // byte arithmetic wraps, so a counter going from 0xFF to 0x00 has increased by 1
+        case condition::increased_by:
+            narrow(mems, snapshots, mask, [k](const vec c, const vec p) { return c - p == k; });
+            break;
+        case condition::decreased_by:
+            narrow(mems, snapshots, mask, [k](const vec c, const vec p) { return p - c == k; });
+            break;
+    }
+    std::erase_if(candidates, [this](const std::uint16_t addr) { return mask[addr] == 0; });
+    ++filters;
+}
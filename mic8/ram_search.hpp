@@ -0,0 +1,68 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// A cheat finder over one or more memories of the same size, usually instances running the same ROM. Every address
+// starts as a candidate, and each filter keeps the ones where every memory meets the condition, then snapshots them.
+// Filters compare whole snapshots a vector at a time, so narrowing a 64 KB memory costs microseconds.
+class ram_search {
+public:
+    enum class condition : unsigned char {
+        equal,
+        not_equal,
+        greater,
+        less,
+        changed,
+        unchanged,
+        increased,
+        decreased,
+        increased_by,
+        decreased_by
+    };
+
+    static inline constexpr std::array<const char *, 10> condition_strings = {
+        "Equal to", "Not equal to", "Greater than", "Less than", "Changed", "Unchanged", "Increased", "Decreased",
+        "Increased by", "Decreased by"
+    };
+
+    // whether the condition compares against a value rather than only the previous snapshot
+    static constexpr auto takes_value(const condition cond) -> bool {
+        return cond == condition::equal || cond == condition::not_equal || cond == condition::greater ||
+               cond == condition::less || cond == condition::increased_by || cond == condition::decreased_by;
+    }
+
+    // starts over with every address a candidate, throws unless the memories share a size
+    void reset(std::span<const std::span<const std::uint8_t>> mems);
+
+    // mems must be the memories the search was reset with, in the same order. value is ignored unless the
+    // condition takes one.
+    void filter(std::span<const std::span<const std::uint8_t>> mems, condition cond, std::uint8_t value);
+
+    // the remaining addresses, ascending
+    [[nodiscard]] constexpr auto get_candidates() const -> const std::vector<std::uint16_t> & { return candidates; }
+
+    // the value of addr in memory lane at the last snapshot
+    [[nodiscard]] auto get_previous(std::size_t lane, std::uint16_t addr) const -> std::uint8_t {
+        return snapshots[lane][addr];
+    }
+
+    [[nodiscard]] constexpr auto get_size() const -> std::size_t { return size; }
+
+    [[nodiscard]] constexpr auto get_lanes() const -> std::size_t { return snapshots.size(); }
+
+    [[nodiscard]] constexpr auto get_filters() const -> std::uint64_t { return filters; }
+
+private:
+    std::size_t size{};
+    std::vector<std::vector<std::uint8_t>> snapshots;
+    // 0xFF where the address is still a candidate
+    std::vector<std::uint8_t> mask;
+    std::vector<std::uint16_t> candidates;
+    std::uint64_t filters{};
+
+    void check(std::span<const std::span<const std::uint8_t>> mems) const;
+};
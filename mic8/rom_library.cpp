@@ -0,0 +1,372 @@
+#include "rom_library.hpp"
+#include "movie.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+
+namespace {
+    // just enough JSON for programs.json: values are read where the caller expects them and skipped otherwise
+    class json_reader {
+    public:
+        explicit json_reader(const std::string_view text) : text(text) {}
+
+        template<typename F>
+        void object(const F &on_member) {
+            expect('{');
+            if (consume('}')) { return; }
+            do {
+                const auto key = string();
+                expect(':');
+                on_member(key);
+            } while (consume(','));
+            expect('}');
+        }
+
+        template<typename F>
+        void array(const F &on_item) {
+            expect('[');
+            if (consume(']')) { return; }
+            do { on_item(); } while (consume(','));
+            expect(']');
+        }
+
+        auto string() -> std::string {
+            expect('"');
+            std::string value;
+            while (pos < text.size() && text[pos] != '"') {
+                auto c = text[pos++];
+                if (c == '\\') {
+                    if (pos >= text.size()) { break; }
+                    c = text[pos++];
+                    switch (c) {
+                        case 'b': c = '\b'; break;
+                        case 'f': c = '\f'; break;
+                        case 'n': c = '\n'; break;
+                        case 'r': c = '\r'; break;
+                        case 't': c = '\t'; break;
+                        case 'u':
+                            utf8(value, hex4());
+                            continue;
+                        default: break;
+                    }
+                }
+                value.push_back(c);
+            }
+            expect('"');
+            return value;
+        }
+
+        auto number() -> double {
+            whitespace();
+            double value{};
+            const auto [end, ec] = std::from_chars(text.data() + pos, text.data() + text.size(), value);
+            if (ec != std::errc{}) { fail(); }
+            pos = static_cast<std::size_t>(end - text.data());
+            return value;
+        }
+
+        auto boolean() -> bool {
+            if (literal("true")) { return true; }
+            if (literal("false")) { return false; }
+            fail();
+        }
+
+        // a number, or a string holding one, as archives are not always consistent
+        auto numeric() -> double {
+            if (peek() != '"') { return number(); }
+            const auto value = string();
+            double result{};
+            std::from_chars(value.data(), value.data() + value.size(), result);
+            return result;
+        }
+
+        // strings and numbers also count
+        auto truthy() -> bool {
+            switch (peek()) {
+                case '"': return string() == "true";
+                case 't':
+                case 'f': return boolean();
+                default: return number() != 0;
+            }
+        }
+
+        void skip() {
+            switch (peek()) {
+                case '{': object([this](const std::string &) { skip(); }); break;
+                case '[': array([this] { skip(); }); break;
+                case '"': string(); break;
+                case 't':
+                case 'f': boolean(); break;
+                case 'n':
+                    if (!literal("null")) { fail(); }
+                    break;
+                default: number();
+            }
+        }
+
+        auto peek() -> char {
+            whitespace();
+            if (pos >= text.size()) { fail(); }
+            return text[pos];
+        }
+
+    private:
+        std::string_view text;
+        std::size_t pos{};
+
+        [[noreturn]] static void fail() { throw std::invalid_argument("Malformed programs.json!"); }
+
+        void whitespace() {
+            while (pos < text.size() && (text[pos] == ' ' || text[pos] == '\n' || text[pos] == '\r' ||
+                                         text[pos] == '\t')) { ++pos; }
+        }
+
+        auto consume(const char c) -> bool {
+            whitespace();
+            if (pos < text.size() && text[pos] == c) {
+                ++pos;
+                return true;
+            }
+            return false;
+        }
+
+        void expect(const char c) {
+            if (!consume(c)) { fail(); }
+        }
+
+        auto literal(const std::string_view word) -> bool {
+            whitespace();
+            if (text.substr(pos, word.size()) != word) { return false; }
+            pos += word.size();
+            return true;
+        }
+
+        auto hex4() -> unsigned {
+            unsigned value{};
+            if (pos + 4 > text.size()) { fail(); }
+            const auto [end, ec] = std::from_chars(text.data() + pos, text.data() + pos + 4, value, 16);
+            if (ec != std::errc{} || end != text.data() + pos + 4) { fail(); }
+            pos += 4;
+            return value;
+        }
+
+        // surrogate pairs are left as two replacement characters, titles rarely need them
+        static void utf8(std::string &out, unsigned cp) {
+            if (cp >= 0xD800 && cp <= 0xDFFF) { cp = 0xFFFD; }
+            if (cp < 0x80) {
+                out.push_back(static_cast<char>(cp));
+            } else if (cp < 0x800) {
+                out.push_back(static_cast<char>(0xC0 | cp >> 6u));
+                out.push_back(static_cast<char>(0x80 | (cp & 0x3Fu)));
+            } else {
+                out.push_back(static_cast<char>(0xE0 | cp >> 12u));
+                out.push_back(static_cast<char>(0x80 | (cp >> 6u & 0x3Fu)));
+                out.push_back(static_cast<char>(0x80 | (cp & 0x3Fu)));
+            }
+        }
+    };
+
+    using profile_map = std::unordered_map<std::string, std::shared_ptr<const rom_profile>>;
+
+    // Octo's quirk options as chip8Archive spells them, mapped onto alt_t. Clipping, VF order and vblank quirks have
+    // no counterpart and are ignored.
+    auto read_profile(json_reader &reader, const std::string &key) -> std::shared_ptr<const rom_profile> {
+        auto profile = std::make_shared<rom_profile>();
+        profile->key = key;
+        reader.object([&](const std::string &member) {
+            if (member == "title") {
+                profile->title = reader.string();
+            } else if (member == "authors" && reader.peek() == '[') {
+                reader.array([&] {
+                    if (!profile->authors.empty()) { profile->authors += ", "; }
+                    profile->authors += reader.string();
+                });
+            } else if (member == "platform") {
+                const auto platform = reader.string();
+                if (platform == "xochip") {
+                    profile->alt_ops.variant = chip8::variant::xochip;
+                } else if (platform.starts_with("schip") || platform == "superchip") {
+                    profile->alt_ops.variant = chip8::variant::schip;
+                }
+            } else if (member == "options" && reader.peek() == '{') {
+                reader.object([&](const std::string &option) {
+                    if (option == "tickrate") {
+                        profile->tickrate = static_cast<unsigned>(std::max(0.0, reader.numeric()));
+                    } else if (option == "shiftQuirks") {
+                        profile->alt_ops.chip48_shf = reader.truthy();
+                    } else if (option == "jumpQuirks") {
+                        profile->alt_ops.chip48_jmp = reader.truthy();
+                    } else if (option == "logicQuirks") {
+                        profile->alt_ops.vip_alu = reader.truthy();
+                    } else if (option == "loadStoreQuirk") {
+                        profile->alt_ops.ls_mode = reader.truthy() ? chip8::ls_mode::schip11_ls
+                                                                   : chip8::ls_mode::chip8_ls;
+                    } else {
+                        reader.skip();
+                    }
+                });
+            } else {
+                reader.skip();
+            }
+        });
+        if (profile->title.empty()) { profile->title = key; }
+        return profile;
+    }
+
+    auto load_profiles(const std::filesystem::path &path) -> profile_map {
+        std::ifstream file(path, std::ios::binary);
+        if (!file) { return {}; }
+        const std::string text{std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+        json_reader reader(text);
+        profile_map profiles;
+        reader.object([&](const std::string &key) { profiles[key] = read_profile(reader, key); });
+        return profiles;
+    }
+
+    struct cache_line {
+        std::int64_t mtime;
+        std::uintmax_t size;
+        std::uint64_t hash;
+        std::string key;
+    };
+
+    // <hash> <mtime> <size> <programs.json key or -> <path relative to dir>, one ROM per line
+    auto load_cache(const std::filesystem::path &path) -> std::unordered_map<std::string, cache_line> {
+        std::unordered_map<std::string, cache_line> cache;
+        std::ifstream file(path);
+        std::string line;
+        while (std::getline(file, line)) {
+            std::size_t begin = 0;
+            const auto field = [&] {
+                const auto end = std::min(line.find(' ', begin), line.size());
+                const auto value = std::string_view(line).substr(begin, end - begin);
+                begin = end + 1;
+                return value;
+            };
+            const auto parse = [](const std::string_view text, auto &value, const int base = 10) {
+                return std::from_chars(text.data(), text.data() + text.size(), value, base).ec == std::errc{};
+            };
+            cache_line entry{};
+            if (!parse(field(), entry.hash, 16) || !parse(field(), entry.mtime) || !parse(field(), entry.size)) {
+                continue;
+            }
+            const auto key = field();
+            entry.key = key == "-" ? "" : std::string(key);
+            if (begin >= line.size()) { continue; }
+            cache.emplace(line.substr(begin), std::move(entry));
+        }
+        return cache;
+    }
+
+    auto is_rom(const std::filesystem::path &path) -> bool {
+        const auto ext = path.extension();
+        return ext == ".ch8" || ext == ".sc8" || ext == ".xo8" || ext == ".c8";
+    }
+}
+
+rom_library::rom_library(std::string dir) : dir(std::move(dir)) { rescan(); }
+
+void rom_library::rescan() {
+    // assigning stops and joins a scan in progress
+    worker = {};
+    scanning.store(true, std::memory_order_release);
+    worker = std::jthread([this](const std::stop_token &stop) { scan(stop); });
+}
+
+auto rom_library::poll() -> bool {
+    const std::scoped_lock lock(mutex);
+    if (!ready) { return false; }
+    entries = std::move(pending);
+    error = std::move(pending_error);
+    pending = {};
+    ready = false;
+    return true;
+}
+
+void rom_library::scan(const std::stop_token &stop) {
+    const std::filesystem::path root(dir);
+    std::string scan_error;
+    profile_map profiles;
+    try {
+        profiles = load_profiles(root / PROGRAMS_NAME);
+    } catch (const std::invalid_argument &e) {
+        scan_error = e.what();
+    }
+    auto cache = load_cache(root / CACHE_NAME);
+
+    // contents already matched to a programs.json key, whatever the file is called now
+    std::unordered_map<std::uint64_t, std::string> known;
+    for (const auto &[path, line]: cache) {
+        if (!line.key.empty() && profiles.contains(line.key)) { known.emplace(line.hash, line.key); }
+    }
+
+    std::vector<entry> found;
+    std::vector<cache_line> lines;
+    std::error_code ec;
+    for (auto it = std::filesystem::recursive_directory_iterator(root, ec);
+         !ec && it != std::filesystem::recursive_directory_iterator(); it.increment(ec)) {
+        if (stop.stop_requested()) {
+            scanning.store(false, std::memory_order_release);
+            return;
+        }
+        std::error_code file_ec;
+        if (!it->is_regular_file(file_ec) || !is_rom(it->path())) { continue; }
+        const auto relative = it->path().lexically_relative(root).generic_string();
+        const auto mtime = static_cast<std::int64_t>(it->last_write_time(file_ec).time_since_epoch().count());
+        const auto size = it->file_size(file_ec);
+        if (file_ec) { continue; }
+        std::uint64_t rom_hash{};
+        if (const auto cached = cache.find(relative);
+            cached != cache.end() && cached->second.mtime == mtime && cached->second.size == size) {
+            rom_hash = cached->second.hash;
+        } else {
+            try {
+                rom_hash = movie::hash_rom(it->path().string());
+            } catch (const std::invalid_argument &) {
+                continue;
+            }
+        }
+        auto stem = it->path().stem().string();
+        if (profiles.contains(stem)) { known.emplace(rom_hash, stem); }
+        found.push_back({it->path().string(), std::move(stem), rom_hash, nullptr});
+        lines.push_back({mtime, size, rom_hash, {}});
+    }
+
+    for (std::size_t i = 0; i < found.size(); ++i) {
+        if (const auto key = known.find(found[i].hash); key != known.end()) {
+            found[i].profile = profiles.at(key->second);
+            lines[i].key = key->second;
+        }
+    }
+
+    // written next to the ROMs and renamed into place, a crash mid-write leaves the old cache
+    const auto cache_path = root / CACHE_NAME;
+    auto temp_path = cache_path;
+    temp_path += ".tmp";
+    if (std::ofstream file(temp_path); file) {
+        for (std::size_t i = 0; i < found.size(); ++i) {
+            file << std::format("{:016x} {} {} {} {}\n", lines[i].hash, lines[i].mtime, lines[i].size,
+                                lines[i].key.empty() ? "-" : lines[i].key,
+                                std::filesystem::path(found[i].path).lexically_relative(root).generic_string());
+        }
+        file.close();
+        std::filesystem::rename(temp_path, cache_path, ec);
+    }
+
+    std::ranges::sort(found, [](const entry &a, const entry &b) { return a.name < b.name; });
+    {
+        const std::scoped_lock lock(mutex);
+        pending = std::move(found);
+        pending_error = std::move(scan_error);
+        ready = true;
+    }
+    scanning.store(false, std::memory_order_release);
+}
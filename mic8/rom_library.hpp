@@ -0,0 +1,71 @@
+#pragma once
+
+#include "chip8.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// what chip8Archive's programs.json recommends for a ROM
+struct rom_profile {
+    std::string key;
+    std::string title;
+    std::string authors;
+    chip8::alt_t alt_ops;
+    // cycles per 60 Hz frame, 0 if the archive does not say
+    unsigned tickrate{};
+};
+
+// Every ROM under a directory, indexed on a background thread. Hashes are cached in dir/.mic8_library by path,
+// mtime and size, so a rescan only reads new or changed files. A ROM gets a profile when its file name matches a
+// programs.json key in dir, or when its contents match a ROM that did, so renamed copies are recognised too.
+class rom_library {
+public:
+    struct entry {
+        std::string path;
+        std::string name;
+        std::uint64_t hash;
+        std::shared_ptr<const rom_profile> profile;
+    };
+
+    static constexpr auto CACHE_NAME{".mic8_library"};
+    static constexpr auto PROGRAMS_NAME{"programs.json"};
+
+    // starts the first scan
+    explicit rom_library(std::string dir);
+
+    void rescan();
+
+    // takes the result of a finished scan, true if the entries changed
+    auto poll() -> bool;
+
+    // sorted by name
+    [[nodiscard]] constexpr auto get_entries() const -> const std::vector<entry> & { return entries; }
+
+    [[nodiscard]] constexpr auto get_dir() const -> const std::string & { return dir; }
+
+    [[nodiscard]] auto get_scanning() const -> bool { return scanning.load(std::memory_order_acquire); }
+
+    // why programs.json was not used, empty if it was or there is none
+    [[nodiscard]] constexpr auto get_error() const -> const std::string & { return error; }
+
+private:
+    std::string dir;
+    std::vector<entry> entries;
+    std::string error;
+
+    std::mutex mutex;
+    std::vector<entry> pending;
+    std::string pending_error;
+    bool ready{};
+    std::atomic<bool> scanning{};
+    // last, so it stops before the members it fills are destroyed
+    std::jthread worker;
+
+    void scan(const std::stop_token &stop);
+};
@@ -0,0 +1,19 @@
+#!/usr/bin/env python3
+# Static file server for the web builds. SharedArrayBuffer is only available to cross-origin isolated pages,
+# which needs the two headers below on every response.
+import functools
+import http.server
+import sys
+
+
+class IsolatedHandler(http.server.SimpleHTTPRequestHandler):
+    def end_headers(self):
+        self.send_header("Cross-Origin-Opener-Policy", "same-origin")
+        self.send_header("Cross-Origin-Embedder-Policy", "require-corp")
+        super().end_headers()
+
+
+if __name__ == "__main__":
+    directory = sys.argv[1] if len(sys.argv) > 1 else "."
+    port = int(sys.argv[2]) if len(sys.argv) > 2 else 8000
+    http.server.test(HandlerClass=functools.partial(IsolatedHandler, directory=directory), port=port)
@@ -0,0 +1,292 @@
+#include "chip8.hpp"
+#include "hash.hpp"
+#include "headless.hpp"
+#include "shared_frame.hpp"
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <csignal>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <format>
+#include <map>
+#include <memory>
+#include <span>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+    struct options {
+        std::string socket_path{"mic8.sock"};
+        // an inherited, already connected socket to serve instead of listening, -1 if none
+        int fd{-1};
+        std::uint64_t cycles_per_frame{1000};
+    };
+
+    struct session {
+        std::unique_ptr<chip8> interpreter;
+        std::unique_ptr<shared_frame_writer> shared;
+        std::uint64_t cycles{};
+        std::uint64_t frames{};
+
+        void publish() const { shared->publish(*interpreter, frames, cycles); }
+    };
+
+    struct client {
+        int fd;
+        std::string input;
+    };
+
+    // longer than any command with a path in it; a client sending more without a newline is dropped
+    constexpr std::size_t MAX_LINE{8192};
+
+    volatile std::sig_atomic_t stop_requested{};
+
+    auto parse_options(const std::span<char *> args) -> options {
+        options opts;
+        for (std::size_t i = 1; i < args.size(); ++i) {
+            const std::string_view arg = args[i];
+            const auto value = [&] {
+                if (i + 1 >= args.size()) { throw std::invalid_argument(std::format("Missing value for {}", arg)); }
+                return std::string_view(args[++i]);
+            };
+            if (arg == "--socket") {
+                opts.socket_path = value();
+            } else if (arg == "--fd") {
+                opts.fd = static_cast<int>(headless::parse_number(value()));
+            } else if (arg == "--cpf") {
+                opts.cycles_per_frame = std::max<std::uint64_t>(1, headless::parse_number(value()));
+            } else {
+                throw std::invalid_argument(std::format("Unknown option: {}", arg));
+            }
+        }
+        return opts;
+    }
+
+    auto stop_reason_name(const chip8::stop_reason reason) -> std::string_view {
+        switch (reason) {
+            case chip8::stop_reason::budget: return "budget";
+            case chip8::stop_reason::halted: return "halted";
+            case chip8::stop_reason::key_wait: return "key_wait";
+            case chip8::stop_reason::breakpoint: return "breakpoint";
+            case chip8::stop_reason::draw: return "draw";
+        }
+        return "unknown";
+    }
+
+    class server {
+    public:
+        explicit server(const options &opts) : opts(opts) {}
+
+        // one command per line, each answered by one line starting with "ok" or "err"
+        auto execute(const std::string_view line) -> std::string {
+            std::istringstream words{std::string(line)};
+            std::string command;
+            words >> command;
+            const auto next = [&] {
+                std::string word;
+                if (!(words >> word)) { throw std::invalid_argument(std::format("Missing argument for {}", command)); }
+                return word;
+            };
+            const auto find = [&]() -> session & {
+                const auto it = sessions.find(headless::parse_number(next()));
+                if (it == sessions.end()) { throw std::invalid_argument("No such instance"); }
+                return it->second;
+            };
+
+            if (command == "create") {
+                std::string variant{"chip8"};
+                std::string seed{"1"};
+                words >> variant >> seed;
+                chip8::alt_t alt_ops;
+                alt_ops.variant = headless::parse_variant(variant);
+                session s{std::make_unique<chip8>(alt_ops)};
+                s.interpreter->seed(static_cast<std::uint32_t>(headless::parse_number(seed)));
+                const auto id = next_id++;
+                s.interpreter->set_trace_id(static_cast<std::uint32_t>(id));
+                s.shared = std::make_unique<shared_frame_writer>(std::format("/mic8-{}-{}", getpid(), id));
+                s.publish();
+                const auto &name = sessions.emplace(id, std::move(s)).first->second.shared->get_name();
+                return std::format("ok {} {}", id, name);
+            }
+            if (command == "load") {
+                auto &s = find();
+                std::string path;
+                std::getline(words >> std::ws, path);
+                s.interpreter->unload_rom();
+                s.interpreter->load_rom(path);
+                s.cycles = 0;
+                s.frames = 0;
+                s.publish();
+                return "ok";
+            }
+            if (command == "run") {
+                auto &s = find();
+                return run(s, headless::parse_number(next()) * opts.cycles_per_frame);
+            }
+            if (command == "step") {
+                auto &s = find();
+                const auto [reason, executed] = s.interpreter->run_cycles(headless::parse_number(next()));
+                s.cycles += executed;
+                s.publish();
+                return std::format("ok {} {}", stop_reason_name(reason), executed);
+            }
+            if (command == "keys") {
+                auto &s = find();
+                const auto mask = next();
+                unsigned keys{};
+                if (std::sscanf(mask.c_str(), "%x", &keys) != 1) {
+                    throw std::invalid_argument(std::format("Invalid key mask: {}", mask));
+                }
+                for (std::size_t key = 0; key < chip8::KEY_COUNT; ++key) {
+                    s.interpreter->keys[key] = (keys >> key & 1u) != 0;
+                }
+                s.publish();
+                return "ok";
+            }
+            if (command == "snapshot") {
+                const auto &s = find();
+                s.publish();
+                return std::format("ok {} {} {:03X} {:016x} {:016x}", s.frames, s.cycles, s.interpreter->get_pc(),
+                                   hash::fb_hash(*s.interpreter), hash::state_hash(*s.interpreter));
+            }
+            if (command == "destroy") {
+                const auto id = headless::parse_number(next());
+                if (sessions.erase(id) == 0) { throw std::invalid_argument("No such instance"); }
+                return "ok";
+            }
+            throw std::invalid_argument(std::format("Unknown command: {}", command));
+        }
+
+    private:
+        const options &opts;
+        std::map<std::uint64_t, session> sessions;
+        std::uint64_t next_id{};
+
+        // ticks the timers every cycles_per_frame cycles and publishes each frame as it completes
+        auto run(session &s, const std::uint64_t cycles) -> std::string {
+            auto reason = chip8::stop_reason::budget;
+            std::uint64_t executed = 0;
+            while (executed < cycles) {
+                const auto next_tick = (s.cycles / opts.cycles_per_frame + 1) * opts.cycles_per_frame;
+                const auto result = s.interpreter->run_cycles(std::min(next_tick - s.cycles, cycles - executed));
+                reason = result.reason;
+                executed += result.cycles;
+                s.cycles += result.cycles;
+                if (s.cycles % opts.cycles_per_frame == 0) {
+                    s.interpreter->decrement_timers();
+                    ++s.frames;
+                    s.publish();
+                }
+                if (reason == chip8::stop_reason::halted) { break; }
+            }
+            if (reason != chip8::stop_reason::halted) { reason = chip8::stop_reason::budget; }
+            s.publish();
+            return std::format("ok {} {}", stop_reason_name(reason), executed);
+        }
+    };
+
+    auto listen_on(const std::string &path) -> int {
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        if (path.size() >= sizeof(address.sun_path)) { throw std::invalid_argument("Socket path is too long!"); }
+        std::ranges::copy(path, address.sun_path);
+        const int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        unlink(path.c_str());
+        if (fd < 0 || bind(fd, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) != 0 ||
+            listen(fd, SOMAXCONN) != 0) {
+            if (fd >= 0) { close(fd); }
+            throw std::runtime_error(std::format("Failed to listen on {}!", path));
+        }
+        return fd;
+    }
+
+    // answers every complete line received so far in a single write, so a batch costs one round trip
+    auto serve(server &srv, client &c) -> bool {
+        char buffer[4096];
+        const auto received = recv(c.fd, buffer, sizeof(buffer), 0);
+        if (received <= 0) { return false; }
+        c.input.append(buffer, static_cast<std::size_t>(received));
+
+        std::string replies;
+        std::size_t start = 0;
+        bool overlong = false;
+        for (auto end = c.input.find('\n'); end != std::string::npos; end = c.input.find('\n', start)) {
+            const std::string_view line = std::string_view(c.input).substr(start, end - start);
+            start = end + 1;
+            if (line.size() > MAX_LINE) {
+                overlong = true;
+                break;
+            }
+            if (line.find_first_not_of(" \t\r") == std::string_view::npos) { continue; }
+            try {
+                replies += srv.execute(line);
+            } catch (const std::exception &e) {
+                replies += std::format("err {}", e.what());
+            }
+            replies += '\n';
+        }
+        c.input.erase(0, start);
+        overlong = overlong || c.input.size() > MAX_LINE;
+        if (overlong) { replies += std::format("err Line longer than {} bytes!\n", MAX_LINE); }
+
+        for (std::size_t sent = 0; sent < replies.size();) {
+            const auto n = send(c.fd, replies.data() + sent, replies.size() - sent, MSG_NOSIGNAL);
+            if (n <= 0) { return false; }
+            sent += static_cast<std::size_t>(n);
+        }
+        return !overlong;
+    }
+}
+
+// hosts headless instances for other processes: frames go out through shared memory, commands come in over a
+// Unix domain socket. With --fd it serves the one socket its parent passed down and exits when that closes, which is
+// how shard_pool runs it as a worker.
+auto main(int argc, char *argv[]) -> int {
+    try {
+        const auto opts = parse_options(std::span(argv, static_cast<std::size_t>(argc)));
+        // poll skips the negative descriptor, so an inherited socket is served as the only client
+        const int listener = opts.fd < 0 ? listen_on(opts.socket_path) : -1;
+        std::signal(SIGINT, [](int) { stop_requested = 1; });
+        std::signal(SIGTERM, [](int) { stop_requested = 1; });
+        if (listener >= 0) { std::fprintf(stderr, "listening on %s\n", opts.socket_path.c_str()); }
+
+        server srv(opts);
+        std::vector<client> clients;
+        if (opts.fd >= 0) { clients.push_back({opts.fd}); }
+        while (stop_requested == 0 && (listener >= 0 || !clients.empty())) {
+            std::vector<pollfd> fds{{listener, POLLIN, 0}};
+            for (const auto &c: clients) { fds.push_back({c.fd, POLLIN, 0}); }
+            if (poll(fds.data(), fds.size(), -1) < 0) { continue; }
+            for (std::size_t i = clients.size(); i > 0; --i) {
+                if (fds[i].revents == 0) { continue; }
+                if (!serve(srv, clients[i - 1])) {
+                    close(clients[i - 1].fd);
+                    clients.erase(clients.begin() + static_cast<std::ptrdiff_t>(i - 1));
+                }
+            }
+            if ((fds[0].revents & POLLIN) != 0) {
+                if (const int fd = accept4(listener, nullptr, nullptr, SOCK_CLOEXEC); fd >= 0) { clients.push_back({fd}); }
+            }
+        }
+
+        for (const auto &c: clients) { close(c.fd); }
+        if (listener >= 0) {
+            close(listener);
+            unlink(opts.socket_path.c_str());
+        }
+        return 0;
+    } catch (const std::exception &e) {
+        std::fprintf(stderr, "%s\n", e.what());
+        return 2;
+    }
+}
@@ -0,0 +1,325 @@
+#include "shard_pool.hpp"
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <csignal>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+
+namespace {
+    constexpr std::array<const char *, 3> VARIANT_NAMES{"chip8", "schip", "xochip"};
+
+    // "0-3,8-11" as the kernel lists a node's CPUs
+    auto parse_cpu_list(const std::string_view list) -> std::vector<int> {
+        std::vector<int> cpus;
+        std::size_t begin = 0;
+        while (begin < list.size()) {
+            const auto end = std::min(list.find(',', begin), list.size());
+            const auto range = list.substr(begin, end - begin);
+            begin = end + 1;
+            int first{};
+            int last{};
+            const auto [dash, ec] = std::from_chars(range.data(), range.data() + range.size(), first);
+            if (ec != std::errc{}) { continue; }
+            last = first;
+            if (dash != range.data() + range.size() && *dash == '-') {
+                std::from_chars(dash + 1, range.data() + range.size(), last);
+            }
+            for (auto cpu = first; cpu <= last; ++cpu) { cpus.push_back(cpu); }
+        }
+        return cpus;
+    }
+
+    // nodes without CPUs hold memory only and are skipped
+    auto read_nodes() -> std::vector<std::vector<int>> {
+        std::vector<std::pair<int, std::vector<int>>> found;
+        std::error_code ec;
+        for (const auto &entry: std::filesystem::directory_iterator("/sys/devices/system/node", ec)) {
+            const auto name = entry.path().filename().string();
+            int number{};
+            if (!name.starts_with("node") ||
+                std::from_chars(name.data() + 4, name.data() + name.size(), number).ec != std::errc{}) { continue; }
+            std::ifstream file(entry.path() / "cpulist");
+            std::string list;
+            std::getline(file, list);
+            if (auto cpus = parse_cpu_list(list); !cpus.empty()) { found.emplace_back(number, std::move(cpus)); }
+        }
+        std::ranges::sort(found);
+        std::vector<std::vector<int>> nodes;
+        for (auto &[number, cpus]: found) { nodes.push_back(std::move(cpus)); }
+        if (nodes.empty()) { nodes.emplace_back(); }
+        return nodes;
+    }
+
+    auto milliseconds_until(const std::chrono::steady_clock::time_point deadline) -> int {
+        const auto left = std::chrono::duration_cast<std::chrono::milliseconds>(
+            deadline - std::chrono::steady_clock::now()).count();
+        return static_cast<int>(std::clamp<std::int64_t>(left, 0, std::numeric_limits<int>::max()));
+    }
+
+    // running if everything was written
+    auto send_all(const int fd, const std::string_view data, const std::chrono::steady_clock::time_point deadline)
+        -> shard_pool::shard_state {
+        for (std::size_t sent = 0; sent < data.size();) {
+            const auto n = send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL | MSG_DONTWAIT);
+            if (n > 0) {
+                sent += static_cast<std::size_t>(n);
+                continue;
+            }
+            if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                return shard_pool::shard_state::crashed;
+            }
+            pollfd writable{fd, POLLOUT, 0};
+            if (poll(&writable, 1, milliseconds_until(deadline)) == 0) { return shard_pool::shard_state::timed_out; }
+        }
+        return shard_pool::shard_state::running;
+    }
+}
+
+shard_pool::shard_pool(options opts) : opts(std::move(opts)), nodes(read_nodes()) {
+    if (access(this->opts.server.c_str(), X_OK) != 0) {
+        throw std::invalid_argument(std::format("Cannot run the server {}!", this->opts.server));
+    }
+    shards.resize(std::max<std::size_t>(1, this->opts.shards));
+    for (std::size_t i = 0; i < shards.size(); ++i) {
+        try {
+            spawn(shards[i], i);
+        } catch (...) {
+            shards.resize(i);
+            throw;
+        }
+    }
+}
+
+// a worker exits once its socket closes, destroying its instances and unlinking their frames as it goes
+shard_pool::~shard_pool() {
+    instances.clear();
+    for (const auto &s: shards) {
+        if (s.state == shard_state::running) { close(s.fd); }
+    }
+    for (const auto &s: shards) {
+        if (s.state == shard_state::running) { waitpid(s.pid, nullptr, 0); }
+    }
+}
+
+void shard_pool::spawn(shard &target, const std::size_t index) {
+    int pair[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, pair) != 0) {
+        throw std::runtime_error("Failed to create a socket pair for a shard!");
+    }
+    // only the worker's end survives exec, as its --fd
+    fcntl(pair[0], F_SETFD, FD_CLOEXEC);
+
+    // everything the child needs is built before the fork, after it only async-signal-safe calls are allowed
+    auto fd_arg = std::to_string(pair[1]);
+    auto cpf_arg = std::to_string(opts.cycles_per_frame);
+    std::string fd_flag{"--fd"};
+    std::string cpf_flag{"--cpf"};
+    std::array<char *, 6> argv{opts.server.data(), fd_flag.data(), fd_arg.data(), cpf_flag.data(), cpf_arg.data(),
+                               nullptr};
+    const auto pin = opts.pin && nodes.size() > 1;
+    const auto node = pin ? index % nodes.size() : 0;
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    for (const auto cpu: nodes[node]) { CPU_SET(cpu, &cpus); }
+
+    const auto pid = fork();
+    if (pid == 0) {
+        if (pin) { sched_setaffinity(0, sizeof(cpus), &cpus); }
+        execv(argv[0], argv.data());
+        _exit(127);
+    }
+    close(pair[1]);
+    if (pid < 0) {
+        close(pair[0]);
+        throw std::runtime_error("Failed to start a shard!");
+    }
+    target = {pid, pair[0], node};
+}
+
+auto shard_pool::exchange(const std::vector<std::string> &batches, const std::vector<std::size_t> &lines)
+    -> std::vector<std::vector<std::string>> {
+    std::vector<std::vector<std::string>> replies(shards.size());
+    const auto deadline = std::chrono::steady_clock::now() + opts.timeout;
+    // every batch goes out before any reply is read, so the shards work at the same time
+    for (std::size_t i = 0; i < shards.size(); ++i) {
+        if (batches[i].empty() || shards[i].state != shard_state::running) { continue; }
+        if (const auto state = send_all(shards[i].fd, batches[i], deadline); state != shard_state::running) {
+            take_down(shards[i], state);
+        }
+    }
+
+    std::vector<pollfd> fds;
+    std::vector<std::size_t> owners;
+    while (true) {
+        fds.clear();
+        owners.clear();
+        for (std::size_t i = 0; i < shards.size(); ++i) {
+            if (shards[i].state == shard_state::running && replies[i].size() < lines[i]) {
+                fds.push_back({shards[i].fd, POLLIN, 0});
+                owners.push_back(i);
+            }
+        }
+        if (fds.empty()) { break; }
+        const auto ready = poll(fds.data(), fds.size(), milliseconds_until(deadline));
+        if (ready < 0 && errno == EINTR) { continue; }
+        if (ready <= 0) {
+            for (const auto owner: owners) { take_down(shards[owner], shard_state::timed_out); }
+            break;
+        }
+        for (std::size_t k = 0; k < fds.size(); ++k) {
+            if (fds[k].revents == 0) { continue; }
+            auto &s = shards[owners[k]];
+            char buffer[16384];
+            const auto received = recv(s.fd, buffer, sizeof(buffer), 0);
+            if (received <= 0) {
+                take_down(s, shard_state::crashed);
+                continue;
+            }
+            s.input.append(buffer, static_cast<std::size_t>(received));
+            std::size_t start = 0;
+            for (auto end = s.input.find('\n'); end != std::string::npos; end = s.input.find('\n', start)) {
+                replies[owners[k]].emplace_back(s.input, start, end - start);
+                start = end + 1;
+            }
+            s.input.erase(0, start);
+        }
+    }
+    return replies;
+}
+
+auto shard_pool::request(const std::size_t shard_index, const std::string_view command) -> std::string {
+    std::vector<std::string> batches(shards.size());
+    std::vector<std::size_t> lines(shards.size());
+    batches[shard_index] = std::format("{}\n", command);
+    lines[shard_index] = 1;
+    auto replies = exchange(batches, lines);
+    if (replies[shard_index].empty()) {
+        throw std::runtime_error(std::format("Shard {} {}!", shard_index,
+                                             shard_state_strings[static_cast<std::size_t>(
+                                                 shards[shard_index].state)]));
+    }
+    auto &reply = replies[shard_index].front();
+    if (reply.starts_with("err ")) { throw std::invalid_argument(reply.substr(4)); }
+    return std::move(reply);
+}
+
+void shard_pool::take_down(shard &target, const shard_state state) {
+    if (target.state != shard_state::running) { return; }
+    kill(target.pid, SIGKILL);
+    waitpid(target.pid, nullptr, 0);
+    close(target.fd);
+    target.pid = -1;
+    target.fd = -1;
+    target.state = state;
+    target.input.clear();
+    // the worker never got to unlink its frames
+    const auto index = static_cast<std::size_t>(&target - shards.data());
+    for (auto &inst: instances) {
+        if (inst.shard != index || inst.lost) { continue; }
+        inst.lost = true;
+        inst.frame.reset();
+        shm_unlink(inst.shm_name.c_str());
+    }
+}
+
+void shard_pool::create(instance &target) {
+    // ok <id> <shm name>
+    std::istringstream created(request(target.shard, std::format("create {} {}",
+                                                                 VARIANT_NAMES[static_cast<std::size_t>(
+                                                                     target.variant)], target.seed)));
+    std::string status;
+    created >> status >> target.id >> target.shm_name;
+    try {
+        request(target.shard, std::format("load {} {}", target.id, target.rom));
+    } catch (const std::invalid_argument &) {
+        request(target.shard, std::format("destroy {}", target.id));
+        throw;
+    }
+    target.frame = std::make_unique<shared_frame_reader>(target.shm_name);
+    target.halted = false;
+    target.lost = false;
+    target.keys_changed = target.keys != 0;
+}
+
+auto shard_pool::add(const std::string &rom, const chip8::variant variant, const std::uint32_t seed) -> std::size_t {
+    const auto least = std::ranges::min_element(shards, {}, [](const shard &s) {
+        return s.state == shard_state::running ? s.instances : std::numeric_limits<std::size_t>::max();
+    });
+    if (least == shards.end() || least->state != shard_state::running) {
+        throw std::runtime_error("No shard is running!");
+    }
+    instance target{rom, variant, seed, static_cast<std::size_t>(least - shards.begin())};
+    create(target);
+    ++least->instances;
+    instances.push_back(std::move(target));
+    return instances.size() - 1;
+}
+
+void shard_pool::set_keys(const std::size_t index, const std::uint16_t keys) {
+    auto &target = instances[index];
+    target.keys_changed |= target.keys != keys;
+    target.keys = keys;
+}
+
+void shard_pool::run(const std::uint64_t frames) {
+    static constexpr auto NO_INSTANCE = std::numeric_limits<std::size_t>::max();
+    std::vector<std::string> batches(shards.size());
+    std::vector<std::size_t> lines(shards.size());
+    // the instance each reply answers for, keys replies carry nothing
+    std::vector<std::vector<std::size_t>> order(shards.size());
+    for (std::size_t i = 0; i < instances.size(); ++i) {
+        auto &inst = instances[i];
+        if (inst.lost || inst.halted) { continue; }
+        auto &batch = batches[inst.shard];
+        if (inst.keys_changed) {
+            batch += std::format("keys {} {:x}\n", inst.id, inst.keys);
+            order[inst.shard].push_back(NO_INSTANCE);
+            inst.keys_changed = false;
+        }
+        batch += std::format("run {} {}\n", inst.id, frames);
+        order[inst.shard].push_back(i);
+    }
+    for (std::size_t s = 0; s < shards.size(); ++s) { lines[s] = order[s].size(); }
+
+    const auto replies = exchange(batches, lines);
+    for (std::size_t s = 0; s < shards.size(); ++s) {
+        for (std::size_t k = 0; k < replies[s].size(); ++k) {
+            if (order[s][k] == NO_INSTANCE) { continue; }
+            // ok <budget|halted> <cycles>
+            std::istringstream words(replies[s][k]);
+            std::string status;
+            std::string reason;
+            std::uint64_t cycles{};
+            words >> status >> reason >> cycles;
+            if (status != "ok") { continue; }
+            instances[order[s][k]].halted = reason == "halted";
+            shards[s].cycles += cycles;
+        }
+    }
+}
+
+void shard_pool::restart(const std::size_t shard_index) {
+    auto &target = shards[shard_index];
+    if (target.state == shard_state::running) { return; }
+    const auto count = target.instances;
+    spawn(target, shard_index);
+    target.instances = count;
+    for (auto &inst: instances) {
+        if (inst.shard == shard_index && inst.lost) { create(inst); }
+    }
+}
@@ -0,0 +1,123 @@
+#pragma once
+
+#include "chip8.hpp"
+#include "shared_frame.hpp"
+
+#include <sys/types.h>
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// A fleet of instances split into shards, each owned by a mic8_server.elf worker process that talks to the pool over
+// a socket pair and publishes its frames to shared memory. A worker that crashes, or takes longer than the timeout
+// to answer, is killed and only its own instances are lost. Workers are spread over the NUMA nodes, pinned to the
+// CPUs of one node each so their instances live in that node's memory. Linux only, like the server.
+class shard_pool {
+public:
+    struct options {
+        std::string server{"./mic8_server.elf"};
+        std::size_t shards{1};
+        std::uint64_t cycles_per_frame{1000};
+        std::chrono::milliseconds timeout{5000};
+        bool pin{true};
+    };
+
+    enum class shard_state : unsigned char {
+        running,
+        crashed,
+        timed_out
+    };
+
+    static inline constexpr std::array<const char *, 3> shard_state_strings = {"running", "crashed", "timed out"};
+
+    struct shard {
+        pid_t pid{-1};
+        int fd{-1};
+        // index into the node list, or 0 when the machine has a single node or pinning is off
+        std::size_t node{};
+        shard_state state{shard_state::running};
+        std::size_t instances{};
+        std::uint64_t cycles{};
+        // replies received but not yet read as whole lines
+        std::string input;
+    };
+
+    struct instance {
+        std::string rom;
+        chip8::variant variant;
+        std::uint32_t seed;
+        std::size_t shard;
+        // the worker's id for it
+        std::uint64_t id{};
+        std::string shm_name;
+        std::unique_ptr<shared_frame_reader> frame;
+        std::uint16_t keys{};
+        bool keys_changed{};
+        bool halted{};
+        // its shard went down, it comes back from power on when the shard is restarted
+        bool lost{};
+    };
+
+    // starts the workers, throws if the server cannot be started
+    explicit shard_pool(options opts);
+
+    ~shard_pool();
+
+    shard_pool(const shard_pool &) = delete;
+
+    auto operator=(const shard_pool &) -> shard_pool & = delete;
+
+    // loads the ROM on the running shard with the fewest instances and returns the instance's index, throws if no
+    // shard is running or the ROM does not load
+    auto add(const std::string &rom, chip8::variant variant, std::uint32_t seed) -> std::size_t;
+
+    // bit n set while key n is down, sent with the next run
+    void set_keys(std::size_t index, std::uint16_t keys);
+
+    // runs every live instance that has not halted for the given frames, all shards in parallel with one write each
+    void run(std::uint64_t frames);
+
+    // replaces a shard that went down with a new worker and recreates its instances from power on
+    void restart(std::size_t shard_index);
+
+    // reads an instance's frame in place, false if it is lost or the frame could not be read consistently
+    template<typename F>
+    auto read_frame(const std::size_t index, F &&use) const -> bool {
+        const auto &target = instances[index];
+        return !target.lost && target.frame && target.frame->read(use);
+    }
+
+    [[nodiscard]] constexpr auto get_shards() const -> const std::vector<shard> & { return shards; }
+
+    [[nodiscard]] constexpr auto get_instances() const -> const std::vector<instance> & { return instances; }
+
+    // the CPUs of each NUMA node, a single empty entry when there is no node information
+    [[nodiscard]] constexpr auto get_nodes() const -> const std::vector<std::vector<int>> & { return nodes; }
+
+private:
+    options opts;
+    std::vector<std::vector<int>> nodes;
+    std::vector<shard> shards;
+    std::vector<instance> instances;
+
+    void spawn(shard &target, std::size_t index);
+
+    // sends one batch to each shard that has one and collects lines[i] replies from shard i, shards that fail are
+    // taken down and get no replies
+    auto exchange(const std::vector<std::string> &batches, const std::vector<std::size_t> &lines)
+        -> std::vector<std::vector<std::string>>;
+
+    // a single command on a single shard, throws if the shard went down or answered with an error
+    auto request(std::size_t shard_index, std::string_view command) -> std::string;
+
+    void take_down(shard &target, shard_state state);
+
+    // creates and loads an instance on its shard, which must be running
+    void create(instance &target);
+};
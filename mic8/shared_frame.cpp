@@ -0,0 +1,76 @@
+#include "shared_frame.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <format>
+#include <new>
+#include <stdexcept>
+
+shared_frame_writer::shared_frame_writer(const std::string_view name) : name(name) {
+    const int fd = shm_open(this->name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0) { throw std::runtime_error(std::format("Failed to create the shared memory {}!", name)); }
+    void *map = MAP_FAILED;
+    if (ftruncate(fd, sizeof(shared_frame)) == 0) {
+        map = mmap(nullptr, sizeof(shared_frame), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    close(fd);
+    if (map == MAP_FAILED) {
+        shm_unlink(this->name.c_str());
+        throw std::runtime_error(std::format("Failed to map the shared memory {}!", name));
+    }
+    region = new(map) shared_frame{shared_frame::MAGIC, shared_frame::VERSION};
+}
+
+shared_frame_writer::~shared_frame_writer() {
+    munmap(region, sizeof(shared_frame));
+    shm_unlink(name.c_str());
+}
+
+// seqlock write side, only ever called from the thread that owns the instance
+void shared_frame_writer::publish(const chip8 &interpreter, const std::uint64_t frame, const std::uint64_t cycles) {
+    const auto sequence = region->sequence.load(std::memory_order_relaxed);
+    region->sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    region->frame = frame;
+    region->cycles = cycles;
+    std::ranges::copy(interpreter.get_fb(), region->fb.begin());
+    std::ranges::copy(interpreter.get_stack(), region->stack.begin());
+    std::ranges::copy(interpreter.get_reg(), region->reg.begin());
+    region->pc = interpreter.get_pc();
+    region->ir = interpreter.get_ir();
+    std::uint16_t keys = 0;
+    for (std::size_t key = 0; key < chip8::KEY_COUNT; ++key) {
+        if (interpreter.keys[key]) { keys |= static_cast<std::uint16_t>(1u << key); }
+    }
+    region->keys = keys;
+    region->sp = interpreter.get_sp();
+    region->dt = interpreter.get_dt();
+    region->st = interpreter.get_st();
+    region->planes = interpreter.get_planes();
+    region->flags = static_cast<std::uint8_t>((interpreter.get_hires() ? shared_frame::FLAG_HIRES : 0u) |
+                                              (interpreter.get_halt_flag() ? shared_frame::FLAG_HALTED : 0u));
+
+    region->sequence.store(sequence + 2, std::memory_order_release);
+}
+
+shared_frame_reader::shared_frame_reader(const std::string_view name) {
+    const std::string path(name);
+    const int fd = shm_open(path.c_str(), O_RDONLY, 0);
+    if (fd < 0) { throw std::runtime_error(std::format("Failed to open the shared memory {}!", name)); }
+    const auto map = mmap(nullptr, sizeof(shared_frame), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) { throw std::runtime_error(std::format("Failed to map the shared memory {}!", name)); }
+    region = static_cast<const shared_frame *>(map);
+    if (region->magic != shared_frame::MAGIC || region->version != shared_frame::VERSION) {
+        munmap(map, sizeof(shared_frame));
+        throw std::invalid_argument(std::format("{} is not a mic8 frame of version {}!", name,
+                                                shared_frame::VERSION));
+    }
+}
+
+shared_frame_reader::~shared_frame_reader() { munmap(const_cast<shared_frame *>(region), sizeof(shared_frame)); }
@@ -0,0 +1,104 @@
+#pragma once
+
+#include "chip8.hpp"
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+
+// The region an instance publishes under /dev/shm, in native byte order so other processes can map it directly.
+// Readers never block the writer: load sequence, read what they need in place, then load sequence again and retry
+// if it was odd (a write was in progress) or has changed.
+struct shared_frame {
+    static constexpr std::uint32_t MAGIC{0x3843'494D}; // "MIC8"
+    static constexpr std::uint32_t VERSION{1};
+    static constexpr std::uint8_t FLAG_HIRES{1u << 0u};
+    static constexpr std::uint8_t FLAG_HALTED{1u << 1u};
+
+    std::uint32_t magic;
+    std::uint32_t version;
+    std::atomic<std::uint64_t> sequence;
+    // timer ticks and cycles since the instance was created
+    std::uint64_t frame;
+    std::uint64_t cycles;
+    std::array<chip8::plane_t, chip8::PLANE_COUNT> fb;
+    std::array<std::uint16_t, chip8::STACK_SIZE> stack;
+    std::array<std::uint8_t, chip8::REG_COUNT> reg;
+    std::uint16_t pc;
+    std::uint16_t ir;
+    // bit n set while key n is down
+    std::uint16_t keys;
+    std::uint8_t sp;
+    std::uint8_t dt;
+    std::uint8_t st;
+    std::uint8_t planes;
+    std::uint8_t flags;
+};
+
+static_assert(std::is_standard_layout_v<shared_frame>);
+static_assert(std::atomic<std::uint64_t>::is_always_lock_free);
+// consumers hard-code these offsets, bump VERSION when they change
+static_assert(offsetof(shared_frame, sequence) == 8);
+static_assert(offsetof(shared_frame, fb) == 32);
+static_assert(offsetof(shared_frame, stack) == 2080);
+static_assert(offsetof(shared_frame, reg) == 2112);
+static_assert(offsetof(shared_frame, pc) == 2128);
+static_assert(offsetof(shared_frame, flags) == 2138);
+
+// owns a POSIX shared memory object for as long as the instance lives, unlinking it on destruction
+class shared_frame_writer {
+public:
+    explicit shared_frame_writer(std::string_view name);
+
+    ~shared_frame_writer();
+
+    shared_frame_writer(const shared_frame_writer &) = delete;
+
+    auto operator=(const shared_frame_writer &) -> shared_frame_writer & = delete;
+
+    void publish(const chip8 &interpreter, std::uint64_t frame, std::uint64_t cycles);
+
+    [[nodiscard]] auto get_name() const -> const std::string & { return name; }
+
+private:
+    std::string name;
+    shared_frame *region{};
+};
+
+// maps another process's region read-only, throws unless it exists and is a shared_frame of this VERSION
+class shared_frame_reader {
+public:
+    explicit shared_frame_reader(std::string_view name);
+
+    ~shared_frame_reader();
+
+    shared_frame_reader(const shared_frame_reader &) = delete;
+
+    auto operator=(const shared_frame_reader &) -> shared_frame_reader & = delete;
+
+    // seqlock read side: calls use(const shared_frame &) until it ran with no write landing in between, so it
+    // should only copy. Gives up and returns false if a write never finishes, as when the writer died mid-frame.
+    template<typename F>
+    auto read(F &&use) const -> bool {
+        for (int attempt = 0; attempt < MAX_ATTEMPTS; ++attempt) {
+            const auto before = region->sequence.load(std::memory_order_acquire);
+            if ((before & 1u) == 0) {
+                use(*region);
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (region->sequence.load(std::memory_order_relaxed) == before) { return true; }
+            }
+            std::this_thread::yield();
+        }
+        return false;
+    }
+
+private:
+    static constexpr int MAX_ATTEMPTS{1000};
+
+    const shared_frame *region{};
+};
@@ -0,0 +1,84 @@
+#!/usr/bin/env python3
+# Minimal consumer of mic8_server.elf: drives an instance over the control socket and reads its frames straight
+# out of shared memory. Usage: shm_client.py <socket> <rom> [frames] [variant]
+import mmap
+import socket
+import struct
+import sys
+
+# offsets from shared_frame.hpp
+SEQUENCE = 8
+FRAME = 16
+FB = 32
+ROW_WORDS = 2
+PLANE_WORDS = 128
+PC = 2128
+FLAGS = 2138
+FLAG_HIRES = 1
+SIZE = 2144
+
+
+class Client:
+    def __init__(self, path):
+        self.sock = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+        self.sock.connect(path)
+        self.buffer = b""
+
+    # sends every command in one write and waits for all the replies
+    def batch(self, *commands):
+        self.sock.sendall("".join(command + "\n" for command in commands).encode())
+        replies = []
+        while len(replies) < len(commands):
+            while b"\n" not in self.buffer:
+                received = self.sock.recv(4096)
+                if not received:
+                    raise ConnectionError("the server closed the connection")
+                self.buffer += received
+            line, self.buffer = self.buffer.split(b"\n", 1)
+            replies.append(line.decode())
+        for reply in replies:
+            if not reply.startswith("ok"):
+                raise RuntimeError(reply)
+        return replies
+
+
+def read_frame(region):
+    # seqlock read: retry while a write is in progress or one landed in between
+    while True:
+        before, = struct.unpack_from("=Q", region, SEQUENCE)
+        if before & 1:
+            continue
+        frame, = struct.unpack_from("=Q", region, FRAME)
+        plane = struct.unpack_from(f"={PLANE_WORDS}Q", region, FB)
+        pc, = struct.unpack_from("=H", region, PC)
+        flags = region[FLAGS]
+        if struct.unpack_from("=Q", region, SEQUENCE)[0] == before:
+            return frame, pc, flags, plane
+
+
+def render(plane, hires):
+    width, height = (128, 64) if hires else (64, 32)
+    rows = []
+    for y in range(0, height, 2):
+        row = ""
+        for x in range(width):
+            # the most significant bit of a row's first word is its leftmost pixel
+            top = plane[y * ROW_WORDS + x // 64] >> (63 - x % 64) & 1
+            bottom = plane[(y + 1) * ROW_WORDS + x // 64] >> (63 - x % 64) & 1
+            row += " ▀▄█"[top | bottom << 1]
+        rows.append(row)
+    return "\n".join(rows)
+
+
+if __name__ == "__main__":
+    client = Client(sys.argv[1])
+    frames = sys.argv[3] if len(sys.argv) > 3 else "60"
+    variant = sys.argv[4] if len(sys.argv) > 4 else "chip8"
+    instance, name = client.batch(f"create {variant}")[0].split()[1:]
+    client.batch(f"load {instance} {sys.argv[2]}", f"run {instance} {frames}")
+    with open("/dev/shm" + name, "rb") as f:
+        region = mmap.mmap(f.fileno(), SIZE, prot=mmap.PROT_READ)
+    frame, pc, flags, plane = read_frame(region)
+    print(render(plane, flags & FLAG_HIRES))
+    print(f"frame {frame} pc {pc:03X}")
+    print(client.batch(f"snapshot {instance}", f"destroy {instance}")[0])
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <span>
+
+template<typename T, std::size_t N>
+class spsc_ring {
+    static_assert((N & (N - 1)) == 0, "ring capacity must be a power of two");
+
+public:
+    [[nodiscard]] auto size() const -> std::size_t {
+        return write_pos.load(std::memory_order_acquire) - read_pos.load(std::memory_order_acquire);
+    }
+
+    auto push(const std::span<const T> items) -> std::size_t {
+        const auto write = write_pos.load(std::memory_order_relaxed);
+        const auto read = read_pos.load(std::memory_order_acquire);
+        const auto count = std::min(items.size(), N - (write - read));
+        for (std::size_t i = 0; i < count; ++i) {
+            buffer[(write + i) & (N - 1)] = items[i];
+        }
+        write_pos.store(write + count, std::memory_order_release);
+        return count;
+    }
+
+    // fill(T &) writes the next item in place, returns false without calling it when the ring is full
+    template<typename F>
+    auto produce(F &&fill) -> bool {
+        const auto write = write_pos.load(std::memory_order_relaxed);
+        if (write - read_pos.load(std::memory_order_acquire) == N) { return false; }
+        fill(buffer[write & (N - 1)]);
+        write_pos.store(write + 1, std::memory_order_release);
+        return true;
+    }
+
+    // use(const T &) reads the oldest item in place, returns false without calling it when the ring is empty
+    template<typename F>
+    auto consume(F &&use) -> bool {
+        const auto read = read_pos.load(std::memory_order_relaxed);
+        if (read == write_pos.load(std::memory_order_acquire)) { return false; }
+        use(static_cast<const T &>(buffer[read & (N - 1)]));
+        read_pos.store(read + 1, std::memory_order_release);
+        return true;
+    }
+
+    auto pop(const std::span<T> items) -> std::size_t {
+        const auto read = read_pos.load(std::memory_order_relaxed);
+        const auto write = write_pos.load(std::memory_order_acquire);
+        const auto count = std::min(items.size(), write - read);
+        for (std::size_t i = 0; i < count; ++i) {
+            items[i] = buffer[(read + i) & (N - 1)];
+        }
+        read_pos.store(read + count, std::memory_order_release);
+        return count;
+    }
+
+private:
+    alignas(64) std::atomic<std::size_t> write_pos{};
+    alignas(64) std::atomic<std::size_t> read_pos{};
+    alignas(64) std::array<T, N> buffer{};
+};
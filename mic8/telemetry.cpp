@@ -0,0 +1,60 @@
+#include "telemetry.hpp"
+
+#include <filesystem>
+#include <format>
+#include <stdexcept>
+#include <string>
+
+void instance_telemetry::sample(const std::chrono::duration<double> elapsed) {
+    const auto seconds = elapsed.count();
+    if (seconds <= 0) { return; }
+    last.ips = static_cast<double>(cycles) / seconds;
+    last.draws_per_second = static_cast<double>(draws) / seconds;
+    last.run_percent = std::chrono::duration<double>(run_time).count() / seconds * 100;
+    last.wait_percent = batches == 0 ? 0 : static_cast<double>(waits) / static_cast<double>(batches) * 100;
+    last.throttle_percent = batches + throttled == 0 ? 0 : static_cast<double>(throttled) /
+                                                           static_cast<double>(batches + throttled) * 100;
+    cycles = 0;
+    draws = 0;
+    batches = 0;
+    waits = 0;
+    throttled = 0;
+    run_time = {};
+}
+
+telemetry_writer::telemetry_writer(const std::string_view path)
+    : file(path.data()), fmt(std::filesystem::path(path).extension() == ".csv" ? format::csv : format::json) {
+    if (!file) {
+        throw std::invalid_argument("Failed to open the telemetry file!");
+    }
+    if (fmt == format::csv) {
+        file << "time,id,state,target_ips,ips,behind,draws_per_second,run_percent,wait_percent,throttle_percent\n";
+    }
+}
+
+void telemetry_writer::write(const std::span<const telemetry_row> rows, const telemetry_row &totals) {
+    const std::chrono::duration<double> time = std::chrono::steady_clock::now() - start_time;
+    if (fmt == format::csv) {
+        const auto write_row = [&](const std::string &id, const telemetry_row &row) {
+            file << std::format("{:.3f},{},{},{:.0f},{:.0f},{},{:.2f},{:.2f},{:.2f},{:.2f}\n", time.count(), id,
+                                row.state, row.target_ips, row.rates.ips, row.behind, row.rates.draws_per_second,
+                                row.rates.run_percent, row.rates.wait_percent, row.rates.throttle_percent);
+        };
+        for (const auto &row: rows) { write_row(std::to_string(row.id), row); }
+        write_row("total", totals);
+    } else {
+        const auto fields = [](const telemetry_row &row) {
+            return std::format(R"("target_ips":{:.0f},"ips":{:.0f},"behind":{},"draws_per_second":{:.2f},)"
+                               R"("run_percent":{:.2f},"wait_percent":{:.2f},"throttle_percent":{:.2f})",
+                               row.target_ips, row.rates.ips, row.behind, row.rates.draws_per_second,
+                               row.rates.run_percent, row.rates.wait_percent, row.rates.throttle_percent);
+        };
+        file << std::format(R"({{"time":{:.3f},"instances":[)", time.count());
+        for (std::size_t i = 0; i < rows.size(); ++i) {
+            file << std::format(R"({}{{"id":{},"state":"{}",{}}})", i == 0 ? "" : ",", rows[i].id, rows[i].state,
+                                fields(rows[i]));
+        }
+        file << std::format(R"(],"totals":{{"instances":{},{}}}}})", totals.id, fields(totals)) << '\n';
+    }
+    file.flush();
+}
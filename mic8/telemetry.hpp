@@ -0,0 +1,73 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <span>
+#include <string_view>
+
+// Counters an instance accumulates while it runs, turned into rates once per sample so the Instance Manager can
+// compare instances at a glance.
+struct instance_telemetry {
+    struct rates {
+        double ips{};
+        double draws_per_second{};
+        // share of wall time spent inside run
+        double run_percent{};
+        // share of scheduled batches cut short because the ROM waited on a key or halted
+        double wait_percent{};
+        // share of due batches held back because the scheduler ran out of time or the instance hit its CPU limit
+        double throttle_percent{};
+    };
+
+    // since the last sample
+    std::uint64_t cycles{};
+    std::uint64_t draws{};
+    std::uint64_t batches{};
+    std::uint64_t waits{};
+    std::uint64_t throttled{};
+    std::chrono::nanoseconds run_time{};
+
+    // the batch now due has been held back at least once, so it is only counted once however long it waits
+    bool held_back{};
+
+    // cycles the schedule asked for but the main loop woke too late to run, since the instance was created
+    std::uint64_t behind{};
+
+    rates last;
+
+    // turns the counters into last and clears them
+    void sample(std::chrono::duration<double> elapsed);
+};
+
+// one instance in an export, or the totals over all of them
+struct telemetry_row {
+    std::size_t id;
+    std::string_view state;
+    double target_ips;
+    instance_telemetry::rates rates;
+    std::uint64_t behind;
+};
+
+// Appends samples to a file: one JSON object per line, or CSV rows with a header, depending on the extension
+class telemetry_writer {
+public:
+    enum class format : unsigned char {
+        json,
+        csv
+    };
+
+    // throws if the file cannot be opened
+    explicit telemetry_writer(std::string_view path);
+
+    // rows stamped with the seconds since the writer was opened, followed by totals whose id is the instance count
+    void write(std::span<const telemetry_row> rows, const telemetry_row &totals);
+
+    [[nodiscard]] constexpr auto get_format() const -> format { return fmt; }
+
+private:
+    std::ofstream file;
+    format fmt;
+    std::chrono::time_point<std::chrono::steady_clock> start_time{std::chrono::steady_clock::now()};
+};
@@ -0,0 +1,337 @@
+#include "chip8.hpp"
+#include "headless.hpp"
+#include "shared_frame.hpp"
+#include "text_screen.hpp"
+
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <format>
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace {
+    using clock = std::chrono::steady_clock;
+
+    // the timers tick at 60 Hz, instances run one frame per tick
+    constexpr auto FRAME_INTERVAL = std::chrono::microseconds(16'667);
+    // frames run back to back after a stall before the rest are dropped
+    constexpr int MAX_CATCH_UP{4};
+
+    // the keypad as the GUI lays it out on a QWERTY keyboard
+    //@formatter:off
+    constexpr std::array<char, chip8::KEY_COUNT> key_map{
+            'x', '1', '2', '3', 'q', 'w', 'e', 'a', 's', 'd', 'z', 'c', '4', 'r', 'f', 'v'
+    };
+    //@formatter:on
+
+    struct options {
+        text_screen::glyphs glyphs{text_screen::glyphs::half};
+        std::uint64_t cycles_per_frame{20};
+        std::uint64_t fps{30};
+        std::chrono::milliseconds hold{250};
+        std::uint32_t seed{1};
+        std::optional<chip8::variant> variant;
+        std::vector<std::string> watch;
+        std::vector<std::string> paths;
+    };
+
+    volatile std::sig_atomic_t stop_requested{};
+
+    auto parse_options(const std::span<char *> args) -> options {
+        options opts;
+        for (std::size_t i = 1; i < args.size(); ++i) {
+            const std::string_view arg = args[i];
+            const auto value = [&] {
+                if (i + 1 >= args.size()) { throw std::invalid_argument(std::format("Missing value for {}", arg)); }
+                return std::string_view(args[++i]);
+            };
+            if (arg == "--glyphs") {
+                const auto name = value();
+                const auto it = std::ranges::find(text_screen::glyphs_strings, name);
+                if (it == text_screen::glyphs_strings.end()) {
+                    throw std::invalid_argument(std::format("Unknown glyphs: {}", name));
+                }
+                opts.glyphs = static_cast<text_screen::glyphs>(it - text_screen::glyphs_strings.begin());
+            } else if (arg == "--cpf") {
+                opts.cycles_per_frame = std::max<std::uint64_t>(1, headless::parse_number(value()));
+            } else if (arg == "--fps") {
+                opts.fps = std::clamp<std::uint64_t>(headless::parse_number(value()), 1, 60);
+            } else if (arg == "--hold") {
+                opts.hold = std::chrono::milliseconds(headless::parse_number(value()));
+            } else if (arg == "--seed") {
+                opts.seed = static_cast<std::uint32_t>(headless::parse_number(value()));
+            } else if (arg == "--variant") {
+                opts.variant = headless::parse_variant(value());
+            } else if (arg == "--watch") {
+                opts.watch.emplace_back(value());
+            } else if (arg.starts_with("--")) {
+                throw std::invalid_argument(std::format("Unknown option: {}", arg));
+            } else {
+                opts.paths.emplace_back(arg);
+            }
+        }
+        return opts;
+    }
+
+    // an instance run here from a ROM, or one another process publishes, which can only be watched
+    struct instance {
+        std::string name;
+        std::unique_ptr<chip8> interpreter;
+        std::unique_ptr<shared_frame_reader> reader;
+        // the size of its tile in pixels, a chip8 ROM never leaves low resolution
+        std::size_t width{chip8::HIRES_WIDTH};
+        std::size_t height{chip8::HIRES_HEIGHT};
+        // terminals only send presses, so a key counts as down until a while after its last press or repeat
+        std::array<clock::time_point, chip8::KEY_COUNT> held_until{};
+        // the last frame read from reader
+        std::array<chip8::plane_t, chip8::PLANE_COUNT> fb{};
+        bool hires{};
+        bool halted{};
+        bool lost{};
+    };
+
+    // one frame's cycles, then the timer tick
+    void run_frame(chip8 &interpreter, const std::uint64_t cycles_per_frame) {
+        for (std::uint64_t executed = 0; executed < cycles_per_frame && !interpreter.get_halt_flag();) {
+            executed += interpreter.run_cycles(cycles_per_frame - executed).cycles;
+        }
+        interpreter.decrement_timers();
+    }
+
+    void write_all(std::string_view text) {
+        while (!text.empty()) {
+            const auto n = write(STDOUT_FILENO, text.data(), text.size());
+            if (n < 0 && errno == EINTR) { continue; }
+            if (n <= 0) { return; }
+            text.remove_prefix(static_cast<std::size_t>(n));
+        }
+    }
+
+    // raw input and the alternate screen with the cursor hidden, for as long as it lives
+    class raw_terminal {
+    public:
+        raw_terminal() {
+            if (tcgetattr(STDIN_FILENO, &saved) != 0) { throw std::runtime_error("Standard input is not a terminal!"); }
+            termios raw = saved;
+            cfmakeraw(&raw);
+            raw.c_cc[VMIN] = 0;
+            raw.c_cc[VTIME] = 0;
+            tcsetattr(STDIN_FILENO, TCSAFLUSH, &raw);
+            write_all("\x1b[?1049h\x1b[?25l");
+        }
+
+        ~raw_terminal() {
+            write_all("\x1b[0m\x1b[?25h\x1b[?1049l");
+            tcsetattr(STDIN_FILENO, TCSAFLUSH, &saved);
+        }
+
+        raw_terminal(const raw_terminal &) = delete;
+
+        auto operator=(const raw_terminal &) -> raw_terminal & = delete;
+
+        // columns and rows, 80 by 24 if the terminal does not say
+        [[nodiscard]] static auto size() -> std::pair<std::size_t, std::size_t> {
+            winsize ws{};
+            if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &ws) != 0 || ws.ws_col == 0 || ws.ws_row == 0) { return {80, 24}; }
+            return {ws.ws_col, ws.ws_row};
+        }
+
+    private:
+        termios saved{};
+    };
+
+    // left to right in rows, each tile under its caption, as many as fit above the last line
+    auto place(const text_screen &screen, const std::vector<instance> &instances, const std::size_t columns,
+               const std::size_t rows) -> std::vector<text_screen::tile> {
+        std::vector<text_screen::tile> tiles;
+        std::size_t x = 0;
+        std::size_t y = 1;
+        std::size_t row_height = 0;
+        for (const auto &inst: instances) {
+            const auto w = screen.columns(inst.width);
+            const auto h = screen.rows(inst.height);
+            if (x > 0 && x + w > columns) {
+                x = 0;
+                y += row_height + 1;
+                row_height = 0;
+            }
+            if (x + w > columns || y + h >= rows) { break; }
+            tiles.push_back({x, y, inst.width, inst.height});
+            x += w + 1;
+            row_height = std::max(row_height, h);
+        }
+        return tiles;
+    }
+
+    // the next instance after from, or before it, that takes keys; from itself if none does
+    auto next_focus(const std::vector<instance> &instances, const std::size_t from, const bool forward)
+        -> std::size_t {
+        const auto count = instances.size();
+        for (std::size_t i = 1; i <= count; ++i) {
+            const auto next = forward ? (from + i) % count : (from + count - i) % count;
+            if (instances[next].interpreter) { return next; }
+        }
+        return from;
+    }
+}
+
+// shows instances in a terminal, for machines without a display: ROMs given on the command line run here and take
+// keys from the terminal, instances a server publishes are watched through their shared memory
+auto main(int argc, char *argv[]) -> int {
+    try {
+        const auto opts = parse_options(std::span(argv, static_cast<std::size_t>(argc)));
+        if (opts.paths.empty() && opts.watch.empty()) {
+            std::fputs("usage: mic8_term.elf [--glyphs half|braille] [--cpf n] [--fps n] [--hold ms] [--seed n] "
+                       "[--variant chip8|schip|xochip] [--watch shm name]... rom|dir...\n", stderr);
+            return 2;
+        }
+
+        std::vector<instance> instances;
+        std::uint32_t seed = opts.seed;
+        for (const auto &rom: headless::collect_roms(opts.paths)) {
+            chip8::alt_t alt_ops;
+            alt_ops.variant = opts.variant.value_or(headless::guess_variant(rom));
+            instance inst{rom.filename().string(), std::make_unique<chip8>(alt_ops)};
+            inst.interpreter->seed(seed++);
+            inst.interpreter->set_trace_id(static_cast<std::uint32_t>(instances.size()));
+            inst.interpreter->load_rom(rom.string());
+            if (alt_ops.variant == chip8::variant::chip8) {
+                inst.width = chip8::VIDEO_WIDTH;
+                inst.height = chip8::VIDEO_HEIGHT;
+            }
+            instances.push_back(std::move(inst));
+        }
+        for (const auto &name: opts.watch) {
+            instances.push_back({name, nullptr, std::make_unique<shared_frame_reader>(name)});
+        }
+        if (instances.empty()) { throw std::invalid_argument("No ROMs found!"); }
+
+        std::signal(SIGINT, [](int) { stop_requested = 1; });
+        std::signal(SIGTERM, [](int) { stop_requested = 1; });
+        std::signal(SIGHUP, [](int) { stop_requested = 1; });
+
+        const raw_terminal terminal;
+        text_screen screen(opts.glyphs);
+        std::size_t focus = instances.front().interpreter ? 0 : next_focus(instances, 0, true);
+        std::pair<std::size_t, std::size_t> size{};
+        std::size_t shown = 0;
+        std::string caption;
+
+        enum class input : unsigned char {
+            normal,
+            escape,
+            sequence
+        } parser{};
+        const auto handle = [&](const char c, const clock::time_point now) {
+            if (parser == input::escape) {
+                parser = c == '[' || c == 'O' ? input::sequence : input::normal;
+            } else if (parser == input::sequence) {
+                // a sequence ends at its first letter, shift-tab among them
+                if (c >= '@' && c <= '~') {
+                    if (c == 'Z') { focus = next_focus(instances, focus, false); }
+                    parser = input::normal;
+                }
+            } else if (c == '\x03' || c == '\x04') {
+                stop_requested = 1;
+            } else if (c == '\x1b') {
+                parser = input::escape;
+            } else if (c == '\t') {
+                focus = next_focus(instances, focus, true);
+            } else if (const auto it = std::ranges::find(key_map, std::tolower(static_cast<unsigned char>(c)));
+                       it != key_map.end() && instances[focus].interpreter) {
+                instances[focus].held_until[static_cast<std::size_t>(it - key_map.begin())] = now + opts.hold;
+            }
+        };
+
+        const auto refresh_interval = std::chrono::duration_cast<clock::duration>(std::chrono::seconds(1)) /
+                                      static_cast<clock::rep>(opts.fps);
+        auto next_frame = clock::now();
+        auto next_refresh = next_frame;
+        while (stop_requested == 0) {
+            pollfd fd{STDIN_FILENO, POLLIN, 0};
+            const auto wait = std::chrono::ceil<std::chrono::milliseconds>(std::min(next_frame, next_refresh) -
+                                                                           clock::now());
+            poll(&fd, 1, static_cast<int>(std::max<std::chrono::milliseconds::rep>(0, wait.count())));
+            auto now = clock::now();
+            if ((fd.revents & POLLIN) != 0) {
+                std::array<char, 256> buffer{};
+                const auto n = read(STDIN_FILENO, buffer.data(), buffer.size());
+                for (std::size_t i = 0; i < static_cast<std::size_t>(std::max<ssize_t>(0, n)); ++i) {
+                    handle(buffer[i], now);
+                }
+            }
+
+            for (int i = 0; i < MAX_CATCH_UP && now >= next_frame; ++i) {
+                for (auto &inst: instances) {
+                    if (!inst.interpreter) { continue; }
+                    for (std::size_t k = 0; k < chip8::KEY_COUNT; ++k) {
+                        inst.interpreter->keys[k] = now < inst.held_until[k];
+                    }
+                    run_frame(*inst.interpreter, opts.cycles_per_frame);
+                }
+                next_frame += FRAME_INTERVAL;
+            }
+            if (now >= next_frame) { next_frame = now + FRAME_INTERVAL; }
+            if (now < next_refresh) { continue; }
+            next_refresh = now + refresh_interval;
+
+            if (const auto current = raw_terminal::size(); current != size) {
+                size = current;
+                const auto tiles = place(screen, instances, size.first, size.second);
+                shown = tiles.size();
+                screen.layout(tiles);
+                std::string help{"Tab switches instance, keys 1-4 Q-R A-F Z-V, Ctrl-C quits"};
+                if (shown < instances.size()) { help += std::format("; {} do not fit", instances.size() - shown); }
+                help.resize(std::min(help.size(), size.first));
+                screen.text(0, size.second - 1, help);
+            }
+            for (std::size_t i = 0; i < shown; ++i) {
+                auto &inst = instances[i];
+                std::string_view state;
+                if (inst.interpreter) {
+                    inst.halted = inst.interpreter->get_halt_flag();
+                    state = inst.halted ? "halted" : "running";
+                } else {
+                    inst.lost = !inst.reader->read([&inst](const shared_frame &frame) {
+                        inst.fb = frame.fb;
+                        inst.hires = (frame.flags & shared_frame::FLAG_HIRES) != 0;
+                        inst.halted = (frame.flags & shared_frame::FLAG_HALTED) != 0;
+                    });
+                    state = inst.lost ? "lost" : inst.halted ? "halted" : "watching";
+                }
+                caption.clear();
+                std::format_to(std::back_inserter(caption), "{} {} {}", i, inst.name, state);
+                screen.caption(i, caption, inst.interpreter && i == focus);
+                if (inst.interpreter) {
+                    screen.draw(i, inst.interpreter->get_fb(), inst.interpreter->get_hires());
+                } else {
+                    screen.draw(i, inst.fb, inst.hires);
+                }
+            }
+            write_all(screen.output());
+        }
+        return 0;
+    } catch (const std::exception &e) {
+        std::fprintf(stderr, "%s\n", e.what());
+        return 2;
+    }
+}
@@ -0,0 +1,175 @@
+#include "text_screen.hpp"
+
+#include <algorithm>
+#include <format>
+#include <iterator>
+
+namespace {
+    // a cell packed into one word so rows compare cheaply: the code point in the low 21 bits, then the foreground
+    // and background colour numbers of the framebuffer
+    constexpr std::uint32_t NO_CELL{0xFFFF'FFFF};
+    constexpr std::uint32_t BLANK{' '};
+    constexpr std::uint32_t UPPER_HALF{0x2580};
+    constexpr std::uint32_t LOWER_HALF{0x2584};
+    constexpr std::uint32_t FULL_BLOCK{0x2588};
+    constexpr std::uint32_t BRAILLE{0x2800};
+
+    constexpr auto make_cell(const std::uint32_t code_point, const unsigned fg, const unsigned bg) -> std::uint32_t {
+        return code_point | fg << 24u | bg << 26u;
+    }
+
+    // colour 0 is the terminal's own background, the others match the GUI's palette as closely as 16 colours allow
+    //@formatter:off
+    constexpr std::array<unsigned, 4> fg_sgr{39, 97, 37, 90};
+    constexpr std::array<unsigned, 4> bg_sgr{49, 107, 47, 100};
+    // braille dot bits by pixel within the cell, column by column
+    constexpr std::array<std::array<unsigned, 4>, 2> braille_dots{{{0x01, 0x02, 0x04, 0x40}, {0x08, 0x10, 0x20, 0x80}}};
+    //@formatter:on
+
+    void append_utf8(std::string &out, const std::uint32_t code_point) {
+        if (code_point < 0x80) {
+            out += static_cast<char>(code_point);
+        } else if (code_point < 0x800) {
+            out += static_cast<char>(0xC0u | code_point >> 6u);
+            out += static_cast<char>(0x80u | (code_point & 0x3Fu));
+        } else {
+            out += static_cast<char>(0xE0u | code_point >> 12u);
+            out += static_cast<char>(0x80u | (code_point >> 6u & 0x3Fu));
+            out += static_cast<char>(0x80u | (code_point & 0x3Fu));
+        }
+    }
+
+    // moves the cursor to a cell, counting from 0
+    void move_to(std::string &out, const std::size_t column, const std::size_t row) {
+        std::format_to(std::back_inserter(out), "\x1b[{};{}H", row + 1, column + 1);
+    }
+
+    // the colour of pixel x, y of a tile width by height pixels wide showing fb
+    auto pixel(const std::span<const chip8::plane_t> fb, const bool hires, const std::size_t width,
+               const std::size_t height, const std::size_t x, const std::size_t y) -> unsigned {
+        const auto fb_width = hires ? chip8::HIRES_WIDTH : chip8::VIDEO_WIDTH;
+        const auto fb_height = hires ? chip8::HIRES_HEIGHT : chip8::VIDEO_HEIGHT;
+        const std::size_t col = x * fb_width / width;
+        const std::size_t row = y * fb_height / height;
+        const std::size_t word = row * chip8::ROW_WORDS + col / 64;
+        const std::size_t bit = 63 - col % 64;
+        return static_cast<unsigned>((fb[0][word] >> bit & 1u) | (fb[1][word] >> bit & 1u) << 1u);
+    }
+}
+
+auto text_screen::columns(const std::size_t width) const -> std::size_t {
+    return style == glyphs::half ? width : (width + 1) / 2;
+}
+
+auto text_screen::rows(const std::size_t height) const -> std::size_t {
+    return style == glyphs::half ? (height + 1) / 2 : (height + 3) / 4;
+}
+
+void text_screen::layout(const std::span<const tile> new_tiles) {
+    tiles.clear();
+    for (const auto &area: new_tiles) {
+        tiles.push_back({area, std::vector<std::uint32_t>(columns(area.width) * rows(area.height), NO_CELL)});
+    }
+    open = false;
+    clear = true;
+}
+
+auto text_screen::cell_at(const tile &area, const std::span<const chip8::plane_t> fb, const bool hires,
+                          const std::size_t x, const std::size_t y) const -> std::uint32_t {
+    const auto at = [&](const std::size_t px, const std::size_t py) {
+        return px < area.width && py < area.height ? pixel(fb, hires, area.width, area.height, px, py) : 0u;
+    };
+    if (style == glyphs::half) {
+        const auto top = at(x, y * 2);
+        const auto bottom = at(x, y * 2 + 1);
+        if (top == bottom) { return top == 0 ? make_cell(BLANK, 0, 0) : make_cell(FULL_BLOCK, top, 0); }
+        if (top == 0) { return make_cell(LOWER_HALF, bottom, 0); }
+        return make_cell(UPPER_HALF, top, bottom);
+    }
+    unsigned dots = 0;
+    unsigned colour = 0;
+    for (std::size_t dx = 0; dx < 2; ++dx) {
+        for (std::size_t dy = 0; dy < 4; ++dy) {
+            const auto c = at(x * 2 + dx, y * 4 + dy);
+            if (c != 0) { dots |= braille_dots[dx][dy]; }
+            colour = std::max(colour, c);
+        }
+    }
+    return dots == 0 ? make_cell(BLANK, 0, 0) : make_cell(BRAILLE + dots, colour, 0);
+}
+
+void text_screen::draw(const std::size_t index, const std::span<const chip8::plane_t> fb, const bool hires) {
+    auto &state = tiles[index];
+    if (state.drawn && state.hires == hires && std::ranges::equal(state.fb, fb)) { return; }
+    std::ranges::copy(fb, state.fb.begin());
+    state.hires = hires;
+    state.drawn = true;
+
+    const auto width = columns(state.area.width);
+    const auto height = rows(state.area.height);
+    row_cells.resize(width);
+    for (std::size_t y = 0; y < height; ++y) {
+        const std::span<std::uint32_t> sent(state.cells.data() + y * width, width);
+        for (std::size_t x = 0; x < width; ++x) { row_cells[x] = cell_at(state.area, fb, hires, x, y); }
+        const auto first = std::ranges::mismatch(row_cells, sent).in1;
+        if (first == row_cells.end()) { continue; }
+        const auto begin_x = static_cast<std::size_t>(first - row_cells.begin());
+        std::size_t end_x = width;
+        while (row_cells[end_x - 1] == sent[end_x - 1]) { --end_x; }
+
+        auto &out = begin();
+        move_to(out, state.area.column + begin_x, state.area.row + y);
+        std::uint32_t colours = NO_CELL;
+        for (auto x = begin_x; x < end_x; ++x) {
+            const auto cell = row_cells[x];
+            // colours only change where the screen does, a monochrome ROM sets them once per run of cells
+            if ((cell >> 24u) != colours) {
+                colours = cell >> 24u;
+                std::format_to(std::back_inserter(out), "\x1b[{};{}m", fg_sgr[colours & 3u], bg_sgr[colours >> 2u]);
+            }
+            append_utf8(out, cell & 0x1F'FFFFu);
+            sent[x] = cell;
+        }
+    }
+}
+
+void text_screen::caption(const std::size_t index, const std::string_view text, const bool highlight) {
+    auto &state = tiles[index];
+    line.assign(columns(state.area.width), ' ');
+    // shown byte for byte, anything outside printable ASCII could move the cursor
+    for (std::size_t i = 0; i < std::min(line.size(), text.size()); ++i) {
+        line[i] = text[i] >= ' ' && text[i] <= '~' ? text[i] : '?';
+    }
+    if (state.area.row == 0 || (line == state.caption && highlight == state.highlight)) { return; }
+    state.caption = line;
+    state.highlight = highlight;
+    auto &out = begin();
+    move_to(out, state.area.column, state.area.row - 1);
+    out += highlight ? "\x1b[0;7m" : "\x1b[0m";
+    out += line;
+}
+
+void text_screen::text(const std::size_t column, const std::size_t row, const std::string_view text) {
+    auto &out = begin();
+    move_to(out, column, row);
+    out += "\x1b[0m";
+    out += text;
+}
+
+auto text_screen::begin() -> std::string & {
+    if (!open) {
+        pending.clear();
+        pending += "\x1b[?2026h";
+        if (clear) { pending += "\x1b[0m\x1b[2J"; }
+        clear = false;
+        open = true;
+    }
+    return pending;
+}
+
+auto text_screen::output() -> std::string_view {
+    if (!open) { return {}; }
+    open = false;
+    pending += "\x1b[0m\x1b[?2026l";
+    return pending;
+}
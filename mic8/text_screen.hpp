@@ -0,0 +1,85 @@
+#pragma once
+
+#include "chip8.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Draws framebuffers as text, for terminals on machines without a display. Each tile shows one screen in a fixed
+// block of character cells: as half blocks, two pixels stacked in a cell in the screen's four colours, or as
+// braille, eight pixels to a cell in the brightest colour among them. The screen remembers every cell it sent and
+// only sends the cells from the first to the last change of each row that changed, so an idle instance costs nothing
+// to refresh and a moving sprite costs the rows it crosses. Escape sequences are VT100 with 16 colours.
+class text_screen {
+public:
+    enum class glyphs : unsigned char {
+        half,
+        braille
+    };
+
+    static inline constexpr std::array<const char *, 2> glyphs_strings = {"half", "braille"};
+
+    struct tile {
+        // top left cell of the screen, counting from 0; its caption goes on the row above
+        std::size_t column;
+        std::size_t row;
+        // the pixels it shows, a screen of another resolution is scaled to fit
+        std::size_t width;
+        std::size_t height;
+    };
+
+    explicit text_screen(glyphs style) : style(style) {}
+
+    // the cells a tile of width by height pixels takes, not counting its caption
+    [[nodiscard]] auto columns(std::size_t width) const -> std::size_t;
+    [[nodiscard]] auto rows(std::size_t height) const -> std::size_t;
+
+    // replaces the tiles and forgets what the terminal shows, so the next output clears it and draws everything
+    void layout(std::span<const tile> new_tiles);
+
+    // queues the cells of tile index that differ from what was sent, skipping the tile if fb has not changed
+    void draw(std::size_t index, std::span<const chip8::plane_t> fb, bool hires);
+
+    // queues a caption over tile index if it changed, cut or padded to the tile's width; highlighted in reverse video
+    void caption(std::size_t index, std::string_view text, bool highlight);
+
+    // queues text at a cell as is, for the parts of the screen outside the tiles
+    void text(std::size_t column, std::size_t row, std::string_view text);
+
+    // everything queued since the last call, to be written as one block; empty if nothing changed. Terminals that
+    // know synchronized output show it all at once.
+    auto output() -> std::string_view;
+
+private:
+    struct tile_state {
+        tile area;
+        // packed as in make_cell, row by row
+        std::vector<std::uint32_t> cells;
+        std::array<chip8::plane_t, chip8::PLANE_COUNT> fb{};
+        bool hires{};
+        bool drawn{};
+        std::string caption;
+        bool highlight{};
+    };
+
+    glyphs style;
+    std::vector<tile_state> tiles;
+    // the cells of the row being drawn and the caption being set, kept so refreshing allocates nothing
+    std::vector<std::uint32_t> row_cells;
+    std::string line;
+    std::string pending;
+    bool open{};
+    bool clear{true};
+
+    // starts a block of output if none is open and returns it
+    auto begin() -> std::string &;
+
+    // the cell at column x and row y of a tile showing fb
+    [[nodiscard]] auto cell_at(const tile &area, std::span<const chip8::plane_t> fb, bool hires, std::size_t x,
+                               std::size_t y) const -> std::uint32_t;
+};
@@ -0,0 +1,112 @@
+#include "vector_env.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+vector_env::vector_env(const std::string_view rom, const chip8::alt_t alt_ops, const std::size_t count,
+                       const std::uint64_t cycles_per_frame, const std::size_t threads) :
+    pristine(alt_ops), cycles_per_frame(std::max<std::uint64_t>(1, cycles_per_frame)) {
+    if (count == 0) { throw std::invalid_argument("An environment needs at least one instance!"); }
+    pristine.load_rom(rom);
+    instances.assign(count, pristine);
+    fb.resize(count * chip8::PLANE_COUNT);
+    hires.resize(count);
+    done.resize(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        instances[i].set_trace_id(static_cast<std::uint32_t>(i));
+        observe(i);
+    }
+
+    chunks = std::clamp<std::size_t>(threads, 1, count);
+    for (std::size_t chunk = 1; chunk < chunks; ++chunk) {
+        workers.emplace_back([this, chunk](const std::stop_token &stop) { work(stop, chunk); });
+    }
+}
+
+vector_env::~vector_env() {
+    for (auto &worker: workers) { worker.request_stop(); }
+    generation.fetch_add(1, std::memory_order_release);
+    generation.notify_all();
+}
+
+auto vector_env::reset(const std::span<const std::uint32_t> seeds) -> observation {
+    if (seeds.size() != instances.size()) { throw std::invalid_argument("Expected one seed per instance!"); }
+    this->seeds = seeds;
+    dispatch(&vector_env::reset_range);
+    return view();
+}
+
+auto vector_env::step(const std::span<const std::uint16_t> actions, const std::uint64_t frames) -> observation {
+    if (actions.size() != instances.size()) { throw std::invalid_argument("Expected one action per instance!"); }
+    this->actions = actions;
+    this->frames = frames;
+    dispatch(&vector_env::step_range);
+    return view();
+}
+
+void vector_env::dispatch(const task_t next) {
+    task = next;
+    busy.store(chunks - 1, std::memory_order_relaxed);
+    generation.fetch_add(1, std::memory_order_release);
+    generation.notify_all();
+    run_chunk(0);
+    for (auto left = busy.load(std::memory_order_acquire); left != 0; left = busy.load(std::memory_order_acquire)) {
+        busy.wait(left, std::memory_order_acquire);
+    }
+}
+
+void vector_env::run_chunk(const std::size_t chunk) {
+    const auto count = instances.size();
+    (this->*task)(count * chunk / chunks, count * (chunk + 1) / chunks);
+}
+
+void vector_env::work(const std::stop_token &stop, const std::size_t chunk) {
+    // workers start before the first dispatch, loading the generation here could miss it
+    std::uint32_t seen{};
+    while (true) {
+        generation.wait(seen, std::memory_order_acquire);
+        seen = generation.load(std::memory_order_acquire);
+        if (stop.stop_requested()) { return; }
+        run_chunk(chunk);
+        if (busy.fetch_sub(1, std::memory_order_acq_rel) == 1) { busy.notify_one(); }
+    }
+}
+
+// copy assignment reuses each instance's memory, so resetting allocates nothing
+void vector_env::reset_range(const std::size_t begin, const std::size_t end) {
+    for (auto i = begin; i < end; ++i) {
+        instances[i] = pristine;
+        instances[i].set_trace_id(static_cast<std::uint32_t>(i));
+        instances[i].seed(seeds[i]);
+        done[i] = 0;
+        observe(i);
+    }
+}
+
+void vector_env::step_range(const std::size_t begin, const std::size_t end) {
+    for (auto i = begin; i < end; ++i) {
+        if (done[i] != 0) { continue; }
+        auto &interpreter = instances[i];
+        for (std::size_t key = 0; key < chip8::KEY_COUNT; ++key) {
+            interpreter.keys[key] = (actions[i] >> key & 1u) != 0;
+        }
+        for (std::uint64_t frame = 0; frame < frames && done[i] == 0; ++frame) {
+            // a key wait ends the batch early, carry on until the frame's cycles are spent
+            for (std::uint64_t cycle = 0; cycle < cycles_per_frame;) {
+                const auto [reason, executed] = interpreter.run_cycles(cycles_per_frame - cycle);
+                cycle += executed;
+                if (reason == chip8::stop_reason::halted) {
+                    done[i] = 1;
+                    break;
+                }
+            }
+            interpreter.decrement_timers();
+        }
+        observe(i);
+    }
+}
+
+void vector_env::observe(const std::size_t i) {
+    std::ranges::copy(instances[i].get_fb(), fb.begin() + static_cast<std::ptrdiff_t>(i * chip8::PLANE_COUNT));
+    hires[i] = instances[i].get_hires() ? 1 : 0;
+}
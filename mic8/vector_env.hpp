@@ -0,0 +1,80 @@
+#pragma once
+
+#include "chip8.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <stop_token>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+// A batch of instances of one ROM, stepped together for training and search. Every buffer is allocated up front:
+// reset and step only copy into them, and hand back views that stay valid until the next call.
+class vector_env {
+public:
+    struct observation {
+        // PLANE_COUNT planes per instance, instance i starting at fb[i * PLANE_COUNT]
+        std::span<const chip8::plane_t> fb;
+        std::span<const std::uint8_t> hires;
+        // set once an instance halts, it stays frozen until the next reset
+        std::span<const std::uint8_t> done;
+    };
+
+    vector_env(std::string_view rom, chip8::alt_t alt_ops, std::size_t count, std::uint64_t cycles_per_frame,
+               std::size_t threads = std::thread::hardware_concurrency());
+
+    ~vector_env();
+
+    vector_env(const vector_env &) = delete;
+
+    auto operator=(const vector_env &) -> vector_env & = delete;
+
+    // puts every instance back to power on with its own seed
+    auto reset(std::span<const std::uint32_t> seeds) -> observation;
+
+    // holds down the keys in each instance's mask (bit n for key n) and runs frames 60 Hz frames
+    auto step(std::span<const std::uint16_t> actions, std::uint64_t frames) -> observation;
+
+    [[nodiscard]] auto size() const -> std::size_t { return instances.size(); }
+
+    [[nodiscard]] auto get_cycles_per_frame() const -> std::uint64_t { return cycles_per_frame; }
+
+private:
+    using task_t = void (vector_env::*)(std::size_t begin, std::size_t end);
+
+    chip8 pristine;
+    std::uint64_t cycles_per_frame;
+    std::vector<chip8> instances;
+    std::vector<chip8::plane_t> fb;
+    std::vector<std::uint8_t> hires;
+    std::vector<std::uint8_t> done;
+
+    // arguments of the task being run, read by the workers
+    task_t task{};
+    std::span<const std::uint32_t> seeds;
+    std::span<const std::uint16_t> actions;
+    std::uint64_t frames{};
+
+    // the calling thread takes the first chunk, each worker one of the rest
+    std::size_t chunks{1};
+    std::atomic<std::uint32_t> generation{};
+    std::atomic<std::size_t> busy{};
+    std::vector<std::jthread> workers;
+
+    void dispatch(task_t next);
+
+    void run_chunk(std::size_t chunk);
+
+    void work(const std::stop_token &stop, std::size_t chunk);
+
+    void reset_range(std::size_t begin, std::size_t end);
+
+    void step_range(std::size_t begin, std::size_t end);
+
+    void observe(std::size_t i);
+
+    [[nodiscard]] auto view() const -> observation { return {fb, hires, done}; }
+};
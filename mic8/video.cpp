@@ -0,0 +1,410 @@
+#include "video.hpp"
+#include "chip8.hpp"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <filesystem>
+#include <ios>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace {
+    constexpr std::uint64_t max_delay = 0xFFFF;
+    // shorter GIF delays are played as 10 cs by browsers and most viewers, two 60 Hz ticks always last longer
+    constexpr std::uint64_t min_delay = 2;
+
+    // GIF delays are in hundredths of a second, this is the time at the start of tick f, rounded
+    constexpr auto to_cs(const std::uint64_t f) -> std::uint64_t {
+        return (f * 100 + video_sink::FRAME_RATE / 2) / video_sink::FRAME_RATE;
+    }
+
+    // BT.601 studio swing luma of each palette entry
+    constexpr auto luma = [] {
+        std::array<std::uint8_t, video_sink::PALETTE.size()> y{};
+        for (std::size_t i = 0; i < y.size(); ++i) {
+            y[i] = static_cast<std::uint8_t>(16 + (video_sink::PALETTE[i] & 0xFFu) * 219 / 255);
+        }
+        return y;
+    }();
+
+    constexpr auto crc_table = [] {
+        std::array<std::uint32_t, 256> table{};
+        for (std::uint32_t n = 0; n < table.size(); ++n) {
+            std::uint32_t c = n;
+            for (int k = 0; k < 8; ++k) { c = (c & 1u) != 0 ? 0xEDB8'8320 ^ c >> 1u : c >> 1u; }
+            table[n] = c;
+        }
+        return table;
+    }();
+
+    auto crc32(const std::span<const std::uint8_t> bytes, std::uint32_t crc = 0xFFFF'FFFF) -> std::uint32_t {
+        for (const auto byte: bytes) { crc = crc_table[(crc ^ byte) & 0xFFu] ^ crc >> 8u; }
+        return crc;
+    }
+
+    void put_le16(std::vector<std::uint8_t> &out, const std::uint64_t value) {
+        out.push_back(static_cast<std::uint8_t>(value & 0xFF));
+        out.push_back(static_cast<std::uint8_t>(value >> 8u & 0xFF));
+    }
+
+    void put_be16(std::vector<std::uint8_t> &out, const std::uint64_t value) {
+        out.push_back(static_cast<std::uint8_t>(value >> 8u & 0xFF));
+        out.push_back(static_cast<std::uint8_t>(value & 0xFF));
+    }
+
+    void put_be32(std::vector<std::uint8_t> &out, const std::uint64_t value) {
+        put_be16(out, value >> 16u);
+        put_be16(out, value);
+    }
+
+    void write_bytes(std::ofstream &file, const std::span<const std::uint8_t> bytes) {
+        file.write(reinterpret_cast<const char *>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+    }
+
+    void write_chunk(std::ofstream &file, const std::string_view type, const std::span<const std::uint8_t> data) {
+        std::vector<std::uint8_t> header;
+        put_be32(header, data.size());
+        header.insert(header.end(), type.begin(), type.end());
+        write_bytes(file, header);
+        write_bytes(file, data);
+        const auto crc = crc32(data, crc32(std::span(header).subspan(4)));
+        std::vector<std::uint8_t> trailer;
+        put_be32(trailer, crc ^ 0xFFFF'FFFF);
+        write_bytes(file, trailer);
+    }
+
+    // variable width LZW with a 2 bit alphabet, codes are packed least significant bit first
+    auto lzw_encode(const video_sink::pixels_t &pixels) -> std::vector<std::uint8_t> {
+        constexpr unsigned min_code_size = 2;
+        constexpr unsigned clear = 1u << min_code_size;
+        constexpr unsigned end = clear + 1;
+        constexpr unsigned max_codes = 0x1000;
+
+        std::vector<std::array<std::uint16_t, 4>> next(max_codes);
+        std::vector<std::uint8_t> out;
+        std::uint32_t acc = 0;
+        unsigned bits = 0;
+        unsigned code_size = min_code_size + 1;
+        unsigned next_code = end + 1;
+        const auto emit = [&](const unsigned code) {
+            acc |= code << bits;
+            bits += code_size;
+            for (; bits >= 8; bits -= 8, acc >>= 8u) { out.push_back(static_cast<std::uint8_t>(acc & 0xFF)); }
+        };
+
+        emit(clear);
+        unsigned prefix = pixels[0];
+        for (std::size_t i = 1; i < pixels.size(); ++i) {
+            const auto c = pixels[i];
+            if (next[prefix][c] != 0) {
+                prefix = next[prefix][c];
+                continue;
+            }
+            emit(prefix);
+            if (next_code < max_codes) {
+                if (next_code == 1u << code_size) { ++code_size; }
+                next[prefix][c] = static_cast<std::uint16_t>(next_code++);
+            } else {
+                emit(clear);
+                std::ranges::fill(next, std::array<std::uint16_t, 4>{});
+                code_size = min_code_size + 1;
+                next_code = end + 1;
+            }
+            prefix = c;
+        }
+        emit(prefix);
+        emit(end);
+        if (bits > 0) { out.push_back(static_cast<std::uint8_t>(acc & 0xFF)); }
+        return out;
+    }
+
+    // a zlib stream of one stored block, the frames are too small for deflate to be worth a dependency
+    auto zlib_stored(const std::span<const std::uint8_t> data) -> std::vector<std::uint8_t> {
+        std::vector<std::uint8_t> out{0x78, 0x01, 0x01};
+        put_le16(out, data.size());
+        put_le16(out, ~data.size() & 0xFFFF);
+        out.insert(out.end(), data.begin(), data.end());
+        std::uint32_t a = 1;
+        std::uint32_t b = 0;
+        for (const auto byte: data) {
+            a = (a + byte) % 65521;
+            b = (b + a) % 65521;
+        }
+        put_be32(out, b << 16u | a);
+        return out;
+    }
+
+    // 2 bit palette rows, each behind a filter type byte of 0
+    auto png_rows(const video_sink::pixels_t &pixels) -> std::vector<std::uint8_t> {
+        constexpr std::size_t row_bytes = video_sink::WIDTH / 4;
+        std::vector<std::uint8_t> rows((row_bytes + 1) * video_sink::HEIGHT);
+        for (std::size_t y = 0; y < video_sink::HEIGHT; ++y) {
+            auto *row = &rows[y * (row_bytes + 1) + 1];
+            for (std::size_t x = 0; x < video_sink::WIDTH; ++x) {
+                row[x / 4] |= static_cast<std::uint8_t>(pixels[y * video_sink::WIDTH + x] << (6 - x % 4 * 2));
+            }
+        }
+        return rows;
+    }
+
+    auto open(const std::string_view path) -> std::ofstream {
+        std::ofstream file(path.data(), std::ios::binary);
+        if (!file) {
+            throw std::invalid_argument("Failed to open the video file!");
+        }
+        return file;
+    }
+}
+
+y4m_sink::y4m_sink(const std::string_view path) : file(open(path)) {
+    file << "YUV4MPEG2 W" << WIDTH << " H" << HEIGHT << " F" << FRAME_RATE << ":1 Ip A1:1 Cmono\n";
+}
+
+void y4m_sink::write(const pixels_t &pixels, const std::uint64_t duration) {
+    pixels_t y{};
+    std::ranges::transform(pixels, y.begin(), [](const auto index) { return luma[index]; });
+    for (std::uint64_t i = 0; i < duration; ++i) {
+        file << "FRAME\n";
+        write_bytes(file, y);
+    }
+}
+
+gif_sink::gif_sink(const std::string_view path) : file(open(path)) {
+    std::vector<std::uint8_t> header{'G', 'I', 'F', '8', '9', 'a'};
+    put_le16(header, WIDTH);
+    put_le16(header, HEIGHT);
+    // global colour table of 4 entries, 8 bit colour resolution
+    header.insert(header.end(), {0xF1, 0x00, 0x00});
+    for (const auto color: PALETTE) {
+        header.insert(header.end(), {
+                          static_cast<std::uint8_t>(color >> 16u), static_cast<std::uint8_t>(color >> 8u & 0xFF),
+                          static_cast<std::uint8_t>(color & 0xFF)
+                      });
+    }
+    // loop forever
+    header.insert(header.end(), {0x21, 0xFF, 0x0B});
+    header.insert(header.end(), {'N', 'E', 'T', 'S', 'C', 'A', 'P', 'E', '2', '.', '0'});
+    header.insert(header.end(), {0x03, 0x01, 0x00, 0x00, 0x00});
+    write_bytes(file, header);
+}
+
+gif_sink::~gif_sink() {
+    // a recording with no ticks still has to be a valid image
+    if (frames == 0 && held_ticks == 0) { held_ticks = 1; }
+    // the last frame is padded by a tick rather than left too short
+    if (held_ticks == 1) { ++held_ticks; }
+    if (held_ticks > 0) { put_frame(held, held_ticks); }
+    file.put(0x3B);
+}
+
+void gif_sink::write(const pixels_t &pixels, const std::uint64_t duration) {
+    // viewers play a delay under 2 cs as 10 cs, so at 60 Hz ticks are merged in pairs or more and the frame shows
+    // the latest screen among them, at most 30 frames a second
+    static_assert(200 / FRAME_RATE >= min_delay);
+    if (held_ticks >= 2) {
+        put_frame(held, held_ticks);
+        held_ticks = 0;
+    }
+    held = pixels;
+    held_ticks += duration;
+}
+
+void gif_sink::put_frame(const pixels_t &pixels, const std::uint64_t duration) {
+    const auto data = lzw_encode(pixels);
+    // rounding is carried over so the total stays in sync
+    const auto end = frames + duration;
+    auto delay = to_cs(end) - to_cs(frames);
+    frames = end;
+    while (delay > 0) {
+        const auto part = std::min(delay, max_delay);
+        delay -= part;
+        std::vector<std::uint8_t> out{0x21, 0xF9, 0x04, 0x04};
+        put_le16(out, part);
+        out.insert(out.end(), {0x00, 0x00, 0x2C, 0x00, 0x00, 0x00, 0x00});
+        put_le16(out, WIDTH);
+        put_le16(out, HEIGHT);
+        out.insert(out.end(), {0x00, 0x02});
+        for (std::size_t i = 0; i < data.size(); i += 0xFF) {
+            const auto n = std::min<std::size_t>(0xFF, data.size() - i);
+            out.push_back(static_cast<std::uint8_t>(n));
+            out.insert(out.end(), data.begin() + static_cast<std::ptrdiff_t>(i),
+                       data.begin() + static_cast<std::ptrdiff_t>(i + n));
+        }
+        out.push_back(0x00);
+        write_bytes(file, out);
+    }
+}
+
+apng_sink::apng_sink(const std::string_view path) : file(open(path)) {
+    write_bytes(file, std::array<std::uint8_t, 8>{0x89, 'P', 'N', 'G', 0x0D, 0x0A, 0x1A, 0x0A});
+    std::vector<std::uint8_t> ihdr;
+    put_be32(ihdr, WIDTH);
+    put_be32(ihdr, HEIGHT);
+    // bit depth 2, indexed colour
+    ihdr.insert(ihdr.end(), {0x02, 0x03, 0x00, 0x00, 0x00});
+    write_chunk(file, "IHDR", ihdr);
+    // the frame count is patched in by the destructor
+    actl_pos = file.tellp();
+    write_chunk(file, "acTL", std::array<std::uint8_t, 8>{});
+    std::vector<std::uint8_t> plte;
+    for (const auto color: PALETTE) {
+        plte.insert(plte.end(), {
+                        static_cast<std::uint8_t>(color >> 16u), static_cast<std::uint8_t>(color >> 8u & 0xFF),
+                        static_cast<std::uint8_t>(color & 0xFF)
+                    });
+    }
+    write_chunk(file, "PLTE", plte);
+}
+
+apng_sink::~apng_sink() {
+    if (frame_count == 0) { write({}, 1); }
+    write_chunk(file, "IEND", {});
+    file.seekp(actl_pos);
+    std::vector<std::uint8_t> actl;
+    put_be32(actl, frame_count);
+    put_be32(actl, 0);
+    write_chunk(file, "acTL", actl);
+}
+
+void apng_sink::write(const pixels_t &pixels, std::uint64_t duration) {
+    const auto data = zlib_stored(png_rows(pixels));
+    while (duration > 0) {
+        const auto part = std::min(duration, max_delay);
+        duration -= part;
+        std::vector<std::uint8_t> fctl;
+        put_be32(fctl, sequence++);
+        put_be32(fctl, WIDTH);
+        put_be32(fctl, HEIGHT);
+        put_be32(fctl, 0);
+        put_be32(fctl, 0);
+        put_be16(fctl, part);
+        put_be16(fctl, FRAME_RATE);
+        fctl.insert(fctl.end(), {0x00, 0x00});
+        write_chunk(file, "fcTL", fctl);
+        if (frame_count++ == 0) {
+            write_chunk(file, "IDAT", data);
+        } else {
+            std::vector<std::uint8_t> fdat;
+            put_be32(fdat, sequence++);
+            fdat.insert(fdat.end(), data.begin(), data.end());
+            write_chunk(file, "fdAT", fdat);
+        }
+    }
+}
+
+auto make_video_sink(const std::string_view path) -> std::unique_ptr<video_sink> {
+    const auto ext = std::filesystem::path(path).extension();
+    if (ext == ".y4m") { return std::make_unique<y4m_sink>(path); }
+    if (ext == ".gif") { return std::make_unique<gif_sink>(path); }
+    if (ext == ".png" || ext == ".apng") { return std::make_unique<apng_sink>(path); }
+    throw std::invalid_argument("Unknown video format, use .y4m, .gif or .png!");
+}
+
+void video_recorder::capture(const chip8 &interpreter) {
+    const auto index = frame_index.load(std::memory_order_relaxed);
+    frame_index.store(index + 1, std::memory_order_relaxed);
+    const auto fb = interpreter.get_fb();
+    const auto hires = interpreter.get_hires();
+    if (captured && hires == last_hires && std::ranges::equal(fb, last_fb)) { return; }
+    const auto fill = [&](frame &f) {
+        std::ranges::copy(fb, f.fb.begin());
+        f.index = index;
+        f.hires = hires;
+    };
+    while (!queue.produce(fill)) {
+        if (!lossless) {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        std::this_thread::yield();
+    }
+    std::ranges::copy(fb, last_fb.begin());
+    last_hires = hires;
+    captured = true;
+}
+
+void video_recorder::close() { closed.store(true, std::memory_order_release); }
+
+auto video_recorder::drain() -> bool {
+    // checked first, everything captured before close() is in the queue by the time it is seen
+    const bool was_closed = closed.load(std::memory_order_acquire);
+    bool busy = false;
+    while (queue.consume([&](const frame &f) {
+        if (has_pending) { sink->write(pending, f.index - pending_index); }
+        const std::size_t scale = f.hires ? 1 : 2;
+        for (std::size_t y = 0; y < video_sink::HEIGHT; ++y) {
+            const std::size_t row = y / scale;
+            for (std::size_t x = 0; x < video_sink::WIDTH; ++x) {
+                const std::size_t col = x / scale;
+                const std::size_t word = row * chip8::ROW_WORDS + col / 64;
+                const std::size_t bit = 63 - col % 64;
+                pending[x + y * video_sink::WIDTH] =
+                        static_cast<std::uint8_t>((f.fb[0][word] >> bit & 1u) | (f.fb[1][word] >> bit & 1u) << 1u);
+            }
+        }
+        pending_index = f.index;
+        has_pending = true;
+    })) {
+        busy = true;
+    }
+    if (was_closed) { finish(); }
+    return busy;
+}
+
+void video_recorder::finish() {
+    if (finished) { return; }
+    if (has_pending) {
+        sink->write(pending, std::max<std::uint64_t>(1, frame_index.load(std::memory_order_relaxed) - pending_index));
+    }
+    sink.reset();
+    finished = true;
+}
+
+video_encoder::video_encoder() : worker([this](const std::stop_token &stop) { encode(stop); }) {}
+
+video_encoder::~video_encoder() {
+    worker.request_stop();
+    worker.join();
+    // whatever is still recording at exit is written out as it stands
+    for (const auto &recorder: recorders) {
+        recorder->drain();
+        recorder->finish();
+    }
+}
+
+auto video_encoder::global() -> video_encoder & {
+    static video_encoder encoder;
+    return encoder;
+}
+
+void video_encoder::add(const std::shared_ptr<video_recorder> &recorder) {
+    const std::scoped_lock lock(recorders_mutex);
+    recorders.push_back(recorder);
+}
+
+void video_encoder::flush() {
+    std::unique_lock lock(recorders_mutex);
+    idle.wait(lock, [this] {
+        return std::ranges::none_of(recorders, [](const auto &recorder) {
+            return recorder->closed.load(std::memory_order_acquire);
+        });
+    });
+}
+
+void video_encoder::encode(const std::stop_token &stop) {
+    while (!stop.stop_requested()) {
+        bool busy = false;
+        {
+            const std::scoped_lock lock(recorders_mutex);
+            for (const auto &recorder: recorders) { busy |= recorder->drain(); }
+            std::erase_if(recorders, [](const auto &recorder) { return recorder->finished; });
+        }
+        idle.notify_all();
+        if (!busy) { std::this_thread::sleep_for(std::chrono::milliseconds(5)); }
+    }
+}
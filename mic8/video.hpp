@@ -0,0 +1,155 @@
+#pragma once
+
+#include "chip8.hpp"
+#include "spsc_ring.hpp"
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+class video_sink {
+public:
+    static constexpr std::size_t WIDTH{chip8::HIRES_WIDTH};
+    static constexpr std::size_t HEIGHT{chip8::HIRES_HEIGHT};
+    static constexpr std::size_t FRAME_RATE{60};
+
+    // one palette index per pixel, lores frames are doubled
+    using pixels_t = std::array<std::uint8_t, WIDTH * HEIGHT>;
+
+    static constexpr std::array<std::uint32_t, 4> PALETTE{0x00'0000, 0xFF'FFFF, 0xAA'AAAA, 0x55'5555};
+
+    virtual ~video_sink() = default;
+
+    // the frame stays on screen for duration 60 Hz frames
+    virtual void write(const pixels_t &pixels, std::uint64_t duration) = 0;
+};
+
+class y4m_sink : public video_sink {
+public:
+    explicit y4m_sink(std::string_view path);
+
+    void write(const pixels_t &pixels, std::uint64_t duration) override;
+
+private:
+    std::ofstream file;
+};
+
+class gif_sink : public video_sink {
+public:
+    explicit gif_sink(std::string_view path);
+
+    ~gif_sink() override;
+
+    void write(const pixels_t &pixels, std::uint64_t duration) override;
+
+private:
+    std::ofstream file;
+    // ticks written to the file so far
+    std::uint64_t frames{};
+    // the latest screen and the ticks not written yet, held until they last long enough for viewers to honour the delay
+    pixels_t held{};
+    std::uint64_t held_ticks{};
+
+    void put_frame(const pixels_t &pixels, std::uint64_t duration);
+};
+
+class apng_sink : public video_sink {
+public:
+    explicit apng_sink(std::string_view path);
+
+    ~apng_sink() override;
+
+    void write(const pixels_t &pixels, std::uint64_t duration) override;
+
+private:
+    std::ofstream file;
+    std::streampos actl_pos;
+    std::uint32_t sequence{};
+    std::uint32_t frame_count{};
+};
+
+// picks the format from the extension: .y4m, .gif or .png/.apng
+auto make_video_sink(std::string_view path) -> std::unique_ptr<video_sink>;
+
+class video_recorder {
+public:
+    static constexpr std::size_t QUEUE_FRAMES{64};
+
+    // a lossless recorder waits for the encoder instead of dropping frames, for offline export
+    explicit video_recorder(std::unique_ptr<video_sink> sink, const bool lossless = false) : sink(std::move(sink)),
+        lossless(lossless) {}
+
+    // called by the emulation side once per 60 Hz tick. Unchanged frames only advance the clock. Unless lossless, it
+    // never blocks: a change that finds the queue full is retried on the next tick.
+    void capture(const chip8 &interpreter);
+
+    // no captures may follow, the encoder writes out what is queued and closes the file
+    void close();
+
+    [[nodiscard]] auto get_frames() const -> std::uint64_t { return frame_index.load(std::memory_order_relaxed); }
+
+    [[nodiscard]] auto get_dropped() const -> std::uint64_t { return dropped.load(std::memory_order_relaxed); }
+
+private:
+    friend class video_encoder;
+
+    struct frame {
+        std::array<chip8::plane_t, chip8::PLANE_COUNT> fb;
+        std::uint64_t index;
+        bool hires;
+    };
+
+    spsc_ring<frame, QUEUE_FRAMES> queue;
+    std::unique_ptr<video_sink> sink;
+    bool lossless;
+
+    // emulation side
+    std::array<chip8::plane_t, chip8::PLANE_COUNT> last_fb{};
+    bool last_hires{};
+    bool captured{};
+    std::atomic<std::uint64_t> frame_index{};
+    std::atomic<std::uint64_t> dropped{};
+    std::atomic<bool> closed{};
+
+    // encoder side, a frame is written once the next change tells how long it lasted
+    video_sink::pixels_t pending{};
+    std::uint64_t pending_index{};
+    bool has_pending{};
+    bool finished{};
+
+    auto drain() -> bool;
+
+    void finish();
+};
+
+// one thread encodes for every recorder, so recording many instances costs no extra threads
+class video_encoder {
+public:
+    video_encoder();
+
+    ~video_encoder();
+
+    static auto global() -> video_encoder &;
+
+    void add(const std::shared_ptr<video_recorder> &recorder);
+
+    // blocks until every closed recorder has been written out
+    void flush();
+
+private:
+    std::mutex recorders_mutex;
+    std::condition_variable idle;
+    std::vector<std::shared_ptr<video_recorder>> recorders;
+    std::jthread worker;
+
+    void encode(const std::stop_token &stop);
+};
@@ -0,0 +1,86 @@
+#include "chip8.hpp"
+
+#include <emscripten/emscripten.h>
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+
+// C interface for mic8_core.js, driven from core_worker.js. The module is built with a shared memory, so the
+// renderer on the main thread reads pixels straight out of the heap while the worker keeps emulating.
+namespace {
+    std::unique_ptr<chip8> interpreter;
+    // one 2-bit colour index per pixel, lores frames are doubled to 128x64
+    std::array<std::uint8_t, chip8::HIRES_WIDTH * chip8::HIRES_HEIGHT> pixels{};
+    // seqlock over pixels, as in shared_frame: odd while the worker rewrites them. The renderer copies the pixels
+    // between two loads and keeps the copy only if both saw the same even count, which it then skips until it moves.
+    std::atomic<std::uint32_t> frame_count{};
+    std::uint64_t cycles_run{};
+
+    void convert_fb() {
+        const auto sequence = frame_count.load(std::memory_order_relaxed);
+        frame_count.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        const std::size_t scale = interpreter->get_hires() ? 1 : 2;
+        const auto fb = interpreter->get_fb();
+        for (std::size_t y = 0; y < chip8::HIRES_HEIGHT; ++y) {
+            const std::size_t row = y / scale;
+            for (std::size_t x = 0; x < chip8::HIRES_WIDTH; ++x) {
+                const std::size_t col = x / scale;
+                const std::size_t word = row * chip8::ROW_WORDS + col / 64;
+                const std::size_t bit = 63 - col % 64;
+                pixels[x + y * chip8::HIRES_WIDTH] =
+                        static_cast<std::uint8_t>((fb[0][word] >> bit & 1u) | (fb[1][word] >> bit & 1u) << 1u);
+            }
+        }
+
+        frame_count.store(sequence + 2, std::memory_order_release);
+    }
+}
+
+extern "C" {
+EMSCRIPTEN_KEEPALIVE void mic8_create(const int variant, const std::uint32_t seed) {
+    chip8::alt_t alt_ops;
+    alt_ops.variant = static_cast<chip8::variant>(variant);
+    interpreter = std::make_unique<chip8>(alt_ops);
+    interpreter->seed(seed);
+    cycles_run = 0;
+    convert_fb();
+}
+
+// the ROM is written into MEMFS by the worker first
+EMSCRIPTEN_KEEPALIVE auto mic8_load(const char *path) -> int {
+    try {
+        interpreter->load_rom(path);
+    } catch (const std::invalid_argument &) {
+        return -1;
+    }
+    return 0;
+}
+
+EMSCRIPTEN_KEEPALIVE void mic8_set_key(const int key, const int down) {
+    interpreter->keys[static_cast<std::size_t>(key) % chip8::KEY_COUNT] = down != 0;
+}
+
+// runs one 60 Hz frame and returns the chip8::stop_reason that ended it
+EMSCRIPTEN_KEEPALIVE auto mic8_run_frame(const std::uint32_t cycles_per_frame) -> int {
+    const auto result = interpreter->run_cycles(cycles_per_frame);
+    cycles_run += result.cycles;
+    interpreter->decrement_timers();
+    if (interpreter->drw_flag) {
+        convert_fb();
+        interpreter->drw_flag = false;
+    }
+    return static_cast<int>(result.reason);
+}
+
+EMSCRIPTEN_KEEPALIVE auto mic8_pixels() -> std::uint8_t * { return pixels.data(); }
+
+EMSCRIPTEN_KEEPALIVE auto mic8_frame_count() -> std::atomic<std::uint32_t> * { return &frame_count; }
+
+EMSCRIPTEN_KEEPALIVE auto mic8_cycles() -> double { return static_cast<double>(cycles_run); }
+}